@@ -0,0 +1,62 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+
+// Sorted set of the active indices into one of the engine's entity arrays,
+// kept up to date by the create and delete hooks, by the Lua API which calls
+// the originals directly or sets isActive, and by memory.write* into the
+// arrays, so that counting and iterating entities doesn't have to scan the
+// whole array.
+class ActiveSet {
+	std::vector<int> indices;
+	std::vector<bool> members;
+
+ public:
+	ActiveSet(int capacity) : members(capacity) { indices.reserve(capacity); }
+
+	void insert(int index) {
+		if (members[index]) return;
+		members[index] = true;
+		indices.insert(std::lower_bound(indices.begin(), indices.end(), index),
+		               index);
+	}
+
+	void erase(int index) {
+		if (!members[index]) return;
+		members[index] = false;
+		indices.erase(std::lower_bound(indices.begin(), indices.end(), index));
+	}
+
+	// Drops indices which were deactivated without going through a hook,
+	// e.g. by Lua or by the engine deleting a rigid body with its owner.
+	template <typename IsActive>
+	void prune(IsActive isActive) {
+		auto end = std::remove_if(indices.begin(), indices.end(), [&](int index) {
+			if (isActive(index)) return false;
+			members[index] = false;
+			return true;
+		});
+		indices.erase(end, indices.end());
+	}
+
+	// Rescans the whole array, used after the game resets.
+	template <typename IsActive>
+	void rebuild(IsActive isActive) {
+		indices.clear();
+		for (int index = 0; index < (int)members.size(); index++) {
+			members[index] = isActive(index);
+			if (members[index]) indices.push_back(index);
+		}
+	}
+
+	// The first index in the set which is not less than the given one, or -1.
+	int lowerBound(int index) const {
+		auto it = std::lower_bound(indices.begin(), indices.end(), index);
+		return it == indices.end() ? -1 : *it;
+	}
+
+	bool contains(int index) const { return members[index]; }
+	size_t size() const { return indices.size(); }
+	std::vector<int>::const_iterator begin() const { return indices.begin(); }
+	std::vector<int>::const_iterator end() const { return indices.end(); }
+};
@@ -4,8 +4,10 @@
 #include <chrono>
 #include <filesystem>
 #include <limits>
+#include <unordered_map>
 
 #include "console.h"
+#include "worldsnapshot.h"
 
 bool initialized = false;
 bool shouldReset = false;
@@ -20,11 +22,49 @@ sol::table* itemDataTables[maxNumberOfItems] = {0};
 sol::table* vehicleDataTables[maxNumberOfVehicles] = {0};
 sol::table* bodyDataTables[maxNumberOfRigidBodies] = {0};
 
+ActiveSet activeHumans(maxNumberOfHumans);
+ActiveSet activeItems(maxNumberOfItems);
+ActiveSet activeVehicles(maxNumberOfVehicles);
+ActiveSet activeBodies(maxNumberOfRigidBodies);
+
+SpatialHash spatialHash(16);
+WorldDelta worldDelta(600);
+
+bool accountLookupsEnabled = false;
+static LookupIndex<int> accountPhoneLookup;
+static LookupIndex<long long> accountSteamIDLookup;
+static LookupIndex<std::string> accountNameLookup;
+
 std::mutex stateResetMutex;
 
 static constexpr const char* errorOutOfRange = "Index out of range";
 static constexpr const char* missingArgument = "Missing argument";
 
+template <typename T, typename Predicate>
+static T* nextInArray(T* array, int count, const T* previous,
+                      Predicate matches) {
+	for (int i = previous ? previous->getIndex() + 1 : 0; i < count; i++) {
+		if (matches(array[i])) return &array[i];
+	}
+	return nullptr;
+}
+
+template <typename T, typename Predicate>
+static T* nextInSet(const ActiveSet& set, T* array, const T* previous,
+                    Predicate matches) {
+	int i = previous ? previous->getIndex() + 1 : 0;
+	while ((i = set.lowerBound(i)) != -1) {
+		if (array[i].active && matches(array[i])) return &array[i];
+		i++;
+	}
+	return nullptr;
+}
+
+template <typename T>
+static EntityIterator<T> iterate(T* (*next)(sol::object, T*)) {
+	return {sol::as_function(next), sol::nil, sol::nil};
+}
+
 void printLuaError(sol::error* err) {
 	std::ostringstream stream;
 
@@ -51,27 +91,128 @@ bool noLuaCallError(sol::load_result* res) {
 
 void hookAndReset(int reason) {
 	if (Hooks::enabledKeys[Hooks::EnableKeys::ResetGame]) {
-		bool noParent = false;
-		if (Hooks::run != sol::nil) {
-			auto res = Hooks::run("ResetGame", reason);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent =
+		    Hooks::runPre(Hooks::EnableKeys::ResetGame, "ResetGame", reason);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&Hooks::resetGameHook);
-				Engine::resetGame();
-			}
-			if (Hooks::run != sol::nil) {
-				auto res = Hooks::run("PostResetGame", reason);
-				noLuaCallError(&res);
-			}
+			Hooks::resetGameHook.callOriginal(Engine::resetGame);
+			rebuildActiveSets();
+			invalidateTypeNames();
+			Hooks::runPost(Hooks::EnableKeys::ResetGame, "PostResetGame", reason);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&Hooks::resetGameHook);
-		Engine::resetGame();
+		Hooks::resetGameHook.callOriginal(Engine::resetGame);
+		rebuildActiveSets();
+		invalidateTypeNames();
+	}
+}
+
+void invalidateAccountLookups() {
+	accountPhoneLookup.invalidate();
+	accountSteamIDLookup.invalidate();
+	accountNameLookup.invalidate();
+}
+
+static NameIndex itemTypeNames;
+static NameIndex vehicleTypeNames;
+
+void invalidateTypeNames() {
+	itemTypeNames.invalidate();
+	vehicleTypeNames.invalidate();
+}
+
+template <typename T>
+static const NameIndex& getTypeNames(NameIndex& index, T* array, int count) {
+	if (index.isStale())
+		index.rebuild(count, [array](int i) { return array[i].name; });
+	return index;
+}
+
+void rebuildActiveSets() {
+	activeHumans.rebuild([](int i) { return Engine::humans[i].active; });
+	activeItems.rebuild([](int i) { return Engine::items[i].active; });
+	activeVehicles.rebuild([](int i) { return Engine::vehicles[i].active; });
+	activeBodies.rebuild([](int i) { return Engine::bodies[i].active; });
+
+	if (spatialHash.enabled) updateSpatialHash();
+}
+
+static ActiveSet& getActiveSet(SpatialHash::Kind kind) {
+	switch (kind) {
+		case SpatialHash::Humans:
+			return activeHumans;
+		case SpatialHash::Vehicles:
+			return activeVehicles;
+		case SpatialHash::Items:
+			return activeItems;
+		default:
+			return activeBodies;
+	}
+}
+
+static bool isEntityActive(SpatialHash::Kind kind, int index) {
+	switch (kind) {
+		case SpatialHash::Humans:
+			return Engine::humans[index].active;
+		case SpatialHash::Vehicles:
+			return Engine::vehicles[index].active;
+		case SpatialHash::Items:
+			return Engine::items[index].active;
+		default:
+			return Engine::bodies[index].active;
+	}
+}
+
+static const Vector& getEntityPos(SpatialHash::Kind kind, int index) {
+	switch (kind) {
+		case SpatialHash::Humans:
+			return Engine::humans[index].pos;
+		case SpatialHash::Vehicles:
+			return Engine::vehicles[index].pos;
+		case SpatialHash::Items:
+			return Engine::items[index].pos;
+		default:
+			return Engine::bodies[index].pos;
 	}
 }
 
+void trackCreated(SpatialHash::Kind kind, int index) {
+	getActiveSet(kind).insert(index);
+	if (spatialHash.enabled)
+		spatialHash.set(kind, index, getEntityPos(kind, index));
+}
+
+void trackDeleted(SpatialHash::Kind kind, int index) {
+	getActiveSet(kind).erase(index);
+	if (spatialHash.enabled) spatialHash.remove(kind, index);
+}
+
+template <typename T>
+static void updateSpatialHashKind(SpatialHash::Kind kind, ActiveSet& set,
+                                  T* array) {
+	set.prune([array](int i) { return array[i].active; });
+	spatialHash.removeMissing(kind, set);
+	for (int i : set) spatialHash.set(kind, i, array[i].pos);
+}
+
+void updateSpatialHash() {
+	updateSpatialHashKind(SpatialHash::Humans, activeHumans, Engine::humans);
+	updateSpatialHashKind(SpatialHash::Vehicles, activeVehicles,
+	                      Engine::vehicles);
+	updateSpatialHashKind(SpatialHash::Items, activeItems, Engine::items);
+	updateSpatialHashKind(SpatialHash::RigidBodies, activeBodies,
+	                      Engine::bodies);
+}
+
+// Copies into a Vector already at table[key] if there is one, so that tables
+// which are reused don't allocate a new Vector every time.
+void setTableVector(sol::table& table, const char* key, const Vector& vector) {
+	sol::object field = table[key];
+	if (field.get_type() == sol::type::userdata && field.is<Vector>())
+		field.as<Vector&>() = vector;
+	else
+		table[key] = vector;
+}
+
 namespace Lua {
 void print(sol::variadic_args args, sol::this_state s) {
 	sol::state_view lua(s);
@@ -119,60 +260,180 @@ RotMatrix RotMatrix_(float x1, float y1, float z1, float x2, float y2, float z2,
 	return RotMatrix{x1, y1, z1, x2, y2, z2, x3, y3, z3};
 }
 
+static sol::table createHTTPResponseTable(sol::state_view& lua, int status,
+                                          const std::string& body,
+                                          const httplib::Headers& headers) {
+	sol::table table = lua.create_table();
+	table["status"] = status;
+	table["body"] = body;
+
+	sol::table headersTable = lua.create_table();
+	for (const auto& h : headers) headersTable[h.first] = h.second;
+	table["headers"] = headersTable;
+
+	return table;
+}
+
 static sol::object handleSyncHTTPResponse(httplib::Result& res,
                                           sol::this_state s) {
 	sol::state_view lua(s);
 
 	if (res) {
-		sol::table table = lua.create_table();
-		table["status"] = res->status;
-		table["body"] = res->body;
-
-		sol::table headers = lua.create_table();
-		for (const auto& h : res->headers) headers[h.first] = h.second;
-		table["headers"] = headers;
-
+		auto table =
+		    createHTTPResponseTable(lua, res->status, res->body, res->headers);
 		return sol::make_object(lua, table);
 	}
 
 	return sol::make_object(lua, sol::nil);
 }
 
+static HTTPClientPool httpClientPool(16, 30);
+
+static std::unique_ptr<httplib::Client> acquireSyncHTTPClient(
+    const char* scheme) {
+	auto client = httpClientPool.acquire(scheme);
+	// The async requests may have left their own timeouts on it
+	client->set_connection_timeout(6);
+	client->set_read_timeout(CPPHTTPLIB_READ_TIMEOUT_SECOND);
+	client->set_write_timeout(CPPHTTPLIB_WRITE_TIMEOUT_SECOND);
+	return client;
+}
+
 sol::object http::getSync(const char* scheme, const char* path,
                           sol::table headers, sol::this_state s) {
-	httplib::Client client(scheme);
-	client.set_connection_timeout(6);
-	client.set_keep_alive(false);
+	auto client = acquireSyncHTTPClient(scheme);
 
 	httplib::Headers httpHeaders;
 	for (const auto& pair : headers)
 		httpHeaders.emplace(pair.first.as<std::string>(),
 		                    pair.second.as<std::string>());
 
-	httpHeaders.emplace("Connection", "close");
-
-	auto res = client.Get(path, httpHeaders);
+	auto res = client->Get(path, httpHeaders);
+	if (res) httpClientPool.release(scheme, std::move(client));
 	return handleSyncHTTPResponse(res, s);
 }
 
 sol::object http::postSync(const char* scheme, const char* path,
                            sol::table headers, std::string body,
                            const char* contentType, sol::this_state s) {
-	httplib::Client client(scheme);
-	client.set_connection_timeout(6);
-	client.set_keep_alive(false);
+	auto client = acquireSyncHTTPClient(scheme);
 
 	httplib::Headers httpHeaders;
 	for (const auto& pair : headers)
 		httpHeaders.emplace(pair.first.as<std::string>(),
 		                    pair.second.as<std::string>());
 
-	httpHeaders.emplace("Connection", "close");
-
-	auto res = client.Post(path, httpHeaders, body, contentType);
+	auto res = client->Post(path, httpHeaders, body, contentType);
+	if (res) httpClientPool.release(scheme, std::move(client));
 	return handleSyncHTTPResponse(res, s);
 }
 
+static HTTPPool httpPool(httpClientPool, 4, 256);
+static std::unordered_map<unsigned int, sol::protected_function>
+    httpCallbacks;
+static unsigned int nextHTTPRequestID = 1;
+
+static sol::object enqueueHTTPRequest(LuaHTTPRequest&& request,
+                                      sol::table headers,
+                                      sol::protected_function callback,
+                                      sol::optional<sol::table> options,
+                                      sol::this_state s) {
+	for (const auto& pair : headers)
+		request.headers.emplace(pair.first.as<std::string>(),
+		                        pair.second.as<std::string>());
+
+	request.timeout = 6;
+	if (options) {
+		sol::optional<int> timeout = (*options)["timeout"];
+		if (timeout) {
+			if (*timeout <= 0) throw std::invalid_argument("Invalid timeout");
+			request.timeout = *timeout;
+		}
+	}
+
+	sol::state_view lua(s);
+	unsigned int id = nextHTTPRequestID++;
+	request.id = id;
+	if (!httpPool.enqueue(std::move(request)))
+		return sol::make_object(lua, sol::nil);
+
+	httpCallbacks.emplace(id, callback);
+	return sol::make_object(lua, id);
+}
+
+sol::object http::get(std::string scheme, std::string path, sol::table headers,
+                      sol::protected_function callback,
+                      sol::optional<sol::table> options, sol::this_state s) {
+	LuaHTTPRequest request;
+	request.type = LuaRequestType::get;
+	request.scheme = std::move(scheme);
+	request.path = std::move(path);
+	return enqueueHTTPRequest(std::move(request), headers, callback, options, s);
+}
+
+sol::object http::post(std::string scheme, std::string path,
+                       sol::table headers, std::string body,
+                       std::string contentType,
+                       sol::protected_function callback,
+                       sol::optional<sol::table> options, sol::this_state s) {
+	LuaHTTPRequest request;
+	request.type = LuaRequestType::post;
+	request.scheme = std::move(scheme);
+	request.path = std::move(path);
+	request.body = std::move(body);
+	request.contentType = std::move(contentType);
+	return enqueueHTTPRequest(std::move(request), headers, callback, options, s);
+}
+
+bool http::cancel(unsigned int id) {
+	if (!httpCallbacks.erase(id)) return false;
+	httpPool.cancel(id);
+	return true;
+}
+
+size_t http::getPending() { return httpPool.getPending(); }
+
+sol::table http::getPoolStats(sol::this_state s) {
+	sol::state_view lua(s);
+	auto stats = httpClientPool.getStats();
+
+	sol::table table = lua.create_table();
+	table["hits"] = stats.hits;
+	table["misses"] = stats.misses;
+	table["expired"] = stats.expired;
+	table["idle"] = stats.idle;
+	return table;
+}
+
+void http::setPoolLimits(int maxSize, int idleTimeout) {
+	if (maxSize < 0) throw std::invalid_argument("Invalid pool size");
+	httpClientPool.setLimits(maxSize, idleTimeout);
+}
+
+void http::dispatchResponses() {
+	LuaHTTPResponse response;
+	while (httpPool.receive(response)) {
+		auto it = httpCallbacks.find(response.id);
+		// Cancelled, or made by a previous state
+		if (it == httpCallbacks.end()) continue;
+
+		auto callback = std::move(it->second);
+		httpCallbacks.erase(it);
+
+		sol::state_view lua(callback.lua_state());
+		auto result = response.responded
+		                  ? sol::make_object(lua, createHTTPResponseTable(
+		                                              lua, response.status,
+		                                              response.body,
+		                                              response.headers))
+		                  : sol::make_object(lua, sol::nil);
+		auto res = callback(result);
+		noLuaCallError(&res);
+	}
+}
+
+void http::clearCallbacks() { httpCallbacks.clear(); }
+
 static inline std::string withoutPostPrefix(std::string name) {
 	if (name.rfind("Post", 0) == 0) {
 		return name.substr(4);
@@ -184,7 +445,9 @@ static inline std::string withoutPostPrefix(std::string name) {
 bool hook::enable(std::string name) {
 	auto search = Hooks::enableNames.find(withoutPostPrefix(name));
 	if (search != Hooks::enableNames.end()) {
-		Hooks::enabledKeys[search->second] = true;
+		Hooks::scriptEnabledKeys[search->second] = true;
+		Hooks::updateEnabledKey(search->second);
+		Hooks::updateInstalledHooks();
 		return true;
 	}
 	return false;
@@ -193,7 +456,9 @@ bool hook::enable(std::string name) {
 bool hook::disable(std::string name) {
 	auto search = Hooks::enableNames.find(withoutPostPrefix(name));
 	if (search != Hooks::enableNames.end()) {
-		Hooks::enabledKeys[search->second] = false;
+		Hooks::scriptEnabledKeys[search->second] = false;
+		Hooks::updateEnabledKey(search->second);
+		Hooks::updateInstalledHooks();
 		return true;
 	}
 	return false;
@@ -201,18 +466,216 @@ bool hook::disable(std::string name) {
 
 void hook::clear() {
 	for (size_t i = 0; i < Hooks::EnableKeys::SIZE; i++) {
-		Hooks::enabledKeys[i] = false;
+		Hooks::scriptEnabledKeys[i] = false;
+	}
+	// These always reached hook.run before they could be enabled, so they stay
+	// on by default and scripts can hook.disable them
+	Hooks::scriptEnabledKeys[Hooks::EnableKeys::BulletMayHit] = true;
+	Hooks::scriptEnabledKeys[Hooks::EnableKeys::BulletMayHitHuman] = true;
+	Hooks::scriptEnabledKeys[Hooks::EnableKeys::BulletHitHuman] = true;
+	Hooks::clearCallbacks();
+	Hooks::updateInstalledHooks();
+}
+
+bool hook::registerCallback(std::string name, sol::protected_function func) {
+	bool isPost = name.rfind("Post", 0) == 0;
+	auto search = Hooks::enableNames.find(withoutPostPrefix(name));
+	if (search == Hooks::enableNames.end()) return false;
+
+	auto& callback = Hooks::callbacks[search->second];
+	(isPost ? callback.post : callback.pre) = func;
+	Hooks::updateEnabledKey(search->second);
+	Hooks::updateInstalledHooks();
+	return true;
+}
+
+bool hook::observe(std::string name, sol::protected_function func) {
+	bool isPost = name.rfind("Post", 0) == 0;
+	auto search = Hooks::enableNames.find(withoutPostPrefix(name));
+	if (search == Hooks::enableNames.end()) return false;
+
+	auto& callback = Hooks::callbacks[search->second];
+	(isPost ? callback.postObserver : callback.preObserver) = func;
+	Hooks::updateEnabledKey(search->second);
+	Hooks::updateInstalledHooks();
+	return true;
+}
+
+bool hook::unregisterCallback(std::string name) {
+	bool isPost = name.rfind("Post", 0) == 0;
+	auto search = Hooks::enableNames.find(withoutPostPrefix(name));
+	if (search == Hooks::enableNames.end()) return false;
+
+	auto& callback = Hooks::callbacks[search->second];
+	(isPost ? callback.post : callback.pre) = sol::nil;
+	(isPost ? callback.postObserver : callback.preObserver) = sol::nil;
+	Hooks::updateEnabledKey(search->second);
+	Hooks::updateInstalledHooks();
+	return true;
+}
+
+static sol::table histogramToTable(const LatencyHistogram& histogram) {
+	auto table = lua->create_table();
+	table["count"] = histogram.getCount();
+	table["total"] = histogram.getTotal();
+	table["mean"] = histogram.getMean();
+	table["min"] = histogram.getMin();
+	table["max"] = histogram.getMax();
+	table["p50"] = histogram.getPercentile(50);
+	table["p90"] = histogram.getPercentile(90);
+	table["p99"] = histogram.getPercentile(99);
+	table["p999"] = histogram.getPercentile(99.9);
+	return table;
+}
+
+sol::table hook::getStats() {
+	auto hooks = lua->create_table();
+	for (size_t i = 0; i < Hooks::EnableKeys::SIZE; i++) {
+		const auto& stats = Hooks::hookStats[i];
+		if (!stats.pre.getCount() && !stats.post.getCount()) continue;
+
+		auto hookStats = lua->create_table();
+		hookStats["pre"] = histogramToTable(stats.pre);
+		hookStats["post"] = histogramToTable(stats.post);
+		hooks[Hooks::getKeyName(static_cast<Hooks::EnableKeys>(i))] = hookStats;
+	}
+
+	auto originals = lua->create_table();
+	for (const auto hook : Hooks::trampolineHooks) {
+		if (!hook->originalLatency.getCount()) continue;
+		originals[hook->name] = histogramToTable(hook->originalLatency);
+	}
+
+	auto stats = lua->create_table();
+	stats["enabled"] = Hooks::collectStats;
+	stats["hooks"] = hooks;
+	stats["originals"] = originals;
+	return stats;
+}
+
+void hook::setStatsEnabled(bool enabled) { Hooks::collectStats = enabled; }
+
+void hook::resetStats() { Hooks::resetStats(); }
+
+void hook::startTrace(std::string path) {
+	if (Hooks::traceRecorder) throw std::runtime_error("Already tracing");
+	Hooks::traceRecorder = new TraceRecorder(path);
+}
+
+unsigned long long hook::stopTrace() {
+	if (!Hooks::traceRecorder) throw std::runtime_error("Not tracing");
+
+	auto numRecords = Hooks::traceRecorder->numRecords;
+	delete Hooks::traceRecorder;
+	Hooks::traceRecorder = nullptr;
+	return numRecords;
+}
+
+sol::table hook::getTrampolineStats() {
+	auto stats = lua->create_table();
+	for (const auto hook : Hooks::trampolineHooks) {
+		auto hookStats = lua->create_table();
+		hookStats["installed"] = hook->IsInstalled();
+		hookStats["hasTrampoline"] = hook->hasTrampoline();
+		hookStats["trampolineCalls"] = hook->trampolineCalls;
+		hookStats["removeCalls"] = hook->removeCalls;
+		stats[hook->name] = hookStats;
 	}
+	return stats;
+}
+
+void tickProfiler::setEnabled(bool enabled) {
+	Hooks::tickProfiler.enabled = enabled;
+	Hooks::updateInstalledHooks();
+}
+
+double tickProfiler::getBudget() {
+	return Hooks::tickProfiler.budget / 1000000.0;
+}
+
+void tickProfiler::setBudget(double milliseconds) {
+	if (milliseconds <= 0) throw std::invalid_argument("Budget must be positive");
+	Hooks::tickProfiler.budget = milliseconds * 1000000.0;
 }
 
+void tickProfiler::setCapacity(size_t capacity) {
+	Hooks::tickProfiler.setCapacity(capacity);
+}
+
+sol::table tickProfiler::getTicks() {
+	auto ticks = lua->create_table();
+	for (size_t age = Hooks::tickProfiler.getNumSamples(); age-- > 0;) {
+		const auto& sample = Hooks::tickProfiler.getSample(age);
+
+		auto tick = lua->create_table();
+		tick["total"] = sample.total / 1000000.0;
+		for (int i = 0; i < TickProfiler::NumPhases; i++)
+			tick[TickProfiler::phaseNames[i]] = sample.phases[i] / 1000000.0;
+		ticks.add(tick);
+	}
+	return ticks;
+}
+
+static sol::table distributionToTable(std::vector<uint64_t>& values) {
+	auto table = lua->create_table();
+	if (values.empty()) return table;
+
+	std::sort(values.begin(), values.end());
+	auto percentile = [&values](double p) {
+		return values[static_cast<size_t>(p / 100.0 * (values.size() - 1))] /
+		       1000000.0;
+	};
+
+	uint64_t total = 0;
+	for (auto value : values) total += value;
+
+	table["mean"] = total / 1000000.0 / values.size();
+	table["p50"] = percentile(50);
+	table["p90"] = percentile(90);
+	table["p99"] = percentile(99);
+	table["max"] = values.back() / 1000000.0;
+	return table;
+}
+
+sol::table tickProfiler::getStats() {
+	size_t numSamples = Hooks::tickProfiler.getNumSamples();
+	std::vector<uint64_t> values(numSamples);
+
+	auto stats = lua->create_table();
+	stats["ticks"] = numSamples;
+
+	for (size_t age = 0; age < numSamples; age++)
+		values[age] = Hooks::tickProfiler.getSample(age).total;
+	stats["total"] = distributionToTable(values);
+
+	size_t overBudget = 0;
+	for (auto value : values) {
+		if (value > Hooks::tickProfiler.budget) overBudget++;
+	}
+	stats["overBudget"] = overBudget;
+
+	auto phases = lua->create_table();
+	for (int i = 0; i < TickProfiler::NumPhases; i++) {
+		for (size_t age = 0; age < numSamples; age++)
+			values[age] = Hooks::tickProfiler.getSample(age).phases[i];
+		phases[TickProfiler::phaseNames[i]] = distributionToTable(values);
+	}
+	stats["phases"] = phases;
+
+	return stats;
+}
+
+// Results are written into out when it's given, reusing its vectors. On a miss
+// the fields of the previous hit are left as they were.
 sol::table physics::lineIntersectLevel(Vector* posA, Vector* posB,
-                                       bool onlyCity) {
-	sol::table table = lua->create_table();
-	subhook::ScopedHookRemove remove(&Hooks::lineIntersectLevelHook);
-	int res = Engine::lineIntersectLevel(posA, posB, !onlyCity);
+                                       bool onlyCity,
+                                       sol::optional<sol::table> out) {
+	sol::table table = out ? *out : lua->create_table();
+	int res = Hooks::lineIntersectLevelHook.callOriginal(
+	    Engine::lineIntersectLevel, posA, posB, !onlyCity);
 	if (res && (!onlyCity || Engine::lineIntersectResult->areaId != -1)) {
-		table["pos"] = Engine::lineIntersectResult->pos;
-		table["normal"] = Engine::lineIntersectResult->normal;
+		setTableVector(table, "pos", Engine::lineIntersectResult->pos);
+		setTableVector(table, "normal", Engine::lineIntersectResult->normal);
 		table["fraction"] = Engine::lineIntersectResult->fraction;
 	}
 	table["hit"] = res != 0;
@@ -220,13 +683,14 @@ sol::table physics::lineIntersectLevel(Vector* posA, Vector* posB,
 }
 
 sol::table physics::lineIntersectHuman(Human* man, Vector* posA, Vector* posB,
-                                       float padding) {
-	sol::table table = lua->create_table();
-	subhook::ScopedHookRemove remove(&Hooks::lineIntersectHumanHook);
-	int res = Engine::lineIntersectHuman(man->getIndex(), posA, posB, padding);
+                                       float padding,
+                                       sol::optional<sol::table> out) {
+	sol::table table = out ? *out : lua->create_table();
+	int res = Hooks::lineIntersectHumanHook.callOriginal(
+	    Engine::lineIntersectHuman, man->getIndex(), posA, posB, padding);
 	if (res) {
-		table["pos"] = Engine::lineIntersectResult->pos;
-		table["normal"] = Engine::lineIntersectResult->normal;
+		setTableVector(table, "pos", Engine::lineIntersectResult->pos);
+		setTableVector(table, "normal", Engine::lineIntersectResult->normal);
 		table["fraction"] = Engine::lineIntersectResult->fraction;
 		table["bone"] = Engine::lineIntersectResult->humanBone;
 	}
@@ -235,19 +699,23 @@ sol::table physics::lineIntersectHuman(Human* man, Vector* posA, Vector* posB,
 }
 
 sol::table physics::lineIntersectVehicle(Vehicle* vehicle, Vector* posA,
-                                         Vector* posB, bool includeWheels) {
-	sol::table table = lua->create_table();
+                                         Vector* posB, bool includeWheels,
+                                         sol::optional<sol::table> out) {
+	sol::table table = out ? *out : lua->create_table();
 	int res = Engine::lineIntersectVehicle(vehicle->getIndex(), posA, posB,
 	                                       includeWheels);
 	if (res) {
-		table["pos"] = Engine::lineIntersectResult->pos;
-		table["normal"] = Engine::lineIntersectResult->normal;
+		setTableVector(table, "pos", Engine::lineIntersectResult->pos);
+		setTableVector(table, "normal", Engine::lineIntersectResult->normal);
 		table["fraction"] = Engine::lineIntersectResult->fraction;
 
-		if (Engine::lineIntersectResult->vehicleFace != -1)
+		if (Engine::lineIntersectResult->vehicleFace != -1) {
 			table["face"] = Engine::lineIntersectResult->vehicleFace;
-		else
+			table["wheel"] = sol::nil;
+		} else {
+			table["face"] = sol::nil;
 			table["wheel"] = Engine::lineIntersectResult->humanBone;
+		}
 	}
 	table["hit"] = res != 0;
 	return table;
@@ -257,8 +725,8 @@ sol::object physics::lineIntersectLevelQuick(Vector* posA, Vector* posB,
                                              bool onlyCity, sol::this_state s) {
 	sol::state_view lua(s);
 
-	subhook::ScopedHookRemove remove(&Hooks::lineIntersectLevelHook);
-	int res = Engine::lineIntersectLevel(posA, posB, !onlyCity);
+	int res = Hooks::lineIntersectLevelHook.callOriginal(
+	    Engine::lineIntersectLevel, posA, posB, !onlyCity);
 	if (res && (!onlyCity || Engine::lineIntersectResult->areaId != -1)) {
 		return sol::make_object(lua, Engine::lineIntersectResult->fraction);
 	}
@@ -270,8 +738,8 @@ sol::object physics::lineIntersectHumanQuick(Human* man, Vector* posA,
                                              sol::this_state s) {
 	sol::state_view lua(s);
 
-	subhook::ScopedHookRemove remove(&Hooks::lineIntersectHumanHook);
-	int res = Engine::lineIntersectHuman(man->getIndex(), posA, posB, padding);
+	int res = Hooks::lineIntersectHumanHook.callOriginal(
+	    Engine::lineIntersectHuman, man->getIndex(), posA, posB, padding);
 	if (res) {
 		return sol::make_object(lua, Engine::lineIntersectResult->fraction);
 	}
@@ -291,6 +759,100 @@ sol::object physics::lineIntersectVehicleQuick(Vehicle* vehicle, Vector* posA,
 	return sol::make_object(lua, sol::nil);
 }
 
+// Bones are joints with limbs between them, so padding the farthest bone by
+// the thickest limb covers the whole body, ragdolled or not.
+static constexpr float boneRadius = 1.f;
+// How far from a vehicle its hull is probed for, which is past any vehicle.
+static constexpr float hullProbeDistance = 128.f;
+// The least a vehicle's bounds can be, if probing finds a smaller hull or none.
+static constexpr float minVehicleRadius = 16.f;
+// Around a helicopter's blade body, which spins well outside the hull.
+static constexpr float bladeRadius = 16.f;
+
+// Measured the first time a vehicle of each type is tested.
+static float vehicleTypeRadii[maxNumberOfVehicleTypes];
+
+static struct {
+	uint64_t tested;
+	uint64_t culled;
+} broadPhaseStats;
+
+static float distanceSquare(const Vector& a, const Vector& b) {
+	float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+static float getHumanBoundingRadius(const Human* human) {
+	float radiusSquare = 0.f;
+	for (const auto& bone : human->bones)
+		radiusSquare = std::max(radiusSquare, distanceSquare(bone.pos, human->pos));
+	return std::sqrt(radiusSquare) + boneRadius;
+}
+
+// Casts rays at the vehicle along each of its axes from both sides. The hits
+// give the half size of a box around the hull, and its diagonal bounds it.
+static float measureHullRadius(int index) {
+	Vehicle* vehicle = &Engine::vehicles[index];
+	const Vector axes[3] = {vehicle->rot.getForward(), vehicle->rot.getUp(),
+	                        vehicle->rot.getRight()};
+
+	float radiusSquare = 0.f;
+	for (const auto& axis : axes) {
+		float extent = 0.f;
+		for (float direction : {hullProbeDistance, -hullProbeDistance}) {
+			Vector from = {vehicle->pos.x + axis.x * direction,
+			               vehicle->pos.y + axis.y * direction,
+			               vehicle->pos.z + axis.z * direction};
+			Vector to = vehicle->pos;
+			if (Engine::lineIntersectVehicle(index, &from, &to, true)) {
+				float fraction = Engine::lineIntersectResult->fraction;
+				extent = std::max(extent, (1.f - fraction) * hullProbeDistance);
+			}
+		}
+		radiusSquare += extent * extent;
+	}
+
+	return std::max(std::sqrt(radiusSquare), minVehicleRadius);
+}
+
+static float getVehicleBoundingRadius(int index) {
+	Vehicle* vehicle = &Engine::vehicles[index];
+
+	float radius = minVehicleRadius;
+	if (vehicle->type < maxNumberOfVehicleTypes) {
+		float& typeRadius = vehicleTypeRadii[vehicle->type];
+		if (!typeRadius) typeRadius = measureHullRadius(index);
+		radius = typeRadius;
+	}
+
+	// Vehicles without a blade don't always have a valid ID, so only a body
+	// which is plausibly attached counts
+	int bladeID = vehicle->bladeBodyID;
+	if (bladeID >= 0 && bladeID < maxNumberOfRigidBodies &&
+	    bladeID != vehicle->bodyID) {
+		const RigidBody* blade = &Engine::bodies[bladeID];
+		float distance = std::sqrt(distanceSquare(blade->pos, vehicle->pos));
+		if (blade->active && blade->type == 1 && distance < hullProbeDistance)
+			radius = std::max(radius, distance + bladeRadius);
+	}
+
+	return radius;
+}
+
+// Whether the segment from a to b passes within radius of center.
+static bool segmentNearPoint(const Vector* a, const Vector* b,
+                             const Vector& center, float radius) {
+	float dx = b->x - a->x, dy = b->y - a->y, dz = b->z - a->z;
+	float cx = center.x - a->x, cy = center.y - a->y, cz = center.z - a->z;
+
+	float lengthSquare = dx * dx + dy * dy + dz * dz;
+	float t = lengthSquare > 0 ? (cx * dx + cy * dy + cz * dz) / lengthSquare : 0;
+	t = std::clamp(t, 0.f, 1.f);
+
+	float ox = cx - dx * t, oy = cy - dy * t, oz = cz - dz * t;
+	return ox * ox + oy * oy + oz * oz <= radius * radius;
+}
+
 std::tuple<sol::object, sol::object> physics::lineIntersectAnyQuick(
     Vector* posA, Vector* posB, Human* ignoreHuman, float humanPadding,
     bool includeWheels, sol::this_state s) {
@@ -302,33 +864,45 @@ std::tuple<sol::object, sol::object> physics::lineIntersectAnyQuick(
 	int ignoreHumanId = ignoreHuman ? ignoreHuman->getIndex() : -1;
 	bool didHitLevel = false;
 
-	{
-		subhook::ScopedHookRemove remove(&Hooks::lineIntersectLevelHook);
-		if (Engine::lineIntersectLevel(posA, posB, 1)) {
-			nearestFraction = Engine::lineIntersectResult->fraction;
-			didHitLevel = true;
+	if (Hooks::lineIntersectLevelHook.callOriginal(Engine::lineIntersectLevel,
+	                                               posA, posB, 1)) {
+		nearestFraction = Engine::lineIntersectResult->fraction;
+		didHitLevel = true;
+	}
+
+	activeHumans.prune([](int i) { return Engine::humans[i].active; });
+	float padding = std::max(humanPadding, 0.f);
+	for (int i : activeHumans) {
+		if (i == ignoreHumanId) continue;
+		Human* human = &Engine::humans[i];
+		if (!segmentNearPoint(posA, posB, human->pos,
+		                      getHumanBoundingRadius(human) + padding)) {
+			broadPhaseStats.culled++;
+			continue;
 		}
-	}
+		broadPhaseStats.tested++;
 
-	{
-		subhook::ScopedHookRemove remove(&Hooks::lineIntersectHumanHook);
-		for (int i = 0; i < maxNumberOfHumans; i++) {
-			Human* human = &Engine::humans[i];
-			if (i != ignoreHumanId && human->active &&
-			    Engine::lineIntersectHuman(i, posA, posB, humanPadding)) {
-				float fraction = Engine::lineIntersectResult->fraction;
-				if (fraction < nearestFraction) {
-					nearestFraction = fraction;
-					nearestObject = human;
-				}
+		if (Hooks::lineIntersectHumanHook.callOriginal(
+		        Engine::lineIntersectHuman, i, posA, posB, humanPadding)) {
+			float fraction = Engine::lineIntersectResult->fraction;
+			if (fraction < nearestFraction) {
+				nearestFraction = fraction;
+				nearestObject = human;
 			}
 		}
 	}
 
-	for (int i = 0; i < maxNumberOfVehicles; i++) {
+	activeVehicles.prune([](int i) { return Engine::vehicles[i].active; });
+	for (int i : activeVehicles) {
 		Vehicle* vehicle = &Engine::vehicles[i];
-		if (vehicle->active &&
-		    Engine::lineIntersectVehicle(i, posA, posB, includeWheels)) {
+		if (!segmentNearPoint(posA, posB, vehicle->pos,
+		                      getVehicleBoundingRadius(i))) {
+			broadPhaseStats.culled++;
+			continue;
+		}
+		broadPhaseStats.tested++;
+
+		if (Engine::lineIntersectVehicle(i, posA, posB, includeWheels)) {
 			float fraction = Engine::lineIntersectResult->fraction;
 			if (fraction < nearestFraction) {
 				nearestFraction = fraction;
@@ -356,6 +930,151 @@ std::tuple<sol::object, sol::object> physics::lineIntersectAnyQuick(
 	return std::make_tuple(sol::nil, sol::nil);
 }
 
+sol::table physics::raycastBatch(sol::table rays, unsigned int flags,
+                                 sol::optional<sol::table> out) {
+	struct Ray {
+		Vector* posA;
+		Vector* posB;
+		float fraction;
+		bool didHit;
+		Human* human;
+		Vehicle* vehicle;
+	};
+
+	constexpr float infinity = std::numeric_limits<float>::infinity();
+	std::vector<Ray> batch;
+	batch.reserve(rays.size());
+	Vector min = {infinity, infinity, infinity};
+	Vector max = {-infinity, -infinity, -infinity};
+
+	for (size_t i = 1, count = rays.size(); i <= count; i++) {
+		sol::table pair = rays[i];
+		sol::optional<Vector*> posA = pair[1];
+		sol::optional<Vector*> posB = pair[2];
+		if (!posA || !posB || !*posA || !*posB)
+			throw std::invalid_argument(missingArgument);
+
+		batch.push_back({*posA, *posB, infinity, false, nullptr, nullptr});
+		for (const Vector* pos : {*posA, *posB}) {
+			min = {std::min(min.x, pos->x), std::min(min.y, pos->y),
+			       std::min(min.z, pos->z)};
+			max = {std::max(max.x, pos->x), std::max(max.y, pos->y),
+			       std::max(max.z, pos->z)};
+		}
+	}
+
+	// One pass over each array finds the entities near any ray at all
+	auto nearBatch = [&](const Vector& pos, float radius) {
+		return pos.x >= min.x - radius && pos.y >= min.y - radius &&
+		       pos.z >= min.z - radius && pos.x <= max.x + radius &&
+		       pos.y <= max.y + radius && pos.z <= max.z + radius;
+	};
+
+	// Each candidate's index and bounding radius
+	std::vector<std::pair<int, float>> humanCandidates;
+	if (flags & RaycastHumans) {
+		activeHumans.prune([](int i) { return Engine::humans[i].active; });
+		for (int i : activeHumans) {
+			float radius = getHumanBoundingRadius(&Engine::humans[i]);
+			if (nearBatch(Engine::humans[i].pos, radius))
+				humanCandidates.emplace_back(i, radius);
+			else
+				broadPhaseStats.culled += batch.size();
+		}
+	}
+
+	std::vector<std::pair<int, float>> vehicleCandidates;
+	if (flags & RaycastVehicles) {
+		activeVehicles.prune([](int i) { return Engine::vehicles[i].active; });
+		for (int i : activeVehicles) {
+			float radius = getVehicleBoundingRadius(i);
+			if (nearBatch(Engine::vehicles[i].pos, radius))
+				vehicleCandidates.emplace_back(i, radius);
+			else
+				broadPhaseStats.culled += batch.size();
+		}
+	}
+
+	bool onlyCity = flags & RaycastOnlyCity;
+	bool includeWheels = flags & RaycastWheels;
+	for (auto& ray : batch) {
+		if (flags & RaycastLevel &&
+		    Hooks::lineIntersectLevelHook.callOriginal(
+		        Engine::lineIntersectLevel, ray.posA, ray.posB, !onlyCity) &&
+		    (!onlyCity || Engine::lineIntersectResult->areaId != -1)) {
+			ray.fraction = Engine::lineIntersectResult->fraction;
+			ray.didHit = true;
+		}
+
+		for (auto [i, radius] : humanCandidates) {
+			Human* human = &Engine::humans[i];
+			if (!segmentNearPoint(ray.posA, ray.posB, human->pos, radius)) {
+				broadPhaseStats.culled++;
+				continue;
+			}
+			broadPhaseStats.tested++;
+
+			if (Hooks::lineIntersectHumanHook.callOriginal(
+			        Engine::lineIntersectHuman, i, ray.posA, ray.posB, 0.f) &&
+			    Engine::lineIntersectResult->fraction < ray.fraction) {
+				ray.fraction = Engine::lineIntersectResult->fraction;
+				ray.didHit = true;
+				ray.human = human;
+			}
+		}
+
+		for (auto [i, radius] : vehicleCandidates) {
+			Vehicle* vehicle = &Engine::vehicles[i];
+			if (!segmentNearPoint(ray.posA, ray.posB, vehicle->pos, radius)) {
+				broadPhaseStats.culled++;
+				continue;
+			}
+			broadPhaseStats.tested++;
+
+			if (Engine::lineIntersectVehicle(i, ray.posA, ray.posB,
+			                                 includeWheels) &&
+			    Engine::lineIntersectResult->fraction < ray.fraction) {
+				ray.fraction = Engine::lineIntersectResult->fraction;
+				ray.didHit = true;
+				ray.human = nullptr;
+				ray.vehicle = vehicle;
+			}
+		}
+	}
+
+	// Results go into tables already in the buffer where possible
+	sol::table results = out ? *out : lua->create_table(batch.size(), 0);
+	for (size_t i = 0; i < batch.size(); i++) {
+		const auto& ray = batch[i];
+		sol::optional<sol::table> existing = results[i + 1];
+		sol::table result = existing ? *existing : lua->create_table(0, 3);
+		result["hit"] = ray.didHit;
+		if (ray.didHit)
+			result["fraction"] = ray.fraction;
+		else
+			result["fraction"] = sol::lua_nil;
+		if (ray.human)
+			result["object"] = ray.human;
+		else if (ray.vehicle)
+			result["object"] = ray.vehicle;
+		else
+			result["object"] = sol::lua_nil;
+		if (!existing) results[i + 1] = result;
+	}
+	for (size_t i = batch.size() + 1; results[i].valid(); i++)
+		results[i] = sol::lua_nil;
+	return results;
+}
+
+sol::table physics::getBroadPhaseStats() {
+	auto stats = lua->create_table();
+	stats["tested"] = broadPhaseStats.tested;
+	stats["culled"] = broadPhaseStats.culled;
+	return stats;
+}
+
+void physics::resetBroadPhaseStats() { broadPhaseStats = {}; }
+
 sol::object physics::lineIntersectTriangle(Vector* outPos, Vector* normal,
                                            Vector* posA, Vector* posB,
                                            Vector* triA, Vector* triB,
@@ -375,8 +1094,8 @@ void physics::garbageCollectBullets() { Engine::bulletTimeToLive(); }
 void physics::createBlock(int blockX, int blockY, int blockZ,
                           unsigned int flags) {
 	short unk[8] = {15, 15, 15, 15, 15, 15, 15, 15};
-	subhook::ScopedHookRemove remove(&Hooks::areaCreateBlockHook);
-	Engine::areaCreateBlock(0, blockX, blockY, blockZ, flags, unk);
+	Hooks::areaCreateBlockHook.callOriginal(
+	    Engine::areaCreateBlock, 0, blockX, blockY, blockZ, flags, unk);
 }
 
 unsigned int physics::getBlock(int blockX, int blockY, int blockZ) {
@@ -384,8 +1103,151 @@ unsigned int physics::getBlock(int blockX, int blockY, int blockZ) {
 }
 
 void physics::deleteBlock(int blockX, int blockY, int blockZ) {
-	subhook::ScopedHookRemove remove(&Hooks::areaDeleteBlockHook);
-	Engine::areaDeleteBlock(0, blockX, blockY, blockZ);
+	Hooks::areaDeleteBlockHook.callOriginal(
+	    Engine::areaDeleteBlock, 0, blockX, blockY, blockZ);
+}
+
+// The hash is only kept up to date once a script has used it
+static void enableSpatialHash() {
+	if (spatialHash.enabled) return;
+	spatialHash.enabled = true;
+	updateSpatialHash();
+	Hooks::updateInstalledHooks();
+}
+
+void world::saveSnapshot(std::string path) { WorldSnapshot::save(path); }
+
+template <size_t N>
+static void clearDataTables(sol::table* (&tables)[N]) {
+	for (auto& table : tables) {
+		delete table;
+		table = nullptr;
+	}
+}
+
+void world::loadSnapshot(std::string path) {
+	// Connections point at player slots the snapshot would replace, and clients
+	// would be left controlling whoever is loaded there
+	if (*Engine::numConnections)
+		throw std::runtime_error("Can't load a snapshot with clients connected");
+
+	// The data tables belonged to whatever was in the slots before
+	for (auto kind : WorldSnapshot::load(path)) {
+		switch (kind) {
+			case WorldSnapshot::Accounts:
+				clearDataTables(accountDataTables);
+				break;
+			case WorldSnapshot::Players:
+				clearDataTables(playerDataTables);
+				break;
+			case WorldSnapshot::Humans:
+				clearDataTables(humanDataTables);
+				break;
+			case WorldSnapshot::Items:
+				clearDataTables(itemDataTables);
+				break;
+			case WorldSnapshot::Vehicles:
+				clearDataTables(vehicleDataTables);
+				break;
+			case WorldSnapshot::RigidBodies:
+				clearDataTables(bodyDataTables);
+				break;
+			default:
+				break;
+		}
+	}
+
+	rebuildActiveSets();
+	invalidateAccountLookups();
+}
+
+void worldDelta::setEnabled(bool enabled) {
+	if (enabled && !::worldDelta.enabled) ::worldDelta.reset();
+	::worldDelta.enabled = enabled;
+}
+
+void worldDelta::reset() { ::worldDelta.reset(); }
+
+void worldDelta::setCapacity(size_t capacity) {
+	::worldDelta.setCapacity(capacity);
+}
+
+sol::object worldDelta::receive(sol::this_state s) {
+	sol::state_view state(s);
+	auto delta = ::worldDelta.receive();
+	if (!delta) return sol::make_object(state, sol::nil);
+	return sol::make_object(state, *delta);
+}
+
+size_t worldDelta::getQueued() { return ::worldDelta.getQueued(); }
+
+// The hash is only refreshed after physics, so drop anything deleted since
+// without going through a hook
+static void removeInactiveResults(SpatialQuery& query) {
+	auto& results = query.results;
+	results.erase(std::remove_if(results.begin(), results.end(),
+	                             [](const SpatialHash::Result& result) {
+		                             return !isEntityActive(result.kind,
+		                                                    result.index);
+	                             }),
+	              results.end());
+}
+
+SpatialQuery spatial::queryRadius(Vector* pos, float radius,
+                                  sol::optional<unsigned int> kinds) {
+	enableSpatialHash();
+	SpatialQuery query;
+	spatialHash.queryRadius(*pos, radius, kinds.value_or(SpatialHash::allKinds),
+	                        query.results);
+	removeInactiveResults(query);
+	return query;
+}
+
+SpatialQuery spatial::nearest(Vector* pos, sol::optional<unsigned int> kinds,
+                              sol::optional<unsigned int> count) {
+	enableSpatialHash();
+	SpatialQuery query;
+	// Filtered while searching, so deleted entities can't take up the count
+	spatialHash.nearest(*pos, kinds.value_or(SpatialHash::allKinds),
+	                    count.value_or(1), query.results, isEntityActive);
+	return query;
+}
+
+SpatialQuery spatial::queryBox(Vector* min, Vector* max,
+                               sol::optional<unsigned int> kinds) {
+	enableSpatialHash();
+	SpatialQuery query;
+	spatialHash.queryBox(*min, *max, kinds.value_or(SpatialHash::allKinds),
+	                     query.results);
+	removeInactiveResults(query);
+	return query;
+}
+
+std::tuple<sol::object, sol::object> SpatialQuery::next(sol::variadic_args,
+                                                        sol::this_state s) {
+	// Entities may have been deleted since the query, during iteration
+	while (position < results.size() &&
+	       !isEntityActive(results[position].kind, results[position].index))
+		position++;
+	if (position == results.size()) return {sol::nil, sol::nil};
+
+	const auto& result = results[position++];
+	sol::object entity;
+	switch (result.kind) {
+		case SpatialHash::Humans:
+			entity = sol::make_object(s, &Engine::humans[result.index]);
+			break;
+		case SpatialHash::Vehicles:
+			entity = sol::make_object(s, &Engine::vehicles[result.index]);
+			break;
+		case SpatialHash::Items:
+			entity = sol::make_object(s, &Engine::items[result.index]);
+			break;
+		default:
+			entity = sol::make_object(s, &Engine::bodies[result.index]);
+			break;
+	}
+	return {entity, sol::make_object(s, result.distance)};
 }
 
 int itemTypes::getCount() { return maxNumberOfItemTypes; }
@@ -403,34 +1265,44 @@ ItemType* itemTypes::getByIndex(sol::table self, unsigned int idx) {
 	return &Engine::itemTypes[idx];
 }
 
-ItemType* itemTypes::getByName(const char* name) {
-	for (int i = 0; i < maxNumberOfItemTypes; i++) {
-		ItemType* type = &Engine::itemTypes[i];
-		if (!std::strcmp(name, type->name)) {
-			return type;
-		}
-	}
-	return nullptr;
+static const NameIndex& getItemTypeNames() {
+	return getTypeNames(itemTypeNames, Engine::itemTypes, maxNumberOfItemTypes);
+}
+
+ItemType* itemTypes::getByName(std::string_view name,
+                               sol::optional<bool> ignoreCase) {
+	int index = getItemTypeNames().find(name, ignoreCase.value_or(false));
+	return index == -1 ? nullptr : &Engine::itemTypes[index];
+}
+
+sol::table itemTypes::findByPrefix(std::string_view prefix) {
+	auto arr = lua->create_table();
+	for (int index : getItemTypeNames().findPrefix(prefix))
+		arr.add(&Engine::itemTypes[index]);
+	return arr;
 }
 
 int items::getCount() {
-	int count = 0;
-	for (int i = 0; i < maxNumberOfItems; i++) {
-		if ((&Engine::items[i])->active) count++;
-	}
-	return count;
+	activeItems.prune([](int i) { return Engine::items[i].active; });
+	return activeItems.size();
 }
 
 sol::table items::getAll() {
-	auto arr = lua->create_table();
-	for (int i = 0; i < maxNumberOfItems; i++) {
-		auto item = &Engine::items[i];
-		if (!item->active) continue;
-		arr.add(item);
+	activeItems.prune([](int i) { return Engine::items[i].active; });
+	auto arr = lua->create_table(activeItems.size(), 0);
+	for (int i : activeItems) {
+		arr.add(&Engine::items[i]);
 	}
 	return arr;
 }
 
+static Item* nextItem(sol::object, Item* previous) {
+	return nextInSet(activeItems, Engine::items, previous,
+	                 [](const Item&) { return true; });
+}
+
+EntityIterator<Item> items::each() { return iterate(nextItem); }
+
 Item* items::getByIndex(sol::table self, unsigned int idx) {
 	if (idx >= maxNumberOfItems) throw std::invalid_argument(errorOutOfRange);
 	return &Engine::items[idx];
@@ -446,8 +1318,9 @@ Item* items::createVel(ItemType* type, Vector* pos, Vector* vel,
 		throw std::invalid_argument("Cannot create item with nil type");
 	}
 
-	subhook::ScopedHookRemove remove(&Hooks::createItemHook);
-	int id = Engine::createItem(type->getIndex(), pos, vel, rot);
+	int id = Hooks::createItemHook.callOriginal(
+	    Engine::createItem, type->getIndex(), pos, vel, rot);
+	if (id != -1) trackCreated(SpatialHash::Items, id);
 
 	if (id != -1 && itemDataTables[id]) {
 		delete itemDataTables[id];
@@ -459,6 +1332,7 @@ Item* items::createVel(ItemType* type, Vector* pos, Vector* vel,
 
 Item* items::createRope(Vector* pos, RotMatrix* rot) {
 	int id = Engine::createRope(pos, rot);
+	if (id != -1) trackCreated(SpatialHash::Items, id);
 	return id == -1 ? nullptr : &Engine::items[id];
 }
 
@@ -478,34 +1352,63 @@ VehicleType* vehicleTypes::getByIndex(sol::table self, unsigned int idx) {
 	return &Engine::vehicleTypes[idx];
 }
 
-VehicleType* vehicleTypes::getByName(const char* name) {
-	for (int i = 0; i < maxNumberOfVehicleTypes; i++) {
-		VehicleType* type = &Engine::vehicleTypes[i];
-		if (!std::strcmp(name, type->name)) {
-			return type;
-		}
-	}
-	return nullptr;
+static const NameIndex& getVehicleTypeNames() {
+	return getTypeNames(vehicleTypeNames, Engine::vehicleTypes,
+	                    maxNumberOfVehicleTypes);
+}
+
+VehicleType* vehicleTypes::getByName(std::string_view name,
+                                     sol::optional<bool> ignoreCase) {
+	int index = getVehicleTypeNames().find(name, ignoreCase.value_or(false));
+	return index == -1 ? nullptr : &Engine::vehicleTypes[index];
+}
+
+sol::table vehicleTypes::findByPrefix(std::string_view prefix) {
+	auto arr = lua->create_table();
+	for (int index : getVehicleTypeNames().findPrefix(prefix))
+		arr.add(&Engine::vehicleTypes[index]);
+	return arr;
 }
 
 int vehicles::getCount() {
-	int count = 0;
-	for (int i = 0; i < maxNumberOfVehicles; i++) {
-		if ((&Engine::vehicles[i])->active) count++;
-	}
-	return count;
+	activeVehicles.prune([](int i) { return Engine::vehicles[i].active; });
+	return activeVehicles.size();
 }
 
 sol::table vehicles::getAll() {
-	auto arr = lua->create_table();
-	for (int i = 0; i < maxNumberOfVehicles; i++) {
-		auto vcl = &Engine::vehicles[i];
-		if (!vcl->active) continue;
-		arr.add(vcl);
+	activeVehicles.prune([](int i) { return Engine::vehicles[i].active; });
+	auto arr = lua->create_table(activeVehicles.size(), 0);
+	for (int i : activeVehicles) {
+		arr.add(&Engine::vehicles[i]);
 	}
 	return arr;
 }
 
+static Vehicle* nextVehicle(sol::object, Vehicle* previous) {
+	return nextInSet(activeVehicles, Engine::vehicles, previous,
+	                 [](const Vehicle&) { return true; });
+}
+
+static Vehicle* nextTrafficVehicle(sol::object, Vehicle* previous) {
+	return nextInSet(activeVehicles, Engine::vehicles, previous,
+	                 [](const Vehicle& vcl) { return vcl.trafficCarID != -1; });
+}
+
+static Vehicle* nextNonTrafficVehicle(sol::object, Vehicle* previous) {
+	return nextInSet(activeVehicles, Engine::vehicles, previous,
+	                 [](const Vehicle& vcl) { return vcl.trafficCarID == -1; });
+}
+
+EntityIterator<Vehicle> vehicles::each() { return iterate(nextVehicle); }
+
+EntityIterator<Vehicle> vehicles::eachTraffic() {
+	return iterate(nextTrafficVehicle);
+}
+
+EntityIterator<Vehicle> vehicles::eachNonTraffic() {
+	return iterate(nextNonTrafficVehicle);
+}
+
 sol::table vehicles::getNonTrafficCars() {
 	auto arr = lua->create_table();
 	for (int i = 0; i < maxNumberOfVehicles; i++) {
@@ -542,8 +1445,9 @@ Vehicle* vehicles::createVel(VehicleType* type, Vector* pos, Vector* vel,
 		throw std::invalid_argument("Cannot create vehicle with nil type");
 	}
 
-	subhook::ScopedHookRemove remove(&Hooks::createVehicleHook);
-	int id = Engine::createVehicle(type->getIndex(), pos, vel, rot, color);
+	int id = Hooks::createVehicleHook.callOriginal(
+	    Engine::createVehicle, type->getIndex(), pos, vel, rot, color);
+	if (id != -1) trackCreated(SpatialHash::Vehicles, id);
 
 	if (id != -1 && vehicleDataTables[id]) {
 		delete vehicleDataTables[id];
@@ -562,8 +1466,7 @@ Event* chat::tellAdmins(const char* message) {
 }
 
 void accounts::save() {
-	subhook::ScopedHookRemove remove(&Hooks::saveAccountsServerHook);
-	Engine::saveAccountsServer();
+	Hooks::saveAccountsServerHook.callOriginal(Engine::saveAccountsServer);
 }
 
 int accounts::getCount() {
@@ -586,13 +1489,47 @@ sol::table accounts::getAll() {
 	return arr;
 }
 
-Account* accounts::getByPhone(int phone) {
-	for (int i = 0;; i++) {
-		Account* acc = &Engine::accounts[i];
-		if (!acc->subRosaID) break;
-		if (acc->phoneNumber == phone) return acc;
+template <typename Key, typename GetKey>
+static Account* findAccount(LookupIndex<Key>& lookup, const Key& key,
+                            GetKey getKey) {
+	if (!accountLookupsEnabled) {
+		accountLookupsEnabled = true;
+		invalidateAccountLookups();
+		Hooks::updateInstalledHooks();
 	}
-	return nullptr;
+
+	int index = lookup.find(
+	    key,
+	    [getKey](auto add) {
+		    for (int i = 0; i < maxNumberOfAccounts; i++) {
+			    const Account& acc = Engine::accounts[i];
+			    if (!acc.subRosaID) break;
+			    add(getKey(acc), i);
+		    }
+	    },
+	    [getKey](int i, const Key& key) {
+		    const Account& acc = Engine::accounts[i];
+		    return acc.subRosaID && getKey(acc) == key;
+	    });
+	return index == -1 ? nullptr : &Engine::accounts[index];
+}
+
+Account* accounts::getByPhone(int phone) {
+	return findAccount(accountPhoneLookup, phone,
+	                   [](const Account& acc) { return acc.phoneNumber; });
+}
+
+Account* accounts::getBySteamID(std::string steamID) {
+	return findAccount(accountSteamIDLookup, std::stoll(steamID),
+	                   [](const Account& acc) { return acc.steamID; });
+}
+
+Account* accounts::getByName(std::string_view name) {
+	return findAccount(accountNameLookup, std::string(name),
+	                   [](const Account& acc) {
+		                   return std::string(acc.name,
+		                                      strnlen(acc.name, sizeof(acc.name)));
+	                   });
 }
 
 Account* accounts::getByIndex(sol::table self, unsigned int idx) {
@@ -618,6 +1555,25 @@ sol::table players::getAll() {
 	return arr;
 }
 
+static Player* nextPlayer(sol::object, Player* previous) {
+	return nextInArray(Engine::players, maxNumberOfPlayers, previous,
+	                   [](const Player& ply) { return ply.active; });
+}
+
+static Player* nextNonBotPlayer(sol::object, Player* previous) {
+	return nextInArray(Engine::players, maxNumberOfPlayers, previous,
+	                   [](const Player& ply) {
+		                   return ply.active && ply.subRosaID && !ply.isBot;
+	                   });
+}
+
+EntityIterator<Player> players::each() { return iterate(nextPlayer); }
+
+EntityIterator<Player> players::eachNonBot() {
+	return iterate(nextNonBotPlayer);
+}
+
+// There are few enough players that a scan beats keeping an index up to date
 Player* players::getByPhone(int phone) {
 	for (int i = 0; i < maxNumberOfPlayers; i++) {
 		auto ply = &Engine::players[i];
@@ -627,6 +1583,16 @@ Player* players::getByPhone(int phone) {
 	return nullptr;
 }
 
+Player* players::getByName(std::string_view name) {
+	for (int i = 0; i < maxNumberOfPlayers; i++) {
+		auto ply = &Engine::players[i];
+		if (!ply->active) continue;
+		std::string_view plyName(ply->name, strnlen(ply->name, sizeof(ply->name)));
+		if (plyName == name) return ply;
+	}
+	return nullptr;
+}
+
 sol::table players::getNonBots() {
 	auto arr = lua->create_table();
 	for (int i = 0; i < maxNumberOfPlayers; i++) {
@@ -653,8 +1619,7 @@ Player* players::getByIndex(sol::table self, unsigned int idx) {
 }
 
 Player* players::createBot() {
-	subhook::ScopedHookRemove remove(&Hooks::createPlayerHook);
-	int playerID = Engine::createPlayer();
+	int playerID = Hooks::createPlayerHook.callOriginal(Engine::createPlayer);
 	if (playerID == -1) return nullptr;
 
 	if (playerDataTables[playerID]) {
@@ -671,23 +1636,26 @@ Player* players::createBot() {
 }
 
 int humans::getCount() {
-	int count = 0;
-	for (int i = 0; i < maxNumberOfHumans; i++) {
-		if ((&Engine::humans[i])->active) count++;
-	}
-	return count;
+	activeHumans.prune([](int i) { return Engine::humans[i].active; });
+	return activeHumans.size();
 }
 
 sol::table humans::getAll() {
-	auto arr = lua->create_table();
-	for (int i = 0; i < maxNumberOfHumans; i++) {
-		auto man = &Engine::humans[i];
-		if (!man->active) continue;
-		arr.add(man);
+	activeHumans.prune([](int i) { return Engine::humans[i].active; });
+	auto arr = lua->create_table(activeHumans.size(), 0);
+	for (int i : activeHumans) {
+		arr.add(&Engine::humans[i]);
 	}
 	return arr;
 }
 
+static Human* nextHuman(sol::object, Human* previous) {
+	return nextInSet(activeHumans, Engine::humans, previous,
+	                 [](const Human&) { return true; });
+}
+
+EntityIterator<Human> humans::each() { return iterate(nextHuman); }
+
 Human* humans::getByIndex(sol::table self, unsigned int idx) {
 	if (idx >= maxNumberOfHumans) throw std::invalid_argument(errorOutOfRange);
 	return &Engine::humans[idx];
@@ -696,15 +1664,13 @@ Human* humans::getByIndex(sol::table self, unsigned int idx) {
 Human* humans::create(Vector* pos, RotMatrix* rot, Player* ply) {
 	int playerID = ply->getIndex();
 	if (ply->humanID != -1) {
-		subhook::ScopedHookRemove remove(&Hooks::deleteHumanHook);
-		Engine::deleteHuman(ply->humanID);
-	}
-	int humanID;
-	{
-		subhook::ScopedHookRemove remove(&Hooks::createHumanHook);
-		humanID = Engine::createHuman(pos, rot, playerID);
+		Hooks::deleteHumanHook.callOriginal(Engine::deleteHuman, ply->humanID);
+		trackDeleted(SpatialHash::Humans, ply->humanID);
 	}
+	int humanID = Hooks::createHumanHook.callOriginal(Engine::createHuman, pos,
+	                                                  rot, playerID);
 	if (humanID == -1) return nullptr;
+	trackCreated(SpatialHash::Humans, humanID);
 
 	if (humanDataTables[humanID]) {
 		delete humanDataTables[humanID];
@@ -729,30 +1695,35 @@ sol::table bullets::getAll() {
 }
 
 Bullet* bullets::create(int type, Vector* pos, Vector* vel, Player* ply) {
-	subhook::ScopedHookRemove remove(&Hooks::createBulletHook);
-	int bulletID = Engine::createBullet(type, pos, vel,
-	                                    ply == nullptr ? -1 : ply->getIndex());
+	int bulletID = Hooks::createBulletHook.callOriginal(
+	    Engine::createBullet, type, pos, vel,
+	    ply == nullptr ? -1 : ply->getIndex());
 	return bulletID == -1 ? nullptr : &Engine::bullets[bulletID];
 }
 
 int rigidBodies::getCount() {
-	int count = 0;
-	for (int i = 0; i < maxNumberOfRigidBodies; i++) {
-		if ((&Engine::bodies[i])->active) count++;
-	}
-	return count;
+	activeBodies.prune([](int i) { return Engine::bodies[i].active; });
+	return activeBodies.size();
 }
 
 sol::table rigidBodies::getAll() {
-	auto arr = lua->create_table();
-	for (int i = 0; i < maxNumberOfRigidBodies; i++) {
-		auto body = &Engine::bodies[i];
-		if (!body->active) continue;
-		arr.add(body);
+	activeBodies.prune([](int i) { return Engine::bodies[i].active; });
+	auto arr = lua->create_table(activeBodies.size(), 0);
+	for (int i : activeBodies) {
+		arr.add(&Engine::bodies[i]);
 	}
 	return arr;
 }
 
+static RigidBody* nextRigidBody(sol::object, RigidBody* previous) {
+	return nextInSet(activeBodies, Engine::bodies, previous,
+	                 [](const RigidBody&) { return true; });
+}
+
+EntityIterator<RigidBody> rigidBodies::each() {
+	return iterate(nextRigidBody);
+}
+
 RigidBody* rigidBodies::getByIndex(sol::table self, unsigned int idx) {
 	if (idx >= maxNumberOfRigidBodies)
 		throw std::invalid_argument(errorOutOfRange);
@@ -831,8 +1802,7 @@ TrafficCar* trafficCars::getByIndex(sol::table self, unsigned int idx) {
 }
 
 void trafficCars::createMany(int amount) {
-	subhook::ScopedHookRemove remove(&Hooks::createTrafficHook);
-	Engine::createTraffic(amount);
+	Hooks::createTrafficHook.callOriginal(Engine::createTraffic, amount);
 }
 
 int buildings::getCount() { return *Engine::numBuildings; }
@@ -868,51 +1838,51 @@ Event* events::getByIndex(sol::table self, unsigned int idx) {
 
 Event* events::createBullet(int bulletType, Vector* pos, Vector* vel,
                             Item* item) {
-	subhook::ScopedHookRemove remove(&Hooks::createEventBulletHook);
-	Engine::createEventBullet(bulletType, pos, vel,
-	                          item == nullptr ? -1 : item->getIndex());
+	Hooks::createEventBulletHook.callOriginal(
+	    Engine::createEventBullet, bulletType, pos, vel,
+	    item == nullptr ? -1 : item->getIndex());
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
 Event* events::createBulletHit(int hitType, Vector* pos, Vector* normal) {
-	subhook::ScopedHookRemove remove(&Hooks::createEventBulletHitHook);
-	Engine::createEventBulletHit(0, hitType, pos, normal);
+	Hooks::createEventBulletHitHook.callOriginal(
+	    Engine::createEventBulletHit, 0, hitType, pos, normal);
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
 Event* events::createMessage(int messageType, const char* message,
                              int speakerID, int volumeLevel) {
-	subhook::ScopedHookRemove remove(&Hooks::createEventMessageHook);
-	Engine::createEventMessage(messageType, (char*)message, speakerID,
-	                           volumeLevel);
+	Hooks::createEventMessageHook.callOriginal(
+	    Engine::createEventMessage, messageType, (char*)message, speakerID,
+	    volumeLevel);
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
 Event* events::createSound(int soundType, Vector* pos, float volume,
                            float pitch) {
-	subhook::ScopedHookRemove remove(&Hooks::createEventSoundHook);
-	Engine::createEventSound(soundType, pos, volume, pitch);
+	Hooks::createEventSoundHook.callOriginal(
+	    Engine::createEventSound, soundType, pos, volume, pitch);
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
 Event* events::createSoundItem(int soundType, Item* item, float volume,
                                float pitch) {
 	if (!item) throw std::invalid_argument(missingArgument);
-	subhook::ScopedHookRemove remove(&Hooks::createEventSoundHook);
-	Engine::createEventSoundItem(soundType, item->getIndex(), volume, pitch);
+	Hooks::createEventSoundItemHook.callOriginal(
+	    Engine::createEventSoundItem, soundType, item->getIndex(), volume, pitch);
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
 Event* events::createSoundItemSimple(int soundType, Item* item) {
 	if (!item) throw std::invalid_argument(missingArgument);
-	subhook::ScopedHookRemove remove(&Hooks::createEventSoundHook);
-	Engine::createEventSoundItem(soundType, item->getIndex(), 1.0f, 1.0f);
+	Hooks::createEventSoundItemHook.callOriginal(
+	    Engine::createEventSoundItem, soundType, item->getIndex(), 1.0f, 1.0f);
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
 Event* events::createSoundSimple(int soundType, Vector* pos) {
-	subhook::ScopedHookRemove remove(&Hooks::createEventSoundHook);
-	Engine::createEventSound(soundType, pos, 1.0f, 1.0f);
+	Hooks::createEventSoundHook.callOriginal(
+	    Engine::createEventSound, soundType, pos, 1.0f, 1.0f);
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
@@ -964,10 +1934,51 @@ void os::exitCode(int code) {
 	::exit(code);
 }
 
+template <typename T>
+static void reconcileWrite(SpatialHash::Kind kind, T* array, int count,
+                           uintptr_t address, size_t size) {
+	auto start = reinterpret_cast<uintptr_t>(array);
+	auto end = start + sizeof(T) * count;
+	if (!size || address + size <= start || address >= end) return;
+
+	int first = (std::max(address, start) - start) / sizeof(T);
+	int last = (std::min(address + size, end) - 1 - start) / sizeof(T);
+	for (int i = first; i <= last; i++) {
+		if (array[i].active)
+			trackCreated(kind, i);
+		else
+			trackDeleted(kind, i);
+	}
+}
+
+// Raw writes can activate or deactivate entities without going through any
+// hook, so a write into one of the tracked arrays re-checks the entities it
+// touched against their active flags.
+static void reconcileEntityWrite(uintptr_t address, size_t size) {
+	reconcileWrite(SpatialHash::Humans, Engine::humans, maxNumberOfHumans,
+	               address, size);
+	reconcileWrite(SpatialHash::Items, Engine::items, maxNumberOfItems, address,
+	               size);
+	reconcileWrite(SpatialHash::Vehicles, Engine::vehicles, maxNumberOfVehicles,
+	               address, size);
+	reconcileWrite(SpatialHash::RigidBodies, Engine::bodies,
+	               maxNumberOfRigidBodies, address, size);
+}
+
 uintptr_t memory::baseAddress;
 
 uintptr_t memory::getBaseAddress() { return baseAddress; }
 
+uintptr_t memory::getAddressOfVector(Vector* address) {
+	if (!address) throw std::invalid_argument(missingArgument);
+	return (uintptr_t)address;
+}
+
+uintptr_t memory::getAddressOfRotMatrix(RotMatrix* address) {
+	if (!address) throw std::invalid_argument(missingArgument);
+	return (uintptr_t)address;
+}
+
 uintptr_t memory::getAddressOfConnection(Connection* address) {
 	if (!address) throw std::invalid_argument(missingArgument);
 	return (uintptr_t)address;
@@ -1138,37 +2149,48 @@ std::string memory::readBytes(uintptr_t address, size_t count) {
 
 void memory::writeByte(uintptr_t address, int8_t data) {
 	*(int8_t*)address = data;
+	reconcileEntityWrite(address, sizeof(data));
 }
 void memory::writeUByte(uintptr_t address, uint8_t data) {
 	*(uint8_t*)address = data;
+	reconcileEntityWrite(address, sizeof(data));
 }
 void memory::writeShort(uintptr_t address, int16_t data) {
 	*(int16_t*)address = data;
+	reconcileEntityWrite(address, sizeof(data));
 }
 void memory::writeUShort(uintptr_t address, uint16_t data) {
 	*(uint16_t*)address = data;
+	reconcileEntityWrite(address, sizeof(data));
 }
 void memory::writeInt(uintptr_t address, int32_t data) {
 	*(int32_t*)address = data;
+	reconcileEntityWrite(address, sizeof(data));
 }
 void memory::writeUInt(uintptr_t address, uint32_t data) {
 	*(uint32_t*)address = data;
+	reconcileEntityWrite(address, sizeof(data));
 }
 void memory::writeLong(uintptr_t address, int64_t data) {
 	*(int64_t*)address = data;
+	reconcileEntityWrite(address, sizeof(data));
 }
 void memory::writeULong(uintptr_t address, uint64_t data) {
 	*(uint64_t*)address = data;
+	reconcileEntityWrite(address, sizeof(data));
 }
 void memory::writeFloat(uintptr_t address, float data) {
 	*(float*)address = data;
+	reconcileEntityWrite(address, sizeof(data));
 }
 void memory::writeDouble(uintptr_t address, double data) {
 	*(double*)address = data;
+	reconcileEntityWrite(address, sizeof(data));
 }
 
 void memory::writeBytes(uintptr_t address, std::string_view bytes) {
 	std::memcpy((void*)address, bytes.data(), bytes.size());
+	reconcileEntityWrite(address, bytes.size());
 }
 
 };  // namespace Lua
@@ -1267,6 +2289,11 @@ int Account::getIndex() const {
 	return ((uintptr_t)this - (uintptr_t)Engine::accounts) / sizeof(*this);
 }
 
+void Account::setPhoneNumber(int number) {
+	phoneNumber = number;
+	invalidateAccountLookups();
+}
+
 sol::table Account::getDataTable() const {
 	int index = getIndex();
 
@@ -1322,6 +2349,24 @@ void Vector::add(Vector* other) {
 	z += other->z;
 }
 
+void Vector::subInPlace(Vector* other) {
+	if (!other) throw std::invalid_argument(missingArgument);
+	x -= other->x;
+	y -= other->y;
+	z -= other->z;
+}
+
+void Vector::rotateInPlace(RotMatrix* rot) {
+	if (!rot) throw std::invalid_argument(missingArgument);
+	*this = __mul_RotMatrix(rot);
+}
+
+void Vector::lerpInto(Vector* other, float t, Vector* out) const {
+	if (!other || !out) throw std::invalid_argument(missingArgument);
+	*out = {x + (other->x - x) * t, y + (other->y - y) * t,
+	        z + (other->z - z) * t};
+}
+
 void Vector::mult(float scalar) {
 	x *= scalar;
 	y *= scalar;
@@ -1398,6 +2443,11 @@ RotMatrix RotMatrix::__mul(RotMatrix* other) const {
 	        x3 * other->z1 + y3 * other->z2 + z3 * other->z3};
 }
 
+void RotMatrix::mulInPlace(RotMatrix* other) {
+	if (!other) throw std::invalid_argument(missingArgument);
+	*this = __mul(other);
+}
+
 void RotMatrix::set(RotMatrix* other) {
 	if (!other) throw std::invalid_argument(missingArgument);
 	x1 = other->x1;
@@ -1461,8 +2511,8 @@ sol::table Player::getDataTable() const {
 }
 
 Event* Player::update() const {
-	subhook::ScopedHookRemove remove(&Hooks::createEventUpdatePlayerHook);
-	Engine::createEventUpdatePlayer(getIndex());
+	Hooks::createEventUpdatePlayerHook.callOriginal(
+	    Engine::createEventUpdatePlayer, getIndex());
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
@@ -1474,8 +2524,7 @@ Event* Player::updateFinance() const {
 void Player::remove() const {
 	int index = getIndex();
 
-	subhook::ScopedHookRemove remove(&Hooks::deletePlayerHook);
-	Engine::deletePlayer(index);
+	Hooks::deletePlayerHook.callOriginal(Engine::deletePlayer, index);
 
 	if (playerDataTables[index]) {
 		delete playerDataTables[index];
@@ -1484,8 +2533,8 @@ void Player::remove() const {
 }
 
 void Player::sendMessage(const char* message) const {
-	subhook::ScopedHookRemove remove(&Hooks::createEventMessageHook);
-	Engine::createEventMessage(6, (char*)message, getIndex(), 0);
+	Hooks::createEventMessageHook.callOriginal(
+	    Engine::createEventMessage, 6, (char*)message, getIndex(), 0);
 }
 
 Human* Player::getHuman() const {
@@ -1553,6 +2602,14 @@ int Human::getIndex() const {
 	return ((uintptr_t)this - (uintptr_t)Engine::humans) / sizeof(*this);
 }
 
+void Human::setIsActive(bool b) {
+	active = b;
+	if (b)
+		trackCreated(SpatialHash::Humans, getIndex());
+	else
+		trackDeleted(SpatialHash::Humans, getIndex());
+}
+
 sol::table Human::getDataTable() const {
 	int index = getIndex();
 
@@ -1566,8 +2623,8 @@ sol::table Human::getDataTable() const {
 void Human::remove() const {
 	int index = getIndex();
 
-	subhook::ScopedHookRemove remove(&Hooks::deleteHumanHook);
-	Engine::deleteHuman(index);
+	Hooks::deleteHumanHook.callOriginal(Engine::deleteHuman, index);
+	trackDeleted(SpatialHash::Humans, index);
 
 	if (humanDataTables[index]) {
 		delete humanDataTables[index];
@@ -1623,8 +2680,8 @@ void Human::teleport(Vector* vec) {
 };
 
 void Human::speak(const char* message, int distance) const {
-	subhook::ScopedHookRemove remove(&Hooks::createEventMessageHook);
-	Engine::createEventMessage(1, (char*)message, getIndex(), distance);
+	Hooks::createEventMessageHook.callOriginal(
+	    Engine::createEventMessage, 1, (char*)message, getIndex(), distance);
 }
 
 void Human::arm(int weapon, int magCount) const {
@@ -1664,13 +2721,13 @@ void Human::addVelocity(Vector* vel) const {
 }
 
 bool Human::mountItem(Item* childItem, unsigned int slot) const {
-	subhook::ScopedHookRemove remove(&Hooks::linkItemHook);
-	return Engine::linkItem(childItem->getIndex(), -1, getIndex(), slot);
+	return Hooks::linkItemHook.callOriginal(
+	    Engine::linkItem, childItem->getIndex(), -1, getIndex(), slot);
 }
 
 void Human::applyDamage(int bone, int damage) const {
-	subhook::ScopedHookRemove remove(&Hooks::humanApplyDamageHook);
-	Engine::humanApplyDamage(getIndex(), bone, 0, damage);
+	Hooks::humanApplyDamageHook.callOriginal(
+	    Engine::humanApplyDamage, getIndex(), bone, 0, damage);
 }
 
 std::string ItemType::__tostring() const {
@@ -1683,6 +2740,11 @@ int ItemType::getIndex() const {
 	return ((uintptr_t)this - (uintptr_t)Engine::itemTypes) / sizeof(*this);
 }
 
+void ItemType::setName(const char* newName) {
+	std::strncpy(name, newName, sizeof(name) - 1);
+	invalidateTypeNames();
+}
+
 bool ItemType::getCanMountTo(ItemType* parent) const {
 	if (parent == nullptr) {
 		throw std::invalid_argument("Cannot compare to nil parent");
@@ -1709,6 +2771,14 @@ int Item::getIndex() const {
 	return ((uintptr_t)this - (uintptr_t)Engine::items) / sizeof(*this);
 }
 
+void Item::setIsActive(bool b) {
+	active = b;
+	if (b)
+		trackCreated(SpatialHash::Items, getIndex());
+	else
+		trackDeleted(SpatialHash::Items, getIndex());
+}
+
 sol::table Item::getDataTable() const {
 	int index = getIndex();
 
@@ -1732,8 +2802,8 @@ void Item::setType(ItemType* itemType) {
 void Item::remove() const {
 	int index = getIndex();
 
-	subhook::ScopedHookRemove remove(&Hooks::deleteItemHook);
-	Engine::deleteItem(index);
+	Hooks::deleteItemHook.callOriginal(Engine::deleteItem, index);
+	trackDeleted(SpatialHash::Items, index);
 
 	if (itemDataTables[index]) {
 		delete itemDataTables[index];
@@ -1790,39 +2860,39 @@ void Item::setVehicle(Vehicle* vehicle) {
 }
 
 bool Item::mountItem(Item* childItem, unsigned int slot) const {
-	subhook::ScopedHookRemove remove(&Hooks::linkItemHook);
-	return Engine::linkItem(getIndex(), childItem->getIndex(), -1, slot);
+	return Hooks::linkItemHook.callOriginal(
+	    Engine::linkItem, getIndex(), childItem->getIndex(), -1, slot);
 }
 
 bool Item::unmount() const {
-	subhook::ScopedHookRemove remove(&Hooks::linkItemHook);
-	return Engine::linkItem(getIndex(), -1, -1, 0);
+	return Hooks::linkItemHook.callOriginal(
+	    Engine::linkItem, getIndex(), -1, -1, 0);
 }
 
 Event* Item::update() const {
-	subhook::ScopedHookRemove remove(&Hooks::createEventUpdateItemInfoHook);
-	Engine::createEventUpdateItemInfo(getIndex());
+	Hooks::createEventUpdateItemInfoHook.callOriginal(
+	    Engine::createEventUpdateItemInfo, getIndex());
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
 void Item::speak(const char* message, int distance) const {
-	subhook::ScopedHookRemove remove(&Hooks::createEventMessageHook);
-	Engine::createEventMessage(2, (char*)message, getIndex(), distance);
+	Hooks::createEventMessageHook.callOriginal(
+	    Engine::createEventMessage, 2, (char*)message, getIndex(), distance);
 }
 
 void Item::explode() const {
-	subhook::ScopedHookRemove remove(&Hooks::grenadeExplosionHook);
-	Engine::grenadeExplosion(getIndex());
+	Hooks::grenadeExplosionHook.callOriginal(
+	    Engine::grenadeExplosion, getIndex());
 }
 
 void Item::sound(int soundType, float volume, float pitch) const {
-	subhook::ScopedHookRemove remove(&Hooks::createEventSoundItemHook);
-	Engine::createEventSoundItem(soundType, getIndex(), volume, pitch);
+	Hooks::createEventSoundItemHook.callOriginal(
+	    Engine::createEventSoundItem, soundType, getIndex(), volume, pitch);
 }
 
 void Item::soundSimple(int soundType) const {
-	subhook::ScopedHookRemove remove(&Hooks::createEventSoundItemHook);
-	Engine::createEventSoundItem(soundType, getIndex(), 1.0f, 1.0f);
+	Hooks::createEventSoundItemHook.callOriginal(
+	    Engine::createEventSoundItem, soundType, getIndex(), 1.0f, 1.0f);
 }
 
 void Item::setMemo(const char* memo) const {
@@ -1877,6 +2947,11 @@ int VehicleType::getIndex() const {
 	return ((uintptr_t)this - (uintptr_t)Engine::vehicleTypes) / sizeof(*this);
 }
 
+void VehicleType::setName(const char* newName) {
+	std::strncpy(name, newName, sizeof(name) - 1);
+	invalidateTypeNames();
+}
+
 std::string Vehicle::__tostring() const {
 	char buf[16];
 	sprintf(buf, "Vehicle(%i)", getIndex());
@@ -1887,6 +2962,14 @@ int Vehicle::getIndex() const {
 	return ((uintptr_t)this - (uintptr_t)Engine::vehicles) / sizeof(*this);
 }
 
+void Vehicle::setIsActive(bool b) {
+	active = b;
+	if (b)
+		trackCreated(SpatialHash::Vehicles, getIndex());
+	else
+		trackDeleted(SpatialHash::Vehicles, getIndex());
+}
+
 VehicleType* Vehicle::getType() { return &Engine::vehicleTypes[type]; }
 
 void Vehicle::setType(VehicleType* vehicleType) {
@@ -1914,16 +2997,17 @@ Event* Vehicle::updateType() const {
 
 Event* Vehicle::updateDestruction(int updateType, int partID, Vector* pos,
                                   Vector* normal) const {
-	subhook::ScopedHookRemove remove(&Hooks::createEventUpdateVehicleHook);
-	Engine::createEventUpdateVehicle(getIndex(), updateType, partID, pos, normal);
+	Hooks::createEventUpdateVehicleHook.callOriginal(
+	    Engine::createEventUpdateVehicle, getIndex(), updateType, partID, pos,
+	    normal);
 	return &Engine::events[*Engine::numEvents - 1];
 }
 
 void Vehicle::remove() const {
 	int index = getIndex();
 
-	subhook::ScopedHookRemove remove(&Hooks::deleteVehicleHook);
-	Engine::deleteVehicle(index);
+	Hooks::deleteVehicleHook.callOriginal(Engine::deleteVehicle, index);
+	trackDeleted(SpatialHash::Vehicles, index);
 
 	if (vehicleDataTables[index]) {
 		delete vehicleDataTables[index];
@@ -1978,6 +3062,14 @@ int RigidBody::getIndex() const {
 	return ((uintptr_t)this - (uintptr_t)Engine::bodies) / sizeof(*this);
 }
 
+void RigidBody::setIsActive(bool b) {
+	active = b;
+	if (b)
+		trackCreated(SpatialHash::RigidBodies, getIndex());
+	else
+		trackDeleted(SpatialHash::RigidBodies, getIndex());
+}
+
 sol::table RigidBody::getDataTable() const {
 	int index = getIndex();
 
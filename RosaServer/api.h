@@ -4,12 +4,15 @@
 #include <queue>
 #include <thread>
 
+#include "activeset.h"
 #include "engine.h"
 #include "hooks.h"
+#include "httppool.h"
+#include "lookupindex.h"
+#include "nameindex.h"
 #include "sol/sol.hpp"
-
-#define CPPHTTPLIB_OPENSSL_SUPPORT
-#include "../cpp-httplib/httplib.h"
+#include "spatialhash.h"
+#include "worlddelta.h"
 
 #define LUA_ENTRY_FILE "main/init.lua"
 #define LUA_PREFIX "\033[34;1;4m[RosaServer/Lua]\033[0m "
@@ -34,25 +37,18 @@ extern sol::table* itemDataTables[maxNumberOfItems];
 extern sol::table* vehicleDataTables[maxNumberOfVehicles];
 extern sol::table* bodyDataTables[maxNumberOfRigidBodies];
 
-enum LuaRequestType { get, post };
+extern ActiveSet activeHumans;
+extern ActiveSet activeItems;
+extern ActiveSet activeVehicles;
+extern ActiveSet activeBodies;
 
-struct LuaHTTPRequest {
-	LuaRequestType type;
-	std::string scheme;
-	std::string path;
-	std::shared_ptr<sol::protected_function> callback;
-	std::string contentType;
-	std::string body;
-	httplib::Headers headers;
-};
+extern SpatialHash spatialHash;
+extern WorldDelta worldDelta;
 
-struct LuaHTTPResponse {
-	std::shared_ptr<sol::protected_function> callback;
-	bool responded;
-	int status;
-	std::string body;
-	httplib::Headers headers;
-};
+// Keeps the account creation hook installed once accounts have been looked up
+extern bool accountLookupsEnabled;
+void invalidateAccountLookups();
+void invalidateTypeNames();
 
 extern std::mutex stateResetMutex;
 
@@ -60,6 +56,20 @@ void printLuaError(sol::error* err);
 bool noLuaCallError(sol::protected_function_result* res);
 bool noLuaCallError(sol::load_result* res);
 void hookAndReset(int reason);
+void rebuildActiveSets();
+void updateSpatialHash();
+// Called by the create/delete hooks and by the Lua API, which calls the
+// originals directly
+void trackCreated(SpatialHash::Kind kind, int index);
+void trackDeleted(SpatialHash::Kind kind, int index);
+void setTableVector(sol::table& table, const char* key, const Vector& vector);
+
+// Returned by the each functions to be used in a generic for. The iterator
+// takes the previous entity as its control variable, so it holds no state.
+template <typename T>
+using EntityIterator =
+    std::tuple<sol::as_function_reference<T* (*)(sol::object, T*)>, sol::nil_t,
+               sol::nil_t>;
 
 void defineThreadSafeAPIs(sol::state* state);
 void luaInit(bool redo = false);
@@ -79,20 +89,53 @@ sol::object getSync(const char* scheme, const char* path, sol::table headers,
 sol::object postSync(const char* scheme, const char* path, sol::table headers,
                      std::string body, const char* contentType,
                      sol::this_state s);
+sol::object get(std::string scheme, std::string path, sol::table headers,
+                sol::protected_function callback,
+                sol::optional<sol::table> options, sol::this_state s);
+sol::object post(std::string scheme, std::string path, sol::table headers,
+                 std::string body, std::string contentType,
+                 sol::protected_function callback,
+                 sol::optional<sol::table> options, sol::this_state s);
+bool cancel(unsigned int id);
+size_t getPending();
+sol::table getPoolStats(sol::this_state s);
+void setPoolLimits(int maxSize, int idleTimeout);
+void dispatchResponses();
+void clearCallbacks();
 };  // namespace http
 
 namespace hook {
 bool enable(std::string name);
 bool disable(std::string name);
 void clear();
+bool registerCallback(std::string name, sol::protected_function func);
+bool observe(std::string name, sol::protected_function func);
+bool unregisterCallback(std::string name);
+sol::table getStats();
+void setStatsEnabled(bool enabled);
+void resetStats();
+void startTrace(std::string path);
+unsigned long long stopTrace();
+sol::table getTrampolineStats();
 };  // namespace hook
 
+namespace tickProfiler {
+void setEnabled(bool enabled);
+double getBudget();
+void setBudget(double milliseconds);
+void setCapacity(size_t capacity);
+sol::table getTicks();
+sol::table getStats();
+};  // namespace tickProfiler
+
 namespace physics {
-sol::table lineIntersectLevel(Vector* posA, Vector* posB, bool onlyCity);
+sol::table lineIntersectLevel(Vector* posA, Vector* posB, bool onlyCity,
+                              sol::optional<sol::table> out);
 sol::table lineIntersectHuman(Human* man, Vector* posA, Vector* posB,
-                              float padding);
+                              float padding, sol::optional<sol::table> out);
 sol::table lineIntersectVehicle(Vehicle* vcl, Vector* posA, Vector* posB,
-                                bool includeWheels);
+                                bool includeWheels,
+                                sol::optional<sol::table> out);
 sol::object lineIntersectLevelQuick(Vector* posA, Vector* posB, bool onlyCity,
                                     sol::this_state s);
 sol::object lineIntersectHumanQuick(Human* man, Vector* posA, Vector* posB,
@@ -102,6 +145,21 @@ sol::object lineIntersectVehicleQuick(Vehicle* vcl, Vector* posA, Vector* posB,
 std::tuple<sol::object, sol::object> lineIntersectAnyQuick(
     Vector* posA, Vector* posB, Human* ignoreHuman, float humanPadding,
     bool includeWheels, sol::this_state s);
+enum RaycastFlags : unsigned int {
+	RaycastLevel = 1 << 0,
+	RaycastHumans = 1 << 1,
+	RaycastVehicles = 1 << 2,
+	RaycastWheels = 1 << 3,
+	RaycastOnlyCity = 1 << 4
+};
+// Casts every {posA, posB} pair in rays, writing {hit, fraction, object} for
+// each into out so the tables can be reused between batches.
+sol::table raycastBatch(sol::table rays, unsigned int flags,
+                        sol::optional<sol::table> out);
+// Counts of the candidates lineIntersectAnyQuick and raycastBatch tested or
+// culled.
+sol::table getBroadPhaseStats();
+void resetBroadPhaseStats();
 sol::object lineIntersectTriangle(Vector* outPos, Vector* normal, Vector* posA,
                                   Vector* posB, Vector* triA, Vector* triB,
                                   Vector* triC, sol::this_state s);
@@ -111,16 +169,40 @@ unsigned int getBlock(int blockX, int blockY, int blockZ);
 void deleteBlock(int blockX, int blockY, int blockZ);
 };  // namespace physics
 
+namespace world {
+void saveSnapshot(std::string path);
+void loadSnapshot(std::string path);
+};  // namespace world
+
+namespace worldDelta {
+void setEnabled(bool enabled);
+void reset();
+void setCapacity(size_t capacity);
+sol::object receive(sol::this_state s);
+size_t getQueued();
+};  // namespace worldDelta
+
+namespace spatial {
+SpatialQuery queryRadius(Vector* pos, float radius,
+                         sol::optional<unsigned int> kinds);
+SpatialQuery nearest(Vector* pos, sol::optional<unsigned int> kinds,
+                     sol::optional<unsigned int> count);
+SpatialQuery queryBox(Vector* min, Vector* max,
+                      sol::optional<unsigned int> kinds);
+};  // namespace spatial
+
 namespace itemTypes {
 int getCount();
 sol::table getAll();
 ItemType* getByIndex(sol::table self, unsigned int idx);
-ItemType* getByName(const char* name);
+ItemType* getByName(std::string_view name, sol::optional<bool> ignoreCase);
+sol::table findByPrefix(std::string_view prefix);
 };  // namespace itemTypes
 
 namespace items {
 int getCount();
 sol::table getAll();
+EntityIterator<Item> each();
 Item* getByIndex(sol::table self, unsigned int idx);
 Item* create(ItemType* type, Vector* pos, RotMatrix* rot);
 Item* createVel(ItemType* typee, Vector* pos, Vector* vel, RotMatrix* rot);
@@ -131,12 +213,16 @@ namespace vehicleTypes {
 int getCount();
 sol::table getAll();
 VehicleType* getByIndex(sol::table self, unsigned int idx);
-VehicleType* getByName(const char* name);
+VehicleType* getByName(std::string_view name, sol::optional<bool> ignoreCase);
+sol::table findByPrefix(std::string_view prefix);
 };  // namespace vehicleTypes
 
 namespace vehicles {
 int getCount();
 sol::table getAll();
+EntityIterator<Vehicle> each();
+EntityIterator<Vehicle> eachTraffic();
+EntityIterator<Vehicle> eachNonTraffic();
 sol::table getNonTrafficCars();
 sol::table getTrafficCars();
 Vehicle* getByIndex(sol::table self, unsigned int idx);
@@ -155,13 +241,18 @@ void save();
 int getCount();
 sol::table getAll();
 Account* getByPhone(int phone);
+Account* getBySteamID(std::string steamID);
+Account* getByName(std::string_view name);
 Account* getByIndex(sol::table self, unsigned int idx);
 };  // namespace accounts
 
 namespace players {
 int getCount();
 sol::table getAll();
+EntityIterator<Player> each();
+EntityIterator<Player> eachNonBot();
 Player* getByPhone(int phone);
+Player* getByName(std::string_view name);
 sol::table getNonBots();
 sol::table getBots();
 Player* getByIndex(sol::table self, unsigned int idx);
@@ -171,6 +262,7 @@ Player* createBot();
 namespace humans {
 int getCount();
 sol::table getAll();
+EntityIterator<Human> each();
 Human* getByIndex(sol::table self, unsigned int idx);
 Human* create(Vector* pos, RotMatrix* rot, Player* ply);
 };  // namespace humans
@@ -184,6 +276,7 @@ Bullet* create(int type, Vector* pos, Vector* vel, Player* ply);
 namespace rigidBodies {
 int getCount();
 sol::table getAll();
+EntityIterator<RigidBody> each();
 RigidBody* getByIndex(sol::table self, unsigned int idx);
 };  // namespace rigidBodies
 
@@ -245,6 +338,8 @@ void exitCode(int code);
 namespace memory {
 extern uintptr_t baseAddress;
 uintptr_t getBaseAddress();
+uintptr_t getAddressOfVector(Vector* address);
+uintptr_t getAddressOfRotMatrix(RotMatrix* address);
 uintptr_t getAddressOfConnection(Connection* address);
 uintptr_t getAddressOfAccount(Account* address);
 uintptr_t getAddressOfPlayer(Player* address);
@@ -0,0 +1,288 @@
+#pragma once
+#include "structs.h"
+
+// Bindings shared by RosaServer and RosaServerReplay. Only members which don't
+// call into the engine or api.cpp belong here, since the replay tool backs
+// entities with trace snapshots and doesn't link either; everything else is
+// bound by the server on top of these. That includes isActive for entities
+// with active sets, since setting it has to update them.
+
+inline void bindEntityFields(sol::usertype<Vector>& meta) {
+	meta["x"] = &Vector::x;
+	meta["y"] = &Vector::y;
+	meta["z"] = &Vector::z;
+
+	meta["class"] = sol::property(&Vector::getClass);
+}
+
+inline void bindEntityFields(sol::usertype<RotMatrix>& meta) {
+	meta["x1"] = &RotMatrix::x1;
+	meta["y1"] = &RotMatrix::y1;
+	meta["z1"] = &RotMatrix::z1;
+	meta["x2"] = &RotMatrix::x2;
+	meta["y2"] = &RotMatrix::y2;
+	meta["z2"] = &RotMatrix::z2;
+	meta["x3"] = &RotMatrix::x3;
+	meta["y3"] = &RotMatrix::y3;
+	meta["z3"] = &RotMatrix::z3;
+
+	meta["class"] = sol::property(&RotMatrix::getClass);
+}
+
+inline void bindEntityFields(sol::usertype<Connection>& meta) {
+	meta["port"] = &Connection::port;
+	meta["timeoutTime"] = &Connection::timeoutTime;
+
+	meta["class"] = sol::property(&Connection::getClass);
+	meta["adminVisible"] = sol::property(&Connection::getAdminVisible,
+	                                     &Connection::setAdminVisible);
+}
+
+inline void bindEntityFields(sol::usertype<Account>& meta) {
+	meta["subRosaID"] = &Account::subRosaID;
+	meta["money"] = &Account::money;
+	meta["corporateRating"] = &Account::corporateRating;
+	meta["criminalRating"] = &Account::criminalRating;
+	meta["spawnTimer"] = &Account::spawnTimer;
+	meta["playTime"] = &Account::playTime;
+	meta["banTime"] = &Account::banTime;
+
+	meta["class"] = sol::property(&Account::getClass);
+	meta["name"] = sol::property(&Account::getName);
+	meta["steamID"] = sol::property(&Account::getSteamID);
+}
+
+inline void bindEntityFields(sol::usertype<Player>& meta) {
+	meta["subRosaID"] = &Player::subRosaID;
+	meta["phoneNumber"] = &Player::phoneNumber;
+	meta["money"] = &Player::money;
+	meta["teamMoney"] = &Player::teamMoney;
+	meta["budget"] = &Player::budget;
+	meta["corporateRating"] = &Player::corporateRating;
+	meta["criminalRating"] = &Player::criminalRating;
+	meta["itemsBought"] = &Player::itemsBought;
+	meta["team"] = &Player::team;
+	meta["teamSwitchTimer"] = &Player::teamSwitchTimer;
+	meta["stocks"] = &Player::stocks;
+	meta["spawnTimer"] = &Player::spawnTimer;
+	meta["gearX"] = &Player::gearX;
+	meta["leftRightInput"] = &Player::leftRightInput;
+	meta["gearY"] = &Player::gearY;
+	meta["forwardBackInput"] = &Player::forwardBackInput;
+	meta["viewYawDelta"] = &Player::viewYawDelta;
+	meta["viewPitch"] = &Player::viewPitch;
+	meta["freeLookYaw"] = &Player::freeLookYaw;
+	meta["freeLookPitch"] = &Player::freeLookPitch;
+	meta["viewYaw"] = &Player::viewYaw;
+	meta["viewPitchDelta"] = &Player::viewPitchDelta;
+	meta["inputFlags"] = &Player::inputFlags;
+	meta["lastInputFlags"] = &Player::lastInputFlags;
+	meta["zoomLevel"] = &Player::zoomLevel;
+	meta["inputType"] = &Player::inputType;
+	meta["menuTab"] = &Player::menuTab;
+	meta["numActions"] = &Player::numActions;
+	meta["lastNumActions"] = &Player::lastNumActions;
+	meta["numMenuButtons"] = &Player::numMenuButtons;
+	meta["gender"] = &Player::gender;
+	meta["skinColor"] = &Player::skinColor;
+	meta["hairColor"] = &Player::hairColor;
+	meta["hair"] = &Player::hair;
+	meta["eyeColor"] = &Player::eyeColor;
+	meta["model"] = &Player::model;
+	meta["suitColor"] = &Player::suitColor;
+	meta["tieColor"] = &Player::tieColor;
+	meta["head"] = &Player::head;
+	meta["necklace"] = &Player::necklace;
+
+	meta["class"] = sol::property(&Player::getClass);
+	meta["isActive"] = sol::property(&Player::getIsActive, &Player::setIsActive);
+	meta["name"] = sol::property(&Player::getName, &Player::setName);
+	meta["isAdmin"] = sol::property(&Player::getIsAdmin, &Player::setIsAdmin);
+	meta["isReady"] = sol::property(&Player::getIsReady, &Player::setIsReady);
+	meta["isGodMode"] =
+	    sol::property(&Player::getIsGodMode, &Player::setIsGodMode);
+	meta["isBot"] = sol::property(&Player::getIsBot, &Player::setIsBot);
+	meta["isZombie"] = sol::property(&Player::getIsZombie, &Player::setIsZombie);
+}
+
+inline void bindEntityFields(sol::usertype<Human>& meta) {
+	meta["stamina"] = &Human::stamina;
+	meta["maxStamina"] = &Human::maxStamina;
+	meta["vehicleSeat"] = &Human::vehicleSeat;
+	meta["despawnTime"] = &Human::despawnTime;
+	meta["spawnProtection"] = &Human::spawnProtection;
+	meta["movementState"] = &Human::movementState;
+	meta["zoomLevel"] = &Human::zoomLevel;
+	meta["damage"] = &Human::damage;
+	meta["pos"] = &Human::pos;
+	meta["viewYaw"] = &Human::viewYaw;
+	meta["viewPitch"] = &Human::viewPitch;
+	meta["viewYaw2"] = &Human::viewYaw2;
+	meta["strafeInput"] = &Human::strafeInput;
+	meta["walkInput"] = &Human::walkInput;
+	meta["viewPitch2"] = &Human::viewPitch2;
+	meta["inputFlags"] = &Human::inputFlags;
+	meta["lastInputFlags"] = &Human::lastInputFlags;
+	meta["health"] = &Human::health;
+	meta["bloodLevel"] = &Human::bloodLevel;
+	meta["chestHP"] = &Human::chestHP;
+	meta["headHP"] = &Human::headHP;
+	meta["leftArmHP"] = &Human::leftArmHP;
+	meta["rightArmHP"] = &Human::rightArmHP;
+	meta["leftLegHP"] = &Human::leftLegHP;
+	meta["rightLegHP"] = &Human::rightLegHP;
+	meta["progressBar"] = &Human::progressBar;
+	meta["inventoryAnimationFlags"] = &Human::inventoryAnimationFlags;
+	meta["inventoryAnimationProgress"] = &Human::inventoryAnimationProgress;
+	meta["inventoryAnimationDuration"] = &Human::inventoryAnimationDuration;
+	meta["inventoryAnimationHand"] = &Human::inventoryAnimationHand;
+	meta["inventoryAnimationSlot"] = &Human::inventoryAnimationSlot;
+	meta["inventoryAnimationCounterFinished"] =
+	    &Human::inventoryAnimationCounterFinished;
+	meta["inventoryAnimationCounter"] = &Human::inventoryAnimationCounter;
+	meta["gender"] = &Human::gender;
+	meta["head"] = &Human::head;
+	meta["skinColor"] = &Human::skinColor;
+	meta["hairColor"] = &Human::hairColor;
+	meta["hair"] = &Human::hair;
+	meta["eyeColor"] = &Human::eyeColor;
+	meta["model"] = &Human::model;
+	meta["suitColor"] = &Human::suitColor;
+	meta["tieColor"] = &Human::tieColor;
+	meta["necklace"] = &Human::necklace;
+	meta["lastUpdatedWantedGroup"] = &Human::lastUpdatedWantedGroup;
+
+	meta["class"] = sol::property(&Human::getClass);
+	meta["isAlive"] = sol::property(&Human::getIsAlive, &Human::setIsAlive);
+	meta["isImmortal"] =
+	    sol::property(&Human::getIsImmortal, &Human::setIsImmortal);
+	meta["isOnGround"] = sol::property(&Human::getIsOnGround);
+	meta["isStanding"] = sol::property(&Human::getIsStanding);
+	meta["isBleeding"] =
+	    sol::property(&Human::getIsBleeding, &Human::setIsBleeding);
+}
+
+inline void bindEntityFields(sol::usertype<ItemType>& meta) {
+	meta["price"] = &ItemType::price;
+	meta["mass"] = &ItemType::mass;
+	meta["fireRate"] = &ItemType::fireRate;
+	meta["magazineAmmo"] = &ItemType::magazineAmmo;
+	meta["bulletType"] = &ItemType::bulletType;
+	meta["bulletVelocity"] = &ItemType::bulletVelocity;
+	meta["bulletSpread"] = &ItemType::bulletSpread;
+	meta["numHands"] = &ItemType::numHands;
+	meta["rightHandPos"] = &ItemType::rightHandPos;
+	meta["leftHandPos"] = &ItemType::leftHandPos;
+	meta["primaryGripStiffness"] = &ItemType::primaryGripStiffness;
+	meta["primaryGripRotation"] = &ItemType::primaryGripRotation;
+	meta["secondaryGripStiffness"] = &ItemType::secondaryGripStiffness;
+	meta["secondaryGripRotation"] = &ItemType::secondaryGripRotation;
+	meta["boundsCenter"] = &ItemType::boundsCenter;
+	meta["gunHoldingPos"] = &ItemType::gunHoldingPos;
+
+	meta["class"] = sol::property(&ItemType::getClass);
+	meta["isGun"] = sol::property(&ItemType::getIsGun, &ItemType::setIsGun);
+}
+
+inline void bindEntityFields(sol::usertype<Item>& meta) {
+	meta["physicsSettledTimer"] = &Item::physicsSettledTimer;
+	meta["despawnTime"] = &Item::despawnTime;
+	meta["parentSlot"] = &Item::parentSlot;
+	meta["pos"] = &Item::pos;
+	meta["vel"] = &Item::vel;
+	meta["rot"] = &Item::rot;
+	meta["bullets"] = &Item::bullets;
+	meta["numChildItems"] = &Item::numChildItems;
+	meta["cooldown"] = &Item::cooldown;
+	meta["cashSpread"] = &Item::cashSpread;
+	meta["cashAmount"] = &Item::cashBillAmount;
+	meta["cashPureValue"] = &Item::cashPureValue;
+	meta["phoneNumber"] = &Item::phoneNumber;
+	meta["displayPhoneNumber"] = &Item::displayPhoneNumber;
+	meta["enteredPhoneNumber"] = &Item::enteredPhoneNumber;
+	meta["phoneTexture"] = &Item::phoneTexture;
+	meta["computerCurrentLine"] = &Item::computerCurrentLine;
+	meta["computerTopLine"] = &Item::computerTopLine;
+	meta["computerCursor"] = &Item::computerCursor;
+
+	meta["class"] = sol::property(&Item::getClass);
+	meta["hasPhysics"] =
+	    sol::property(&Item::getHasPhysics, &Item::setHasPhysics);
+	meta["physicsSettled"] =
+	    sol::property(&Item::getPhysicsSettled, &Item::setPhysicsSettled);
+	meta["isStatic"] = sol::property(&Item::getIsStatic, &Item::setIsStatic);
+	meta["isInPocket"] =
+	    sol::property(&Item::getIsInPocket, &Item::setIsInPocket);
+}
+
+inline void bindEntityFields(sol::usertype<VehicleType>& meta) {
+	meta["controllableState"] = &VehicleType::controllableState;
+	meta["price"] = &VehicleType::price;
+	meta["mass"] = &VehicleType::mass;
+	meta["numWheels"] = &VehicleType::numWheels;
+
+	meta["class"] = sol::property(&VehicleType::getClass);
+	meta["usesExternalModel"] =
+	    sol::property(&VehicleType::getUsesExternalModel);
+}
+
+inline void bindEntityFields(sol::usertype<Vehicle>& meta) {
+	meta["controllableState"] = &Vehicle::controllableState;
+	meta["health"] = &Vehicle::health;
+	meta["color"] = &Vehicle::color;
+	meta["despawnTime"] = &Vehicle::despawnTime;
+	meta["pos"] = &Vehicle::pos;
+	meta["pos2"] = &Vehicle::pos2;
+	meta["rot"] = &Vehicle::rot;
+	meta["vel"] = &Vehicle::vel;
+	meta["gearX"] = &Vehicle::gearX;
+	meta["steerControl"] = &Vehicle::steerControl;
+	meta["gearY"] = &Vehicle::gearY;
+	meta["gasControl"] = &Vehicle::gasControl;
+	meta["engineRPM"] = &Vehicle::engineRPM;
+	meta["bladeBodyID"] = &Vehicle::bladeBodyID;
+	meta["numSeats"] = &Vehicle::numSeats;
+	meta["numWheels"] = &Vehicle::numWheels;
+
+	meta["class"] = sol::property(&Vehicle::getClass);
+	meta["isLocked"] =
+	    sol::property(&Vehicle::getIsLocked, &Vehicle::setIsLocked);
+}
+
+inline void bindEntityFields(sol::usertype<Bullet>& meta) {
+	meta["type"] = &Bullet::type;
+	meta["time"] = &Bullet::time;
+	meta["lastPos"] = &Bullet::lastPos;
+	meta["pos"] = &Bullet::pos;
+	meta["vel"] = &Bullet::vel;
+
+	meta["class"] = sol::property(&Bullet::getClass);
+}
+
+inline void bindEntityFields(sol::usertype<RigidBody>& meta) {
+	meta["type"] = &RigidBody::type;
+	meta["unk0"] = &RigidBody::unk0;
+	meta["mass"] = &RigidBody::mass;
+	meta["pos"] = &RigidBody::pos;
+	meta["vel"] = &RigidBody::vel;
+	meta["rot"] = &RigidBody::rot;
+	meta["rotVel"] = &RigidBody::rotVel;
+
+	meta["class"] = sol::property(&RigidBody::getClass);
+	meta["isSettled"] =
+	    sol::property(&RigidBody::getIsSettled, &RigidBody::setIsSettled);
+}
+
+inline void bindEntityFields(sol::usertype<TrafficCar>& meta) {
+	meta["pos"] = &TrafficCar::pos;
+	meta["vel"] = &TrafficCar::vel;
+	meta["yaw"] = &TrafficCar::yaw;
+	meta["rot"] = &TrafficCar::rot;
+	meta["color"] = &TrafficCar::color;
+	meta["state"] = &TrafficCar::state;
+
+	meta["class"] = sol::property(&TrafficCar::getClass);
+	meta["isBot"] = sol::property(&TrafficCar::getIsBot, &TrafficCar::setIsBot);
+	meta["isAggressive"] = sol::property(&TrafficCar::getIsAggressive,
+	                                     &TrafficCar::setIsAggressive);
+}
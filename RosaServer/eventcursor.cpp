@@ -0,0 +1,54 @@
+#include "eventcursor.h"
+
+#include <algorithm>
+
+#include "engine.h"
+
+EventCursor::EventCursor() { skip(); }
+
+EventCursor::EventCursor(sol::table types) {
+	for (const auto& pair : types) this->types.push_back(pair.second.as<int>());
+	skip();
+}
+
+void EventCursor::moveTo(int index) {
+	position = index;
+	if (position) {
+		const Event& last = Engine::events[position - 1];
+		lastType = last.type;
+		lastTickCreated = last.tickCreated;
+	}
+}
+
+bool EventCursor::matches(int type) const {
+	return types.empty() ||
+	       std::find(types.begin(), types.end(), type) != types.end();
+}
+
+sol::table EventCursor::poll(sol::optional<sol::table> out, sol::this_state s) {
+	sol::state_view lua(s);
+	sol::table events = out ? *out : lua.create_table();
+
+	int count = *Engine::numEvents;
+	bool wrapped = count < position;
+	if (!wrapped && position) {
+		const Event& last = Engine::events[position - 1];
+		wrapped = last.type != lastType || last.tickCreated != lastTickCreated;
+	}
+	if (wrapped) {
+		wraps++;
+		position = 0;
+	}
+
+	size_t added = 0;
+	for (int i = position; i < count; i++) {
+		Event* event = &Engine::events[i];
+		if (matches(event->type)) events[++added] = event;
+	}
+	for (size_t i = added + 1; events[i].valid(); i++) events[i] = sol::lua_nil;
+
+	moveTo(count);
+	return events;
+}
+
+void EventCursor::skip() { moveTo(*Engine::numEvents); }
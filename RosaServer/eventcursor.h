@@ -0,0 +1,28 @@
+#pragma once
+#include <vector>
+
+#include "sol/sol.hpp"
+
+// Remembers how far into the engine's event list a script has read, so each
+// poll only returns the events created since the last one.
+class EventCursor {
+	int position;
+	// Identifies the last event read, to notice the list being cleared and
+	// refilled past the cursor between polls
+	int lastType;
+	int lastTickCreated;
+	std::vector<int> types;
+	int wraps = 0;
+
+	void moveTo(int index);
+	bool matches(int type) const;
+
+ public:
+	EventCursor();
+	EventCursor(sol::table types);
+	const char* getClass() const { return "EventCursor"; }
+	int getPosition() const { return position; }
+	int getWraps() const { return wraps; }
+	sol::table poll(sol::optional<sol::table> out, sol::this_state s);
+	void skip();
+};
@@ -0,0 +1,609 @@
+#include "ffistructs.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <type_traits>
+
+#include "console.h"
+#include "engine.h"
+
+bool noLuaCallError(sol::protected_function_result* res);
+bool noLuaCallError(sol::load_result* res);
+
+namespace FFIStructs {
+template <typename T>
+static constexpr const char* getTypeName() {
+	if constexpr (std::is_same_v<T, bool>) return "bool";
+	if constexpr (std::is_same_v<T, char>) return "char";
+	if constexpr (std::is_same_v<T, unsigned char>) return "unsigned char";
+	if constexpr (std::is_same_v<T, short>) return "short";
+	if constexpr (std::is_same_v<T, int>) return "int";
+	if constexpr (std::is_same_v<T, unsigned int>) return "unsigned int";
+	if constexpr (std::is_same_v<T, long long>) return "long long";
+	if constexpr (std::is_same_v<T, float>) return "float";
+	if constexpr (std::is_same_v<T, Vector>) return "Vector";
+	if constexpr (std::is_same_v<T, RotMatrix>) return "RotMatrix";
+	return nullptr;
+}
+
+template <typename T>
+static std::vector<Field>& addStruct(std::vector<Struct>& structs,
+                                     const char* name) {
+	structs.push_back({name, sizeof(T), {}});
+	return structs.back().fields;
+}
+
+template <typename M>
+static void addField(std::vector<Field>& fields, const char* name,
+                     size_t offset) {
+	using Element = std::remove_all_extents_t<M>;
+	static_assert(getTypeName<Element>() != nullptr, "Unsupported field type");
+
+	std::string dimensions;
+	if constexpr (std::rank_v<M> >= 1)
+		dimensions += "[" + std::to_string(std::extent_v<M, 0>) + "]";
+	if constexpr (std::rank_v<M> >= 2)
+		dimensions += "[" + std::to_string(std::extent_v<M, 1>) + "]";
+
+	fields.push_back({getTypeName<Element>(), name, dimensions, offset,
+	                  sizeof(M)});
+}
+
+#define FIELD(type, name) \
+	addField<decltype(type::name)>(fields, #name, offsetof(type, name))
+
+static std::vector<Struct> describeStructs() {
+	std::vector<Struct> structs;
+
+	{
+		auto& fields = addStruct<Vector>(structs, "Vector");
+		FIELD(Vector, x);
+		FIELD(Vector, y);
+		FIELD(Vector, z);
+	}
+
+	{
+		auto& fields = addStruct<RotMatrix>(structs, "RotMatrix");
+		FIELD(RotMatrix, x1);
+		FIELD(RotMatrix, y1);
+		FIELD(RotMatrix, z1);
+		FIELD(RotMatrix, x2);
+		FIELD(RotMatrix, y2);
+		FIELD(RotMatrix, z2);
+		FIELD(RotMatrix, x3);
+		FIELD(RotMatrix, y3);
+		FIELD(RotMatrix, z3);
+	}
+
+	{
+		auto& fields = addStruct<Connection>(structs, "Connection");
+		FIELD(Connection, address);
+		FIELD(Connection, port);
+		FIELD(Connection, adminVisible);
+		FIELD(Connection, playerID);
+		FIELD(Connection, bandwidth);
+		FIELD(Connection, timeoutTime);
+		FIELD(Connection, numReceivedEvents);
+		FIELD(Connection, spectatingHumanID);
+	}
+
+	{
+		auto& fields = addStruct<Account>(structs, "Account");
+		FIELD(Account, subRosaID);
+		FIELD(Account, phoneNumber);
+		FIELD(Account, steamID);
+		FIELD(Account, name);
+		FIELD(Account, money);
+		FIELD(Account, corporateRating);
+		FIELD(Account, criminalRating);
+		FIELD(Account, spawnTimer);
+		FIELD(Account, playTime);
+		FIELD(Account, banTime);
+	}
+
+	{
+		auto& fields = addStruct<Player>(structs, "Player");
+		FIELD(Player, active);
+		FIELD(Player, name);
+		FIELD(Player, subRosaID);
+		FIELD(Player, phoneNumber);
+		FIELD(Player, isAdmin);
+		FIELD(Player, adminAttempts);
+		FIELD(Player, accountID);
+		FIELD(Player, isReady);
+		FIELD(Player, money);
+		FIELD(Player, teamMoney);
+		FIELD(Player, budget);
+		FIELD(Player, corporateRating);
+		FIELD(Player, criminalRating);
+		FIELD(Player, isGodMode);
+		FIELD(Player, itemsBought);
+		FIELD(Player, team);
+		FIELD(Player, teamSwitchTimer);
+		FIELD(Player, stocks);
+		FIELD(Player, spawnTimer);
+		FIELD(Player, humanID);
+		FIELD(Player, gearX);
+		FIELD(Player, leftRightInput);
+		FIELD(Player, gearY);
+		FIELD(Player, forwardBackInput);
+		FIELD(Player, viewYawDelta);
+		FIELD(Player, viewPitch);
+		FIELD(Player, freeLookYaw);
+		FIELD(Player, freeLookPitch);
+		FIELD(Player, viewYaw);
+		FIELD(Player, viewPitchDelta);
+		FIELD(Player, inputFlags);
+		FIELD(Player, lastInputFlags);
+		FIELD(Player, zoomLevel);
+		FIELD(Player, inputType);
+		FIELD(Player, menuTab);
+		FIELD(Player, numActions);
+		FIELD(Player, lastNumActions);
+		FIELD(Player, numMenuButtons);
+		FIELD(Player, isBot);
+		FIELD(Player, isZombie);
+		FIELD(Player, botHasDestination);
+		FIELD(Player, botDestination);
+		FIELD(Player, gender);
+		FIELD(Player, skinColor);
+		FIELD(Player, hairColor);
+		FIELD(Player, hair);
+		FIELD(Player, eyeColor);
+		FIELD(Player, model);
+		FIELD(Player, suitColor);
+		FIELD(Player, tieColor);
+		FIELD(Player, head);
+		FIELD(Player, necklace);
+	}
+
+	{
+		auto& fields = addStruct<Human>(structs, "Human");
+		FIELD(Human, active);
+		FIELD(Human, physicsSim);
+		FIELD(Human, playerID);
+		FIELD(Human, accountID);
+		FIELD(Human, stamina);
+		FIELD(Human, maxStamina);
+		FIELD(Human, vehicleID);
+		FIELD(Human, vehicleSeat);
+		FIELD(Human, lastVehicleID);
+		FIELD(Human, lastVehicleCooldown);
+		FIELD(Human, despawnTime);
+		FIELD(Human, oldHealth);
+		FIELD(Human, isImmortal);
+		FIELD(Human, spawnProtection);
+		FIELD(Human, isOnGround);
+		FIELD(Human, movementState);
+		FIELD(Human, zoomLevel);
+		FIELD(Human, damage);
+		FIELD(Human, isStanding);
+		FIELD(Human, pos);
+		FIELD(Human, pos2);
+		FIELD(Human, viewYaw);
+		FIELD(Human, viewPitch);
+		FIELD(Human, viewYaw2);
+		FIELD(Human, strafeInput);
+		FIELD(Human, walkInput);
+		FIELD(Human, viewPitch2);
+		FIELD(Human, inputFlags);
+		FIELD(Human, lastInputFlags);
+		FIELD(Human, health);
+		FIELD(Human, bloodLevel);
+		FIELD(Human, isBleeding);
+		FIELD(Human, chestHP);
+		FIELD(Human, headHP);
+		FIELD(Human, leftArmHP);
+		FIELD(Human, rightArmHP);
+		FIELD(Human, leftLegHP);
+		FIELD(Human, rightLegHP);
+		FIELD(Human, progressBar);
+		FIELD(Human, inventoryAnimationFlags);
+		FIELD(Human, inventoryAnimationProgress);
+		FIELD(Human, inventoryAnimationDuration);
+		FIELD(Human, inventoryAnimationHand);
+		FIELD(Human, inventoryAnimationSlot);
+		FIELD(Human, inventoryAnimationCounterFinished);
+		FIELD(Human, inventoryAnimationCounter);
+		FIELD(Human, gender);
+		FIELD(Human, head);
+		FIELD(Human, skinColor);
+		FIELD(Human, hairColor);
+		FIELD(Human, hair);
+		FIELD(Human, eyeColor);
+		FIELD(Human, model);
+		FIELD(Human, suitColor);
+		FIELD(Human, tieColor);
+		FIELD(Human, necklace);
+		FIELD(Human, lastUpdatedWantedGroup);
+	}
+
+	{
+		auto& fields = addStruct<ItemType>(structs, "ItemType");
+		FIELD(ItemType, price);
+		FIELD(ItemType, mass);
+		FIELD(ItemType, isGun);
+		FIELD(ItemType, messedUpAiming);
+		FIELD(ItemType, fireRate);
+		FIELD(ItemType, bulletType);
+		FIELD(ItemType, magazineAmmo);
+		FIELD(ItemType, bulletVelocity);
+		FIELD(ItemType, bulletSpread);
+		FIELD(ItemType, name);
+		FIELD(ItemType, numHands);
+		FIELD(ItemType, rightHandPos);
+		FIELD(ItemType, leftHandPos);
+		FIELD(ItemType, primaryGripStiffness);
+		FIELD(ItemType, primaryGripRotation);
+		FIELD(ItemType, secondaryGripStiffness);
+		FIELD(ItemType, secondaryGripRotation);
+		FIELD(ItemType, boundsCenter);
+		FIELD(ItemType, canMountTo);
+		FIELD(ItemType, gunHoldingPos);
+	}
+
+	{
+		auto& fields = addStruct<Item>(structs, "Item");
+		FIELD(Item, active);
+		FIELD(Item, physicsSim);
+		FIELD(Item, physicsSettled);
+		FIELD(Item, physicsSettledTimer);
+		FIELD(Item, isStatic);
+		FIELD(Item, type);
+		FIELD(Item, despawnTime);
+		FIELD(Item, grenadePrimerID);
+		FIELD(Item, parentHumanID);
+		FIELD(Item, parentItemID);
+		FIELD(Item, parentSlot);
+		FIELD(Item, isInPocket);
+		FIELD(Item, numChildItems);
+		FIELD(Item, childItemIDs);
+		FIELD(Item, bodyID);
+		FIELD(Item, pos);
+		FIELD(Item, pos2);
+		FIELD(Item, vel);
+		FIELD(Item, vel2);
+		FIELD(Item, vel3);
+		FIELD(Item, vel4);
+		FIELD(Item, rot);
+		FIELD(Item, cooldown);
+		FIELD(Item, bullets);
+		FIELD(Item, connectedPhoneID);
+		FIELD(Item, phoneNumber);
+		FIELD(Item, displayPhoneNumber);
+		FIELD(Item, enteredPhoneNumber);
+		FIELD(Item, phoneTexture);
+		FIELD(Item, vehicleID);
+		FIELD(Item, cashSpread);
+		FIELD(Item, cashBillAmount);
+		FIELD(Item, cashPureValue);
+		FIELD(Item, computerCurrentLine);
+		FIELD(Item, computerTopLine);
+		FIELD(Item, computerCursor);
+		FIELD(Item, computerLines);
+		FIELD(Item, computerLineColors);
+		FIELD(Item, computerTeam);
+	}
+
+	{
+		auto& fields = addStruct<VehicleType>(structs, "VehicleType");
+		FIELD(VehicleType, usesExternalModel);
+		FIELD(VehicleType, controllableState);
+		FIELD(VehicleType, name);
+		FIELD(VehicleType, price);
+		FIELD(VehicleType, mass);
+		FIELD(VehicleType, numWheels);
+	}
+
+	{
+		auto& fields = addStruct<Vehicle>(structs, "Vehicle");
+		FIELD(Vehicle, active);
+		FIELD(Vehicle, type);
+		FIELD(Vehicle, controllableState);
+		FIELD(Vehicle, health);
+		FIELD(Vehicle, lastDriverPlayerID);
+		FIELD(Vehicle, color);
+		FIELD(Vehicle, despawnTime);
+		FIELD(Vehicle, spawnedState);
+		FIELD(Vehicle, isLocked);
+		FIELD(Vehicle, bodyID);
+		FIELD(Vehicle, pos);
+		FIELD(Vehicle, pos2);
+		FIELD(Vehicle, rot);
+		FIELD(Vehicle, vel);
+		FIELD(Vehicle, windowStates);
+		FIELD(Vehicle, gearX);
+		FIELD(Vehicle, steerControl);
+		FIELD(Vehicle, gearY);
+		FIELD(Vehicle, gasControl);
+		FIELD(Vehicle, trafficCarID);
+		FIELD(Vehicle, engineRPM);
+		FIELD(Vehicle, numWheels);
+		FIELD(Vehicle, bladeBodyID);
+		FIELD(Vehicle, numSeats);
+	}
+
+	{
+		auto& fields = addStruct<Bullet>(structs, "Bullet");
+		FIELD(Bullet, type);
+		FIELD(Bullet, time);
+		FIELD(Bullet, playerID);
+		FIELD(Bullet, lastPos);
+		FIELD(Bullet, pos);
+		FIELD(Bullet, vel);
+	}
+
+	{
+		auto& fields = addStruct<RigidBody>(structs, "RigidBody");
+		FIELD(RigidBody, active);
+		FIELD(RigidBody, type);
+		FIELD(RigidBody, settled);
+		FIELD(RigidBody, mass);
+		FIELD(RigidBody, pos);
+		FIELD(RigidBody, vel);
+		FIELD(RigidBody, startVel);
+		FIELD(RigidBody, rot);
+		FIELD(RigidBody, rotVel);
+	}
+
+	{
+		auto& fields = addStruct<TrafficCar>(structs, "TrafficCar");
+		FIELD(TrafficCar, type);
+		FIELD(TrafficCar, humanID);
+		FIELD(TrafficCar, vehicleID);
+		FIELD(TrafficCar, state);
+		FIELD(TrafficCar, pos);
+		FIELD(TrafficCar, vel);
+		FIELD(TrafficCar, yaw);
+		FIELD(TrafficCar, rot);
+		FIELD(TrafficCar, isBot);
+		FIELD(TrafficCar, isAggressive);
+		FIELD(TrafficCar, color);
+	}
+
+	return structs;
+}
+
+#undef FIELD
+
+const std::vector<Struct>& getStructs() {
+	static const std::vector<Struct> structs = describeStructs();
+	return structs;
+}
+
+std::string getDefinitions() {
+	std::ostringstream stream;
+
+	for (const auto& type : getStructs()) {
+		size_t position = 0;
+		int numPads = 0;
+		auto pad = [&](size_t offset) {
+			if (offset > position) {
+				stream << "\tuint8_t pad" << numPads++ << "[" << offset - position
+				       << "];\n";
+			}
+		};
+
+		stream << "typedef struct {\n";
+		for (const auto& field : type.fields) {
+			pad(field.offset);
+			stream << "\t" << field.type << " " << field.name << field.dimensions
+			       << ";\n";
+			position = field.offset + field.size;
+		}
+		pad(type.size);
+		stream << "} " << type.name << ";\n";
+	}
+
+	return stream.str();
+}
+
+std::vector<std::string> verify(sol::table ffi) {
+	std::vector<std::string> errors;
+	sol::function sizeOf = ffi["sizeof"];
+	sol::function offsetOf = ffi["offsetof"];
+
+	for (const auto& type : getStructs()) {
+		size_t size = sizeOf(type.name);
+		if (size != type.size) {
+			errors.push_back(type.name + " is " + std::to_string(size) +
+			                 " bytes instead of " + std::to_string(type.size));
+		}
+
+		for (const auto& field : type.fields) {
+			size_t offset = offsetOf(type.name, field.name);
+			if (offset != field.offset) {
+				errors.push_back(type.name + "." + field.name + " is at " +
+				                 std::to_string(offset) + " instead of " +
+				                 std::to_string(field.offset));
+			}
+		}
+	}
+
+	return errors;
+}
+
+// Methods given to the FFI's Vector and RotMatrix. They're written in Lua so
+// the JIT can compile them, and the InPlace ones never allocate.
+static constexpr const char* mathTypes = R"(
+local ffi, ffiTable, getAddress = ...
+local sqrt = math.sqrt
+local format = string.format
+
+local Vector, RotMatrix
+local vectorMethods = {}
+local rotMatrixMethods = {}
+
+function vectorMethods:set(other)
+	self.x, self.y, self.z = other.x, other.y, other.z
+	return self
+end
+
+function vectorMethods:addInPlace(other)
+	self.x, self.y, self.z = self.x + other.x, self.y + other.y, self.z + other.z
+	return self
+end
+
+function vectorMethods:subInPlace(other)
+	self.x, self.y, self.z = self.x - other.x, self.y - other.y, self.z - other.z
+	return self
+end
+
+function vectorMethods:multInPlace(scalar)
+	self.x, self.y, self.z = self.x * scalar, self.y * scalar, self.z * scalar
+	return self
+end
+
+function vectorMethods:rotateInPlace(rot)
+	local x, y, z = self.x, self.y, self.z
+	self.x = rot.x1 * x + rot.y1 * y + rot.z1 * z
+	self.y = rot.x2 * x + rot.y2 * y + rot.z2 * z
+	self.z = rot.x3 * x + rot.y3 * y + rot.z3 * z
+	return self
+end
+
+function vectorMethods:lerpInto(other, t, out)
+	out.x = self.x + (other.x - self.x) * t
+	out.y = self.y + (other.y - self.y) * t
+	out.z = self.z + (other.z - self.z) * t
+	return out
+end
+
+function vectorMethods:normalizeInPlace()
+	return self:multInPlace(1 / self:length())
+end
+
+function vectorMethods:clone()
+	return Vector(self.x, self.y, self.z)
+end
+
+function vectorMethods:dot(other)
+	return self.x * other.x + self.y * other.y + self.z * other.z
+end
+
+function vectorMethods:lengthSquare()
+	return self:dot(self)
+end
+
+function vectorMethods:length()
+	return sqrt(self:dot(self))
+end
+
+function vectorMethods:distSquare(other)
+	local dx, dy, dz = self.x - other.x, self.y - other.y, self.z - other.z
+	return dx * dx + dy * dy + dz * dz
+end
+
+function vectorMethods:dist(other)
+	return sqrt(self:distSquare(other))
+end
+
+Vector = ffi.metatype('Vector', {
+	__index = vectorMethods,
+	__add = function (a, b) return Vector(a.x + b.x, a.y + b.y, a.z + b.z) end,
+	__sub = function (a, b) return Vector(a.x - b.x, a.y - b.y, a.z - b.z) end,
+	__mul = function (a, b)
+		if type(b) == 'number' then return Vector(a.x * b, a.y * b, a.z * b) end
+		return a:clone():rotateInPlace(b)
+	end,
+	__div = function (a, b) return Vector(a.x / b, a.y / b, a.z / b) end,
+	__unm = function (a) return Vector(-a.x, -a.y, -a.z) end,
+	__tostring = function (a)
+		return format('Vector(%f, %f, %f)', a.x, a.y, a.z)
+	end,
+})
+
+function rotMatrixMethods:set(other)
+	self.x1, self.y1, self.z1 = other.x1, other.y1, other.z1
+	self.x2, self.y2, self.z2 = other.x2, other.y2, other.z2
+	self.x3, self.y3, self.z3 = other.x3, other.y3, other.z3
+	return self
+end
+
+function rotMatrixMethods:mulInPlace(o)
+	local x1, y1, z1 = self.x1, self.y1, self.z1
+	local x2, y2, z2 = self.x2, self.y2, self.z2
+	local x3, y3, z3 = self.x3, self.y3, self.z3
+	self.x1 = x1 * o.x1 + y1 * o.x2 + z1 * o.x3
+	self.y1 = x1 * o.y1 + y1 * o.y2 + z1 * o.y3
+	self.z1 = x1 * o.z1 + y1 * o.z2 + z1 * o.z3
+	self.x2 = x2 * o.x1 + y2 * o.x2 + z2 * o.x3
+	self.y2 = x2 * o.y1 + y2 * o.y2 + z2 * o.y3
+	self.z2 = x2 * o.z1 + y2 * o.z2 + z2 * o.z3
+	self.x3 = x3 * o.x1 + y3 * o.x2 + z3 * o.x3
+	self.y3 = x3 * o.y1 + y3 * o.y2 + z3 * o.y3
+	self.z3 = x3 * o.z1 + y3 * o.z2 + z3 * o.z3
+	return self
+end
+
+function rotMatrixMethods:clone()
+	return RotMatrix():set(self)
+end
+
+RotMatrix = ffi.metatype('RotMatrix', {
+	__index = rotMatrixMethods,
+	__mul = function (a, b) return a:clone():mulInPlace(b) end,
+	__tostring = function (a)
+		return format('RotMatrix(%f, %f, %f, %f, %f, %f, %f, %f, %f)',
+			a.x1, a.y1, a.z1, a.x2, a.y2, a.z2, a.x3, a.y3, a.z3)
+	end,
+})
+
+ffiTable.Vector = Vector
+ffiTable.RotMatrix = RotMatrix
+
+-- Views of Vector and RotMatrix userdata, which engine functions take as is.
+-- They don't keep the userdata alive.
+function ffiTable.vectorOf(vector)
+	return ffi.cast('Vector*', getAddress(vector))
+end
+
+function ffiTable.rotMatrixOf(rot)
+	return ffi.cast('RotMatrix*', getAddress(rot))
+end
+)";
+
+void define(sol::state_view lua, sol::table memoryTable) {
+	sol::table ffi = lua["package"]["loaded"]["ffi"];
+	ffi["cdef"](getDefinitions());
+
+	auto errors = verify(ffi);
+	if (!errors.empty()) {
+		std::ostringstream stream;
+		stream << "\033[41;1m FFI layout mismatch \033[0m\n\033[31m";
+		for (const auto& error : errors) stream << error << "\n";
+		stream << "\033[0m";
+		Console::log(stream.str());
+		return;
+	}
+
+	sol::function cast = ffi["cast"];
+	auto castArray = [&](const char* type, void* array) {
+		return cast(type, reinterpret_cast<uintptr_t>(array)).get<sol::object>();
+	};
+
+	auto ffiTable = lua.create_table();
+	memoryTable["ffi"] = ffiTable;
+	ffiTable["definitions"] = getDefinitions();
+	ffiTable["connections"] = castArray("Connection*", Engine::connections);
+	ffiTable["accounts"] = castArray("Account*", Engine::accounts);
+	ffiTable["players"] = castArray("Player*", Engine::players);
+	ffiTable["humans"] = castArray("Human*", Engine::humans);
+	ffiTable["itemTypes"] = castArray("ItemType*", Engine::itemTypes);
+	ffiTable["items"] = castArray("Item*", Engine::items);
+	ffiTable["vehicleTypes"] = castArray("VehicleType*", Engine::vehicleTypes);
+	ffiTable["vehicles"] = castArray("Vehicle*", Engine::vehicles);
+	ffiTable["bullets"] = castArray("Bullet*", Engine::bullets);
+	ffiTable["rigidBodies"] = castArray("RigidBody*", Engine::bodies);
+	ffiTable["trafficCars"] = castArray("TrafficCar*", Engine::trafficCars);
+
+	sol::load_result load = lua.load(mathTypes);
+	if (!noLuaCallError(&load)) return;
+
+	sol::protected_function defineMathTypes = load;
+	sol::protected_function_result res =
+	    defineMathTypes(ffi, ffiTable, memoryTable["getAddress"]);
+	noLuaCallError(&res);
+}
+};  // namespace FFIStructs
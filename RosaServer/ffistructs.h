@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "sol/sol.hpp"
+
+// C declarations of the engine structs for LuaJIT's FFI, built from structs.h
+// with offsetof so they can't drift from the C++ layouts. Members which aren't
+// known or aren't plain data are declared as padding.
+namespace FFIStructs {
+struct Field {
+	std::string type;
+	std::string name;
+	std::string dimensions;
+	size_t offset;
+	size_t size;
+};
+
+struct Struct {
+	std::string name;
+	size_t size;
+	std::vector<Field> fields;
+};
+
+const std::vector<Struct>& getStructs();
+std::string getDefinitions();
+// Compares the FFI's idea of every struct against the C++ one, returning a
+// description of each mismatch.
+std::vector<std::string> verify(sol::table ffi);
+// Declares the structs and puts typed pointers to the engine's arrays in
+// memory.ffi along with FFI Vector and RotMatrix types, unless the layouts
+// don't match.
+void define(sol::state_view lua, sol::table memoryTable);
+};  // namespace FFIStructs
@@ -0,0 +1,26 @@
+#include "hookobserver.h"
+
+namespace Hooks {
+sol::object ObservedEvent::getArg(sol::state_view lua, int index) const {
+	const ObservedArg& arg = args[index];
+	switch (arg.type) {
+		case ObservedArg::Boolean:
+			return sol::make_object(lua, arg.boolean);
+		case ObservedArg::Integer:
+			return sol::make_object(lua, arg.integer);
+		case ObservedArg::Number:
+			return sol::make_object(lua, arg.number);
+		case ObservedArg::String:
+			return sol::make_object(
+			    lua, std::string(strings + arg.string.offset, arg.string.length));
+		case ObservedArg::Vector:
+			return sol::make_object(lua, arg.vector);
+		case ObservedArg::RotMatrix:
+			return sol::make_object(lua, arg.rotMatrix);
+		case ObservedArg::Pointer:
+			return arg.pointer.toObject(lua, arg.pointer.pointer);
+		default:
+			return sol::make_object(lua, sol::nil);
+	}
+}
+};  // namespace Hooks
@@ -0,0 +1,194 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "hooktrace.h"
+#include "structs.h"
+
+namespace Hooks {
+struct Float;
+struct Integer;
+struct UnsignedInteger;
+
+template <typename T>
+constexpr HookTrace::EntityType getEntityType() {
+	using HookTrace::EntityType;
+	if constexpr (std::is_same_v<T, Connection>) return EntityType::Connection;
+	if constexpr (std::is_same_v<T, Account>) return EntityType::Account;
+	if constexpr (std::is_same_v<T, Player>) return EntityType::Player;
+	if constexpr (std::is_same_v<T, Human>) return EntityType::Human;
+	if constexpr (std::is_same_v<T, ItemType>) return EntityType::ItemType;
+	if constexpr (std::is_same_v<T, Item>) return EntityType::Item;
+	if constexpr (std::is_same_v<T, VehicleType>) return EntityType::VehicleType;
+	if constexpr (std::is_same_v<T, Vehicle>) return EntityType::Vehicle;
+	if constexpr (std::is_same_v<T, Bullet>) return EntityType::Bullet;
+	if constexpr (std::is_same_v<T, RigidBody>) return EntityType::RigidBody;
+	if constexpr (std::is_same_v<T, TrafficCar>) return EntityType::TrafficCar;
+	return EntityType::Unknown;
+}
+
+// A hook argument copied out of the engine so it can be handed to Lua later.
+// Entities are kept as pointers into the engine's arrays; vectors, matrices
+// and strings are copied since they may only live for the engine call.
+struct ObservedArg {
+	enum Type : uint8_t {
+		Nil,
+		Boolean,
+		Integer,
+		Number,
+		String,
+		Vector,
+		RotMatrix,
+		Pointer
+	} type;
+
+	union {
+		bool boolean;
+		long long integer;
+		double number;
+		struct {
+			uint16_t offset;
+			uint16_t length;
+		} string;
+		::Vector vector;
+		::RotMatrix rotMatrix;
+		struct {
+			void* pointer;
+			sol::object (*toObject)(sol::state_view lua, void* pointer);
+			HookTrace::EntityType entityType;
+		} pointer;
+	};
+};
+
+struct ObservedEvent {
+	// The most any hook passes is HumanLimbInverseKinematics' 13
+	static constexpr int maxArgs = 16;
+	static constexpr int maxStringBytes = 512;
+
+	int key;
+	bool isPost;
+	// Set when strings didn't fit and were cut short
+	bool truncated;
+	uint8_t numArgs;
+	uint16_t numStringBytes;
+	ObservedArg args[maxArgs];
+	char strings[maxStringBytes];
+
+	void addString(ObservedArg& arg, const char* string, size_t length) {
+		size_t available = maxStringBytes - numStringBytes;
+		if (length > available) {
+			length = available;
+			truncated = true;
+		}
+
+		arg.type = ObservedArg::String;
+		arg.string.offset = numStringBytes;
+		arg.string.length = length;
+		std::memcpy(strings + numStringBytes, string, length);
+		numStringBytes += length;
+	}
+
+	template <typename T>
+	static sol::object pointerToObject(sol::state_view lua, void* pointer) {
+		return sol::make_object(lua, static_cast<T*>(pointer));
+	}
+
+	template <typename T>
+	void add(const T& value) {
+		ObservedArg& arg = args[numArgs++];
+
+		if constexpr (std::is_same_v<T, bool>) {
+			arg.type = ObservedArg::Boolean;
+			arg.boolean = value;
+		} else if constexpr (std::is_integral_v<T> || std::is_enum_v<T>) {
+			arg.type = ObservedArg::Integer;
+			arg.integer = value;
+		} else if constexpr (std::is_floating_point_v<T>) {
+			arg.type = ObservedArg::Number;
+			arg.number = value;
+		} else if constexpr (std::is_same_v<T, Hooks::Integer> ||
+		                     std::is_same_v<T, Hooks::UnsignedInteger>) {
+			arg.type = ObservedArg::Integer;
+			arg.integer = value.value;
+		} else if constexpr (std::is_same_v<T, Hooks::Float>) {
+			arg.type = ObservedArg::Number;
+			arg.number = value.value;
+		} else if constexpr (std::is_same_v<T, std::string>) {
+			addString(arg, value.data(), value.size());
+		} else if constexpr (std::is_pointer_v<T>) {
+			using Pointee = std::remove_cv_t<std::remove_pointer_t<T>>;
+			if (value == nullptr) {
+				arg.type = ObservedArg::Nil;
+			} else if constexpr (std::is_same_v<Pointee, char>) {
+				addString(arg, value, std::strlen(value));
+			} else if constexpr (std::is_same_v<Pointee, ::Vector>) {
+				arg.type = ObservedArg::Vector;
+				arg.vector = *value;
+			} else if constexpr (std::is_same_v<Pointee, ::RotMatrix>) {
+				arg.type = ObservedArg::RotMatrix;
+				arg.rotMatrix = *value;
+			} else if constexpr (std::is_same_v<Pointee, Hooks::Integer> ||
+			                     std::is_same_v<Pointee, Hooks::UnsignedInteger>) {
+				// Wrapped arguments live on the hook's stack, so copy the value
+				arg.type = ObservedArg::Integer;
+				arg.integer = value->value;
+			} else if constexpr (std::is_same_v<Pointee, Hooks::Float>) {
+				arg.type = ObservedArg::Number;
+				arg.number = value->value;
+			} else {
+				arg.type = ObservedArg::Pointer;
+				arg.pointer.pointer = const_cast<Pointee*>(value);
+				arg.pointer.toObject = pointerToObject<Pointee>;
+				arg.pointer.entityType = getEntityType<Pointee>();
+			}
+		} else {
+			// Lua tables and anything else that can't be copied
+			arg.type = ObservedArg::Nil;
+		}
+	}
+
+	template <typename... Args>
+	void set(int eventKey, bool eventIsPost, const Args&... eventArgs) {
+		static_assert(sizeof...(Args) <= maxArgs, "Too many hook arguments");
+		key = eventKey;
+		isPost = eventIsPost;
+		truncated = false;
+		numArgs = 0;
+		numStringBytes = 0;
+		(add(eventArgs), ...);
+	}
+
+	sol::object getArg(sol::state_view lua, int index) const;
+};
+
+// Fixed capacity buffer of observed events, drained once per tick.
+class ObservedEventBuffer {
+	std::vector<ObservedEvent> events;
+	size_t numEvents = 0;
+
+ public:
+	unsigned long long numDropped = 0;
+	unsigned long long numTruncated = 0;
+
+	ObservedEventBuffer(size_t capacity) : events(capacity) {}
+
+	template <typename... Args>
+	void push(int key, bool isPost, const Args&... args) {
+		if (numEvents == events.size()) {
+			numDropped++;
+			return;
+		}
+
+		auto& event = events[numEvents++];
+		event.set(key, isPost, args...);
+		if (event.truncated) numTruncated++;
+	}
+
+	size_t size() const { return numEvents; }
+	const ObservedEvent& operator[](size_t index) const { return events[index]; }
+	void clear() { numEvents = 0; }
+};
+};  // namespace Hooks
@@ -1,10 +1,15 @@
 #include "hooks.h"
 
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
 #include "api.h"
 #include "console.h"
 
 namespace Hooks {
 sol::protected_function run;
+bool collectStats = false;
 
 const std::unordered_map<std::string, EnableKeys> enableNames(
     {{"InterruptSignal", EnableKeys::InterruptSignal},
@@ -32,6 +37,7 @@ const std::unordered_map<std::string, EnableKeys> enableNames(
      {"ServerReceive", EnableKeys::ServerReceive},
      {"ServerSend", EnableKeys::ServerSend},
      {"PacketBuilding", EnableKeys::PacketBuilding},
+     {"PacketBuildingBatch", EnableKeys::PacketBuildingBatch},
      {"CalculateEarShots", EnableKeys::CalculateEarShots},
      {"SendPacket", EnableKeys::SendPacket},
      {"PhysicsBullets", EnableKeys::PhysicsBullets},
@@ -71,73 +77,290 @@ const std::unordered_map<std::string, EnableKeys> enableNames(
      {"EventSoundItem", EnableKeys::EventSoundItem},
      {"EventBullet", EnableKeys::EventBullet},
      {"EventBulletHit", EnableKeys::EventBulletHit},
-     {"LineIntersectHuman", EnableKeys::LineIntersectHuman}});
+     {"LineIntersectHuman", EnableKeys::LineIntersectHuman},
+     {"BulletMayHit", EnableKeys::BulletMayHit},
+     {"BulletMayHitHuman", EnableKeys::BulletMayHitHuman},
+     {"BulletHitHuman", EnableKeys::BulletHitHuman},
+     {"TickOverBudget", EnableKeys::TickOverBudget}});
 bool enabledKeys[EnableKeys::SIZE] = {0};
+bool scriptEnabledKeys[EnableKeys::SIZE] = {0};
+
+Callbacks callbacks[EnableKeys::SIZE];
+
+void clearCallbacks() {
+	for (auto& callback : callbacks) callback = Callbacks();
+	for (size_t key = 0; key < EnableKeys::SIZE; key++) updateEnabledKey(key);
+	observedEvents.clear();
+}
+
+void updateEnabledKey(size_t key) {
+	enabledKeys[key] = scriptEnabledKeys[key] || callbacks[key].isRegistered();
+}
+
+ObservedEventBuffer observedEvents(1024);
+TraceRecorder* traceRecorder = nullptr;
+
+void flushObservedEvents() {
+	std::vector<sol::object> args;
+
+	// Observers may cause more events, which are handled in the same flush
+	for (size_t i = 0; i < observedEvents.size(); i++) {
+		const auto& event = observedEvents[i];
+		const auto& callback = callbacks[event.key];
+		const auto& observer =
+		    event.isPost ? callback.postObserver : callback.preObserver;
+		if (!observer.valid()) continue;
+
+		for (int arg = 0; arg < event.numArgs; arg++)
+			args.push_back(event.getArg(*lua, arg));
+
+		auto res = observer(sol::as_args(args));
+		noLuaCallError(&res);
+		args.clear();
+	}
+	observedEvents.clear();
+
+	if (observedEvents.numDropped) {
+		std::ostringstream stream;
+		stream << RS_PREFIX "Dropped " << observedEvents.numDropped
+		       << " observed hook events, the buffer is full\n";
+		Console::log(stream.str());
+		observedEvents.numDropped = 0;
+	}
+
+	if (observedEvents.numTruncated) {
+		std::ostringstream stream;
+		stream << RS_PREFIX "Truncated strings in " << observedEvents.numTruncated
+		       << " observed hook events\n";
+		Console::log(stream.str());
+		observedEvents.numTruncated = 0;
+	}
+}
 
-subhook::Hook subRosaPutsHook;
-subhook::Hook subRosa__printf_chkHook;
-subhook::Hook resetGameHook;
-subhook::Hook createTrafficHook;
-subhook::Hook trafficSimulationHook;
-subhook::Hook aiTrafficCarHook;
-subhook::Hook aiTrafficCarDestinationHook;
-subhook::Hook areaCreateBlockHook;
-subhook::Hook areaDeleteBlockHook;
-subhook::Hook logicSimulationHook;
-subhook::Hook logicSimulationRaceHook;
-subhook::Hook logicSimulationRoundHook;
-subhook::Hook logicSimulationWorldHook;
-subhook::Hook logicSimulationTerminatorHook;
-subhook::Hook logicSimulationCoopHook;
-subhook::Hook logicSimulationVersusHook;
-subhook::Hook logicPlayerActionsHook;
-subhook::Hook physicsSimulationHook;
-subhook::Hook rigidBodySimulationHook;
-subhook::Hook vehicleSimulateSuspensionsHook;
-subhook::Hook itemWeaponSimulationHook;
-subhook::Hook serverReceiveHook;
-subhook::Hook serverSendHook;
-subhook::Hook packetWriteHook;
-subhook::Hook calculatePlayerVoiceHook;
-subhook::Hook sendPacketHook;
-subhook::Hook bulletSimulationHook;
-subhook::Hook economyCarMarketHook;
-subhook::Hook saveAccountsServerHook;
-subhook::Hook createAccountByJoinTicketHook;
-subhook::Hook serverSendConnectResponseHook;
-subhook::Hook linkItemHook;
-subhook::Hook itemComputerInputHook;
-subhook::Hook humanApplyDamageHook;
-subhook::Hook humanCollisionVehicleHook;
-subhook::Hook humanLimbInverseKinematicsHook;
-subhook::Hook grenadeExplosionHook;
-subhook::Hook vehicleApplyDamageHook;
-subhook::Hook serverPlayerMessageHook;
-subhook::Hook playerAIHook;
-subhook::Hook playerDeathTaxHook;
-subhook::Hook accountDeathTaxHook;
-subhook::Hook playerGiveWantedLevelHook;
-subhook::Hook addCollisionRigidBodyOnRigidBodyHook;
-subhook::Hook createBulletHook;
-subhook::Hook createPlayerHook;
-subhook::Hook deletePlayerHook;
-subhook::Hook createHumanHook;
-subhook::Hook deleteHumanHook;
-subhook::Hook createItemHook;
-subhook::Hook deleteItemHook;
-subhook::Hook createVehicleHook;
-subhook::Hook deleteVehicleHook;
-subhook::Hook createRigidBodyHook;
-subhook::Hook createEventMessageHook;
-subhook::Hook createEventUpdateItemInfoHook;
-subhook::Hook createEventUpdatePlayerHook;
-subhook::Hook createEventUpdateVehicleHook;
-subhook::Hook createEventSoundHook;
-subhook::Hook createEventSoundItemHook;
-subhook::Hook createEventBulletHook;
-subhook::Hook createEventBulletHitHook;
-subhook::Hook lineIntersectHumanHook;
-subhook::Hook lineIntersectLevelHook;
+HookStats hookStats[EnableKeys::SIZE];
+
+const char* getKeyName(EnableKeys key) {
+	for (const auto& pair : enableNames) {
+		if (pair.second == key) return pair.first.c_str();
+	}
+	return "?";
+}
+
+void resetStats() {
+	for (auto& stats : hookStats) {
+		stats.pre.reset();
+		stats.post.reset();
+	}
+	for (auto hook : trampolineHooks) hook->originalLatency.reset();
+}
+
+static void logHistogram(std::ostringstream& stream, const std::string& name,
+                         const LatencyHistogram& histogram) {
+	if (!histogram.getCount()) return;
+
+	stream << "  " << std::left << std::setw(36) << name << std::right
+	       << std::setw(10) << histogram.getCount() << std::setw(10)
+	       << histogram.getMean() / 1000.0 << std::setw(10)
+	       << histogram.getPercentile(50) / 1000.0 << std::setw(10)
+	       << histogram.getPercentile(99) / 1000.0 << std::setw(10)
+	       << histogram.getMax() / 1000.0 << '\n';
+}
+
+void logStats() {
+	std::ostringstream stream;
+	stream << RS_PREFIX "Hook latency (us), collection "
+	       << (collectStats ? "on" : "off") << '\n';
+	stream << std::fixed << std::setprecision(1) << "  " << std::left
+	       << std::setw(36) << "hook" << std::right << std::setw(10) << "calls"
+	       << std::setw(10) << "mean" << std::setw(10) << "p50" << std::setw(10)
+	       << "p99" << std::setw(10) << "max" << '\n';
+
+	for (size_t i = 0; i < EnableKeys::SIZE; i++) {
+		std::string name = getKeyName(static_cast<EnableKeys>(i));
+		logHistogram(stream, name, hookStats[i].pre);
+		logHistogram(stream, "Post" + name, hookStats[i].post);
+	}
+	for (auto hook : trampolineHooks) {
+		logHistogram(stream, std::string(hook->name) + " (original)",
+		             hook->originalLatency);
+	}
+
+	Console::log(stream.str());
+}
+
+std::vector<TrampolineHook*> trampolineHooks;
+
+// 10 seconds of ticks, with a budget of one tick
+TickProfiler tickProfiler(ticksPerSecond * 10, 1000000000 / ticksPerSecond);
+
+bool TrampolineHook::install(const char* hookName, void* source,
+                             void* destination) {
+	name = hookName;
+	if (!Install(source, destination, subhook::HookFlags::HookFlag64BitOffset)) {
+		return false;
+	}
+	trampolineHooks.push_back(this);
+	return true;
+}
+
+TrampolineHook subRosaPutsHook;
+TrampolineHook subRosa__printf_chkHook;
+TrampolineHook resetGameHook;
+TrampolineHook createTrafficHook;
+TrampolineHook trafficSimulationHook;
+TrampolineHook aiTrafficCarHook;
+TrampolineHook aiTrafficCarDestinationHook;
+TrampolineHook areaCreateBlockHook;
+TrampolineHook areaDeleteBlockHook;
+TrampolineHook logicSimulationHook;
+TrampolineHook logicSimulationRaceHook;
+TrampolineHook logicSimulationRoundHook;
+TrampolineHook logicSimulationWorldHook;
+TrampolineHook logicSimulationTerminatorHook;
+TrampolineHook logicSimulationCoopHook;
+TrampolineHook logicSimulationVersusHook;
+TrampolineHook logicPlayerActionsHook;
+TrampolineHook physicsSimulationHook;
+TrampolineHook rigidBodySimulationHook;
+TrampolineHook vehicleSimulateSuspensionsHook;
+TrampolineHook itemWeaponSimulationHook;
+TrampolineHook serverReceiveHook;
+TrampolineHook serverSendHook;
+TrampolineHook packetWriteHook;
+TrampolineHook calculatePlayerVoiceHook;
+TrampolineHook sendPacketHook;
+TrampolineHook bulletSimulationHook;
+TrampolineHook economyCarMarketHook;
+TrampolineHook saveAccountsServerHook;
+TrampolineHook createAccountByJoinTicketHook;
+TrampolineHook serverSendConnectResponseHook;
+TrampolineHook linkItemHook;
+TrampolineHook itemComputerInputHook;
+TrampolineHook humanApplyDamageHook;
+TrampolineHook humanCollisionVehicleHook;
+TrampolineHook humanLimbInverseKinematicsHook;
+TrampolineHook grenadeExplosionHook;
+TrampolineHook vehicleApplyDamageHook;
+TrampolineHook serverPlayerMessageHook;
+TrampolineHook playerAIHook;
+TrampolineHook playerDeathTaxHook;
+TrampolineHook accountDeathTaxHook;
+TrampolineHook playerGiveWantedLevelHook;
+TrampolineHook addCollisionRigidBodyOnRigidBodyHook;
+TrampolineHook createBulletHook;
+TrampolineHook createPlayerHook;
+TrampolineHook deletePlayerHook;
+TrampolineHook createHumanHook;
+TrampolineHook deleteHumanHook;
+TrampolineHook createItemHook;
+TrampolineHook deleteItemHook;
+TrampolineHook createVehicleHook;
+TrampolineHook deleteVehicleHook;
+TrampolineHook createRigidBodyHook;
+TrampolineHook createEventMessageHook;
+TrampolineHook createEventUpdateItemInfoHook;
+TrampolineHook createEventUpdatePlayerHook;
+TrampolineHook createEventUpdateVehicleHook;
+TrampolineHook createEventSoundHook;
+TrampolineHook createEventSoundItemHook;
+TrampolineHook createEventBulletHook;
+TrampolineHook createEventBulletHitHook;
+TrampolineHook lineIntersectHumanHook;
+TrampolineHook lineIntersectLevelHook;
+
+struct LazyHook {
+	TrampolineHook& hook;
+	std::vector<EnableKeys> keys;
+	// Set by internal consumers which need the hook regardless of keys
+	std::vector<const bool*> alsoNeeded;
+};
+
+// Hooks only patched in while one of their keys is enabled. Any hook not
+// listed here does internal work and is always installed.
+static const LazyHook lazyHooks[] = {
+    {createTrafficHook, {EnableKeys::CreateTraffic}},
+    {trafficSimulationHook, {EnableKeys::TrafficSimulation}},
+    {aiTrafficCarHook, {EnableKeys::TrafficCarAI}},
+    {aiTrafficCarDestinationHook, {EnableKeys::TrafficCarDestination}},
+    {areaCreateBlockHook, {EnableKeys::AreaCreateBlock}},
+    {areaDeleteBlockHook, {EnableKeys::AreaDeleteBlock}},
+    {logicSimulationRaceHook, {EnableKeys::LogicRace}},
+    {logicSimulationRoundHook, {EnableKeys::LogicRound}},
+    {logicSimulationWorldHook, {EnableKeys::LogicWorld}},
+    {logicSimulationTerminatorHook, {EnableKeys::LogicTerminator}},
+    {logicSimulationCoopHook, {EnableKeys::LogicCoop}},
+    {logicSimulationVersusHook, {EnableKeys::LogicVersus}},
+    {logicPlayerActionsHook, {EnableKeys::PlayerActions}},
+    {physicsSimulationHook,
+     {EnableKeys::Physics},
+     {&tickProfiler.enabled, &spatialHash.enabled}},
+    {rigidBodySimulationHook,
+     {EnableKeys::PhysicsRigidBodies},
+     {&tickProfiler.enabled}},
+    {vehicleSimulateSuspensionsHook, {EnableKeys::VehicleSuspensions}},
+    {itemWeaponSimulationHook, {EnableKeys::ItemWeaponSimulation}},
+    {serverReceiveHook, {EnableKeys::ServerReceive}, {&tickProfiler.enabled}},
+    {serverSendHook,
+     {EnableKeys::ServerSend, EnableKeys::PacketBuildingBatch},
+     {&tickProfiler.enabled}},
+    {packetWriteHook, {EnableKeys::PacketBuilding}},
+    {calculatePlayerVoiceHook, {EnableKeys::CalculateEarShots}},
+    {sendPacketHook, {EnableKeys::SendPacket}},
+    {bulletSimulationHook,
+     {EnableKeys::PhysicsBullets, EnableKeys::BulletMayHit,
+      EnableKeys::BulletMayHitHuman, EnableKeys::BulletHitHuman},
+     {&tickProfiler.enabled}},
+    {economyCarMarketHook, {EnableKeys::EconomyCarMarket}},
+    {saveAccountsServerHook, {EnableKeys::AccountsSave}},
+    {createAccountByJoinTicketHook,
+     {EnableKeys::AccountTicketBegin, EnableKeys::AccountTicketFound,
+      EnableKeys::AccountTicket},
+     {&accountLookupsEnabled}},
+    {serverSendConnectResponseHook, {EnableKeys::SendConnectResponse}},
+    {linkItemHook, {EnableKeys::ItemLink}},
+    {itemComputerInputHook, {EnableKeys::ItemComputerInput}},
+    {humanApplyDamageHook, {EnableKeys::HumanDamage}},
+    {humanCollisionVehicleHook, {EnableKeys::HumanCollisionVehicle}},
+    {humanLimbInverseKinematicsHook, {EnableKeys::HumanLimbInverseKinematics}},
+    {grenadeExplosionHook, {EnableKeys::GrenadeExplode}},
+    {vehicleApplyDamageHook, {EnableKeys::VehicleDamage}},
+    {serverPlayerMessageHook, {EnableKeys::PlayerChat}},
+    {playerAIHook, {EnableKeys::PlayerAI}},
+    {playerDeathTaxHook, {EnableKeys::PlayerDeathTax}},
+    {accountDeathTaxHook, {EnableKeys::AccountDeathTax}},
+    {playerGiveWantedLevelHook, {EnableKeys::PlayerGiveWantedLevel}},
+    {addCollisionRigidBodyOnRigidBodyHook, {EnableKeys::CollideBodies}},
+    {createBulletHook, {EnableKeys::BulletCreate}},
+    {createEventMessageHook, {EnableKeys::EventMessage}},
+    {createEventUpdateItemInfoHook, {EnableKeys::EventUpdateItemInfo}},
+    {createEventUpdatePlayerHook, {EnableKeys::EventUpdatePlayer}},
+    {createEventUpdateVehicleHook, {EnableKeys::EventUpdateVehicle}},
+    {createEventSoundHook, {EnableKeys::EventSound}},
+    {createEventSoundItemHook, {EnableKeys::EventSoundItem}},
+    {createEventBulletHook, {EnableKeys::EventBullet}},
+    {createEventBulletHitHook, {EnableKeys::EventBulletHit}},
+    {lineIntersectHumanHook,
+     {EnableKeys::LineIntersectHuman, EnableKeys::BulletMayHitHuman,
+      EnableKeys::BulletHitHuman}},
+    {lineIntersectLevelHook, {EnableKeys::BulletMayHit}}};
+
+void updateInstalledHooks() {
+	for (const auto& lazyHook : lazyHooks) {
+		bool needed = false;
+		for (auto flag : lazyHook.alsoNeeded) {
+			if (*flag) needed = true;
+		}
+		for (auto key : lazyHook.keys) {
+			if (enabledKeys[key]) needed = true;
+		}
+
+		auto& hook = lazyHook.hook;
+		if (needed && !hook.IsInstalled())
+			hook.Install();
+		else if (!needed && hook.IsInstalled())
+			hook.Remove();
+	}
+}
 
 int subRosaPuts(const char* str) {
 	std::ostringstream stream;
@@ -222,167 +445,140 @@ void resetGame() {
 
 void createTraffic(int amount) {
 	if (enabledKeys[EnableKeys::CreateTraffic]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			Integer wrappedAmount = {amount};
+		Integer wrappedAmount = {amount};
 
-			auto res = run("CreateTraffic", wrappedAmount);
+		bool noParent = runPre(EnableKeys::CreateTraffic, "CreateTraffic",
+		                       wrappedAmount);
 
-			if (noLuaCallError(&res)) noParent = (bool)res;
-
-			amount = wrappedAmount.value;
-		}
+		amount = wrappedAmount.value;
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createTrafficHook);
-				Engine::createTraffic(amount);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostCreateTraffic", amount);
-				noLuaCallError(&res);
-			}
+			createTrafficHook.callOriginal(Engine::createTraffic, amount);
+			runPost(EnableKeys::CreateTraffic, "PostCreateTraffic", amount);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createTrafficHook);
-		Engine::createTraffic(amount);
+		createTrafficHook.callOriginal(Engine::createTraffic, amount);
 	}
 }
 
 void trafficSimulation() {
 	if (enabledKeys[EnableKeys::TrafficSimulation]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("TrafficSimulation");
-
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::TrafficSimulation, "TrafficSimulation");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&trafficSimulationHook);
-				Engine::trafficSimulation();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostTrafficSimulation");
-				noLuaCallError(&res);
-			}
+			trafficSimulationHook.callOriginal(Engine::trafficSimulation);
+			runPost(EnableKeys::TrafficSimulation, "PostTrafficSimulation");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&trafficSimulationHook);
-		Engine::trafficSimulation();
+		trafficSimulationHook.callOriginal(Engine::trafficSimulation);
 	}
 }
 
 void aiTrafficCar(int id) {
 	if (enabledKeys[EnableKeys::TrafficCarAI]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("TrafficCarAI", &Engine::trafficCars[id]);
-
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::TrafficCarAI, "TrafficCarAI",
+		                       &Engine::trafficCars[id]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&aiTrafficCarHook);
-				Engine::aiTrafficCar(id);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostTrafficCarAI", &Engine::trafficCars[id]);
-				noLuaCallError(&res);
-			}
+			aiTrafficCarHook.callOriginal(Engine::aiTrafficCar, id);
+			runPost(EnableKeys::TrafficCarAI, "PostTrafficCarAI",
+			        &Engine::trafficCars[id]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&aiTrafficCarHook);
-		Engine::aiTrafficCar(id);
+		aiTrafficCarHook.callOriginal(Engine::aiTrafficCar, id);
 	}
 }
 
 void aiTrafficCarDestination(int id, int a, int b, int c, int d) {
 	if (enabledKeys[EnableKeys::TrafficCarDestination]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			Integer wrappedA = {a};
-			Integer wrappedB = {b};
-			Integer wrappedC = {c};
-			Integer wrappedD = {d};
-
-			auto res = run("TrafficCarDestination", &Engine::trafficCars[id],
-			               wrappedA, wrappedB, wrappedC, wrappedD);
-
-			if (noLuaCallError(&res)) noParent = (bool)res;
-
-			a = wrappedA.value;
-			b = wrappedB.value;
-			c = wrappedC.value;
-			d = wrappedD.value;
-		}
+		Integer wrappedA = {a};
+		Integer wrappedB = {b};
+		Integer wrappedC = {c};
+		Integer wrappedD = {d};
+
+		bool noParent = runPre(EnableKeys::TrafficCarDestination,
+		                       "TrafficCarDestination", &Engine::trafficCars[id],
+		                       wrappedA, wrappedB, wrappedC, wrappedD);
+
+		a = wrappedA.value;
+		b = wrappedB.value;
+		c = wrappedC.value;
+		d = wrappedD.value;
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&aiTrafficCarDestinationHook);
-				Engine::aiTrafficCarDestination(id, a, b, c, d);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostTrafficCarDestination", &Engine::trafficCars[id], a,
-				               b, c, d);
-				noLuaCallError(&res);
-			}
+			aiTrafficCarDestinationHook.callOriginal(
+			    Engine::aiTrafficCarDestination, id, a, b, c, d);
+			runPost(EnableKeys::TrafficCarDestination, "PostTrafficCarDestination",
+			        &Engine::trafficCars[id], a, b, c, d);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&aiTrafficCarDestinationHook);
-		Engine::aiTrafficCarDestination(id, a, b, c, d);
+		aiTrafficCarDestinationHook.callOriginal(
+		    Engine::aiTrafficCarDestination, id, a, b, c, d);
 	}
 }
 
 void areaCreateBlock(int zero, int blockX, int blockY, int blockZ,
                      unsigned int flags, short unk[8]) {
 	if (enabledKeys[EnableKeys::AreaCreateBlock]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			UnsignedInteger wrappedFlags = {flags};
+		UnsignedInteger wrappedFlags = {flags};
 
-			auto res = run("AreaCreateBlock", blockX, blockY, blockZ, &wrappedFlags);
-			if (noLuaCallError(&res)) noParent = (bool)res;
+		bool noParent = runPre(EnableKeys::AreaCreateBlock, "AreaCreateBlock",
+		                       blockX, blockY, blockZ, &wrappedFlags);
 
-			flags = wrappedFlags.value;
-		}
+		flags = wrappedFlags.value;
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&areaCreateBlockHook);
-				Engine::areaCreateBlock(zero, blockX, blockY, blockZ, flags, unk);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostAreaCreateBlock", blockX, blockY, blockZ, flags);
-				noLuaCallError(&res);
-			}
+			areaCreateBlockHook.callOriginal(
+			    Engine::areaCreateBlock, zero, blockX, blockY, blockZ, flags, unk);
+			runPost(EnableKeys::AreaCreateBlock, "PostAreaCreateBlock", blockX,
+			        blockY, blockZ, flags);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&areaCreateBlockHook);
-		Engine::areaCreateBlock(zero, blockX, blockY, blockZ, flags, unk);
+		areaCreateBlockHook.callOriginal(
+		    Engine::areaCreateBlock, zero, blockX, blockY, blockZ, flags, unk);
 	}
 }
 
 void areaDeleteBlock(int zero, int blockX, int blockY, int blockZ) {
 	if (enabledKeys[EnableKeys::AreaDeleteBlock]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("AreaDeleteBlock", blockX, blockY, blockZ);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::AreaDeleteBlock, "AreaDeleteBlock",
+		                       blockX, blockY, blockZ);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&areaDeleteBlockHook);
-				Engine::areaDeleteBlock(zero, blockX, blockY, blockZ);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostAreaDeleteBlock", blockX, blockY, blockZ);
-				noLuaCallError(&res);
-			}
+			areaDeleteBlockHook.callOriginal(
+			    Engine::areaDeleteBlock, zero, blockX, blockY, blockZ);
+			runPost(EnableKeys::AreaDeleteBlock, "PostAreaDeleteBlock", blockX,
+			        blockY, blockZ);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&areaDeleteBlockHook);
-		Engine::areaDeleteBlock(zero, blockX, blockY, blockZ);
+		areaDeleteBlockHook.callOriginal(
+		    Engine::areaDeleteBlock, zero, blockX, blockY, blockZ);
 	}
 }
 
+static void tickOverBudget(const TickProfiler::Sample& sample) {
+	if (enabledKeys[EnableKeys::TickOverBudget]) {
+		auto phases = lua->create_table();
+		for (int i = 0; i < TickProfiler::NumPhases; i++)
+			phases[TickProfiler::phaseNames[i]] = sample.phases[i] / 1000000.0;
+
+		runPre(EnableKeys::TickOverBudget, "TickOverBudget",
+		       sample.total / 1000000.0, phases);
+		return;
+	}
+
+	// Don't flood the console when every tick is over budget
+	static auto lastWarning = std::chrono::steady_clock::time_point();
+	auto now = std::chrono::steady_clock::now();
+	if (now - lastWarning < std::chrono::seconds(1)) return;
+	lastWarning = now;
+
+	std::ostringstream stream;
+	stream << RS_PREFIX "Tick took " << std::fixed << std::setprecision(2)
+	       << sample.total / 1000000.0 << "ms (";
+	for (int i = 0; i < TickProfiler::NumPhases; i++) {
+		if (i) stream << ", ";
+		stream << TickProfiler::phaseNames[i] << ' '
+		       << sample.phases[i] / 1000000.0 << "ms";
+	}
+	stream << ")\n";
+	Console::log(stream.str());
+}
+
 void logicSimulation() {
 	if (shouldReset) {
 		shouldReset = false;
@@ -394,360 +590,275 @@ void logicSimulation() {
 	bool noParent = false;
 
 	if (Console::shouldExit) {
-		if (enabledKeys[EnableKeys::InterruptSignal] && run != sol::nil) {
-			auto res = run("InterruptSignal");
-			noLuaCallError(&res);
-		}
+		if (enabledKeys[EnableKeys::InterruptSignal])
+			runPre(EnableKeys::InterruptSignal, "InterruptSignal");
 		Lua::os::exit();
 		return;
 	}
 
-	if (enabledKeys[EnableKeys::Logic]) {
-		if (run != sol::nil) {
-			auto res = run("Logic");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
-		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationHook);
-				Engine::logicSimulation();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogic");
-				noLuaCallError(&res);
+	if (tickProfiler.enabled) {
+		auto overBudgetSample = tickProfiler.beginTick();
+		if (overBudgetSample) tickOverBudget(*overBudgetSample);
+	}
+
+	{
+		// Always before the Logic hook, so callbacks see a consistent tick
+		ScopedTickPhase phase(tickProfiler, TickProfiler::HTTPCallbacks);
+		Lua::http::dispatchResponses();
+	}
+
+	{
+		ScopedTickPhase phase(tickProfiler, TickProfiler::Logic);
+		if (enabledKeys[EnableKeys::Logic]) {
+			noParent = runPre(EnableKeys::Logic, "Logic");
+			if (!noParent) {
+				logicSimulationHook.callOriginal(Engine::logicSimulation);
+				runPost(EnableKeys::Logic, "PostLogic");
 			}
+		} else {
+			logicSimulationHook.callOriginal(Engine::logicSimulation);
 		}
-	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationHook);
-		Engine::logicSimulation();
 	}
 
 	{
-		std::lock_guard<std::mutex> guard(Console::commandQueueMutex);
-		while (!Console::commandQueue.empty()) {
-			if (enabledKeys[EnableKeys::ConsoleInput] && run != sol::nil) {
-				auto res = run("ConsoleInput", Console::commandQueue.front());
-				noLuaCallError(&res);
+		ScopedTickPhase phase(tickProfiler, TickProfiler::ConsoleCommands);
+
+		{
+			std::lock_guard<std::mutex> guard(Console::commandQueueMutex);
+			while (!Console::commandQueue.empty()) {
+				const auto& command = Console::commandQueue.front();
+				if (command == "hookstats") {
+					logStats();
+				} else if (command == "hookstats on" || command == "hookstats off") {
+					collectStats = command == "hookstats on";
+					Console::log(RS_PREFIX "Hook latency collection " +
+					             command.substr(10) + "\n");
+				} else if (command == "hookstats reset") {
+					resetStats();
+				} else if (enabledKeys[EnableKeys::ConsoleInput]) {
+					runPre(EnableKeys::ConsoleInput, "ConsoleInput", command);
+				}
+				Console::commandQueue.pop();
 			}
-			Console::commandQueue.pop();
 		}
-	}
 
-	if (Console::isAwaitingAutoComplete()) {
-		if (enabledKeys[EnableKeys::ConsoleAutoComplete] && run != sol::nil) {
-			auto data = lua->create_table();
-			data["response"] = Console::getAutoCompleteInput();
+		if (Console::isAwaitingAutoComplete()) {
+			if (enabledKeys[EnableKeys::ConsoleAutoComplete]) {
+				auto data = lua->create_table();
+				data["response"] = Console::getAutoCompleteInput();
 
-			auto res = run("ConsoleAutoComplete", data);
-			noLuaCallError(&res);
+				runPre(EnableKeys::ConsoleAutoComplete, "ConsoleAutoComplete", data);
 
-			std::string response = data["response"];
-			Console::respondToAutoComplete(response);
-		} else {
-			Console::respondToAutoComplete(Console::getAutoCompleteInput());
+				std::string response = data["response"];
+				Console::respondToAutoComplete(response);
+			} else {
+				Console::respondToAutoComplete(Console::getAutoCompleteInput());
+			}
 		}
 	}
+
+	{
+		ScopedTickPhase phase(tickProfiler, TickProfiler::Observers);
+		flushObservedEvents();
+	}
+
+	if (worldDelta.enabled) {
+		ScopedTickPhase phase(tickProfiler, TickProfiler::WorldDelta);
+		worldDelta.capture(*Engine::ticksSinceReset);
+	}
 }
 
 void logicSimulationRace() {
 	if (enabledKeys[EnableKeys::LogicRace]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("LogicRace");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::LogicRace, "LogicRace");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationRaceHook);
-				Engine::logicSimulationRace();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogicRace");
-				noLuaCallError(&res);
-			}
+			logicSimulationRaceHook.callOriginal(Engine::logicSimulationRace);
+			runPost(EnableKeys::LogicRace, "PostLogicRace");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationRaceHook);
-		Engine::logicSimulationRace();
+		logicSimulationRaceHook.callOriginal(Engine::logicSimulationRace);
 	}
 }
 
 void logicSimulationRound() {
 	if (enabledKeys[EnableKeys::LogicRound]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("LogicRound");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::LogicRound, "LogicRound");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationRoundHook);
-				Engine::logicSimulationRound();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogicRound");
-				noLuaCallError(&res);
-			}
+			logicSimulationRoundHook.callOriginal(Engine::logicSimulationRound);
+			runPost(EnableKeys::LogicRound, "PostLogicRound");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationRoundHook);
-		Engine::logicSimulationRound();
+		logicSimulationRoundHook.callOriginal(Engine::logicSimulationRound);
 	}
 }
 
 void logicSimulationWorld() {
 	if (enabledKeys[EnableKeys::LogicWorld]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("LogicWorld");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::LogicWorld, "LogicWorld");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationWorldHook);
-				Engine::logicSimulationWorld();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogicWorld");
-				noLuaCallError(&res);
-			}
+			logicSimulationWorldHook.callOriginal(Engine::logicSimulationWorld);
+			runPost(EnableKeys::LogicWorld, "PostLogicWorld");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationWorldHook);
-		Engine::logicSimulationWorld();
+		logicSimulationWorldHook.callOriginal(Engine::logicSimulationWorld);
 	}
 }
 
 void logicSimulationTerminator() {
 	if (enabledKeys[EnableKeys::LogicTerminator]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("LogicTerminator");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::LogicTerminator, "LogicTerminator");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationTerminatorHook);
-				Engine::logicSimulationTerminator();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogicTerminator");
-				noLuaCallError(&res);
-			}
+			logicSimulationTerminatorHook.callOriginal(
+			    Engine::logicSimulationTerminator);
+			runPost(EnableKeys::LogicTerminator, "PostLogicTerminator");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationTerminatorHook);
-		Engine::logicSimulationTerminator();
+		logicSimulationTerminatorHook.callOriginal(
+		    Engine::logicSimulationTerminator);
 	}
 }
 
 void logicSimulationCoop() {
 	if (enabledKeys[EnableKeys::LogicCoop]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("LogicCoop");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::LogicCoop, "LogicCoop");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationCoopHook);
-				Engine::logicSimulationCoop();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogicCoop");
-				noLuaCallError(&res);
-			}
+			logicSimulationCoopHook.callOriginal(Engine::logicSimulationCoop);
+			runPost(EnableKeys::LogicCoop, "PostLogicCoop");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationCoopHook);
-		Engine::logicSimulationCoop();
+		logicSimulationCoopHook.callOriginal(Engine::logicSimulationCoop);
 	}
 }
 
 void logicSimulationVersus() {
 	if (enabledKeys[EnableKeys::LogicVersus]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("LogicVersus");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::LogicVersus, "LogicVersus");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicSimulationVersusHook);
-				Engine::logicSimulationVersus();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostLogicVersus");
-				noLuaCallError(&res);
-			}
+			logicSimulationVersusHook.callOriginal(Engine::logicSimulationVersus);
+			runPost(EnableKeys::LogicVersus, "PostLogicVersus");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicSimulationVersusHook);
-		Engine::logicSimulationVersus();
+		logicSimulationVersusHook.callOriginal(Engine::logicSimulationVersus);
 	}
 }
 
 void logicPlayerActions(int playerID) {
 	if (enabledKeys[EnableKeys::PlayerActions]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PlayerActions", &Engine::players[playerID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::PlayerActions, "PlayerActions",
+		                       &Engine::players[playerID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&logicPlayerActionsHook);
-				Engine::logicPlayerActions(playerID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPlayerActions", &Engine::players[playerID]);
-				noLuaCallError(&res);
-			}
+			logicPlayerActionsHook.callOriginal(Engine::logicPlayerActions, playerID);
+			runPost(EnableKeys::PlayerActions, "PostPlayerActions",
+			        &Engine::players[playerID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&logicPlayerActionsHook);
-		Engine::logicPlayerActions(playerID);
+		logicPlayerActionsHook.callOriginal(Engine::logicPlayerActions, playerID);
 	}
 }
 
 void physicsSimulation() {
+	ScopedTickPhase phase(tickProfiler, TickProfiler::Physics);
+
 	if (enabledKeys[EnableKeys::Physics]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("Physics");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::Physics, "Physics");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&physicsSimulationHook);
-				Engine::physicsSimulation();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPhysics");
-				noLuaCallError(&res);
-			}
+			physicsSimulationHook.callOriginal(Engine::physicsSimulation);
+			if (spatialHash.enabled) updateSpatialHash();
+			runPost(EnableKeys::Physics, "PostPhysics");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&physicsSimulationHook);
-		Engine::physicsSimulation();
+		physicsSimulationHook.callOriginal(Engine::physicsSimulation);
+		if (spatialHash.enabled) updateSpatialHash();
 	}
 }
 
 void rigidBodySimulation() {
+	ScopedTickPhase phase(tickProfiler, TickProfiler::RigidBodies);
+
 	if (enabledKeys[EnableKeys::PhysicsRigidBodies]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PhysicsRigidBodies");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::PhysicsRigidBodies,
+		                       "PhysicsRigidBodies");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&rigidBodySimulationHook);
-				Engine::rigidBodySimulation();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPhysicsRigidBodies");
-				noLuaCallError(&res);
-			}
+			rigidBodySimulationHook.callOriginal(Engine::rigidBodySimulation);
+			runPost(EnableKeys::PhysicsRigidBodies, "PostPhysicsRigidBodies");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&rigidBodySimulationHook);
-		Engine::rigidBodySimulation();
+		rigidBodySimulationHook.callOriginal(Engine::rigidBodySimulation);
 	}
 }
 
 void vehicleSimulateSuspensions() {
 	if (enabledKeys[EnableKeys::VehicleSuspensions]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("VehicleSuspensions");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::VehicleSuspensions,
+		                       "VehicleSuspensions");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&vehicleSimulateSuspensionsHook);
-				Engine::vehicleSimulateSuspensions();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostVehicleSuspensions");
-				noLuaCallError(&res);
-			}
+			vehicleSimulateSuspensionsHook.callOriginal(
+			    Engine::vehicleSimulateSuspensions);
+			runPost(EnableKeys::VehicleSuspensions, "PostVehicleSuspensions");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&vehicleSimulateSuspensionsHook);
-		Engine::vehicleSimulateSuspensions();
+		vehicleSimulateSuspensionsHook.callOriginal(
+		    Engine::vehicleSimulateSuspensions);
 	}
 }
 
 void itemWeaponSimulation(int itemID) {
 	if (enabledKeys[EnableKeys::ItemWeaponSimulation]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("ItemWeaponSimulation", &Engine::items[itemID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::ItemWeaponSimulation,
+		                       "ItemWeaponSimulation", &Engine::items[itemID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&itemWeaponSimulationHook);
-				Engine::itemWeaponSimulation(itemID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostItemWeaponSimulation", &Engine::items[itemID]);
-				noLuaCallError(&res);
-			}
+			itemWeaponSimulationHook.callOriginal(
+			    Engine::itemWeaponSimulation, itemID);
+			runPost(EnableKeys::ItemWeaponSimulation, "PostItemWeaponSimulation",
+			        &Engine::items[itemID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&itemWeaponSimulationHook);
-		Engine::itemWeaponSimulation(itemID);
+		itemWeaponSimulationHook.callOriginal(Engine::itemWeaponSimulation, itemID);
 	}
 }
 
 int serverReceive() {
+	ScopedTickPhase phase(tickProfiler, TickProfiler::ServerReceive);
+
 	if (enabledKeys[EnableKeys::ServerReceive]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("ServerReceive");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::ServerReceive, "ServerReceive");
 		if (!noParent) {
-			int ret;
-			{
-				subhook::ScopedHookRemove remove(&serverReceiveHook);
-				ret = Engine::serverReceive();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostServerReceive");
-				noLuaCallError(&res);
-			}
+			int ret = serverReceiveHook.callOriginal(Engine::serverReceive);
+			runPost(EnableKeys::ServerReceive, "PostServerReceive");
 			return ret;
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&serverReceiveHook);
-		return Engine::serverReceive();
+		return serverReceiveHook.callOriginal(Engine::serverReceive);
+	}
+}
+
+// Every connection is serialized by serverSend, so the batch hook gets all of
+// them in one call instead of one PacketBuilding call each.
+static void packetBuildingBatch() {
+	if (!enabledKeys[EnableKeys::PacketBuildingBatch]) return;
+
+	auto connections = lua->create_table(*Engine::numConnections, 0);
+	for (unsigned int i = 0; i < *Engine::numConnections; i++) {
+		connections[i + 1] = &Engine::connections[i];
 	}
+
+	runPre(EnableKeys::PacketBuildingBatch, "PacketBuildingBatch", connections);
 }
 
 void serverSend() {
+	ScopedTickPhase phase(tickProfiler, TickProfiler::ServerSend);
+
 	if (enabledKeys[EnableKeys::ServerSend]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("ServerSend");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::ServerSend, "ServerSend");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&serverSendHook);
-				Engine::serverSend();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostServerSend");
-				noLuaCallError(&res);
-			}
+			packetBuildingBatch();
+			serverSendHook.callOriginal(Engine::serverSend);
+			runPost(EnableKeys::ServerSend, "PostServerSend");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&serverSendHook);
-		Engine::serverSend();
+		packetBuildingBatch();
+		serverSendHook.callOriginal(Engine::serverSend);
 	}
 }
 
@@ -760,143 +871,91 @@ int packetWrite(void* source, int elementSize, int elementCount) {
 		Connection* connection =
 		    reinterpret_cast<Connection*>(connectionPlus4c - 0x4c);
 
-		if (run != sol::nil) {
-			auto res = run("PacketBuilding", connection);
-			noLuaCallError(&res);
-		}
+		runPre(EnableKeys::PacketBuilding, "PacketBuilding", connection);
 	}
 
-	subhook::ScopedHookRemove remove(&packetWriteHook);
-	return Engine::packetWrite(source, elementSize, elementCount);
+	return packetWriteHook.callOriginal(
+	    Engine::packetWrite, source, elementSize, elementCount);
 }
 
 void calculatePlayerVoice(int connectionID, int playerID) {
 	if (enabledKeys[EnableKeys::CalculateEarShots]) {
-		bool noParent = false;
 
 		auto connection = &Engine::connections[connectionID];
 		auto player = &Engine::players[playerID];
 
-		if (run != sol::nil) {
-			auto res = run("CalculateEarShots", connection, player);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::CalculateEarShots, "CalculateEarShots",
+		                       connection, player);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&calculatePlayerVoiceHook);
-				Engine::calculatePlayerVoice(connectionID, playerID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostCalculateEarShots", connection, player);
-				noLuaCallError(&res);
-			}
+			calculatePlayerVoiceHook.callOriginal(
+			    Engine::calculatePlayerVoice, connectionID, playerID);
+			runPost(EnableKeys::CalculateEarShots, "PostCalculateEarShots",
+			        connection, player);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&calculatePlayerVoiceHook);
-		Engine::calculatePlayerVoice(connectionID, playerID);
+		calculatePlayerVoiceHook.callOriginal(
+		    Engine::calculatePlayerVoice, connectionID, playerID);
 	}
 }
 
 int sendPacket(unsigned int address, unsigned short port) {
 	if (enabledKeys[EnableKeys::SendPacket]) {
-		bool noParent = false;
 
 		auto addressString = addressFromInteger(address);
 		int packetType = Engine::packet[4];
 		int packetSize = *Engine::packetSize;
 
-		if (run != sol::nil) {
-			auto res = run("SendPacket", addressString, port, packetType, packetSize);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::SendPacket, "SendPacket", addressString,
+		                       port, packetType, packetSize);
 		if (!noParent) {
-			int ret;
-			{
-				subhook::ScopedHookRemove remove(&sendPacketHook);
-				ret = Engine::sendPacket(address, port);
-			}
-			if (run != sol::nil) {
-				auto res =
-				    run("PostSendPacket", addressString, port, packetType, packetSize);
-				noLuaCallError(&res);
-			}
+			int ret = sendPacketHook.callOriginal(Engine::sendPacket, address, port);
+			runPost(EnableKeys::SendPacket, "PostSendPacket", addressString, port,
+			        packetType, packetSize);
 			return ret;
 		}
 		return 0;
 	} else {
-		subhook::ScopedHookRemove remove(&sendPacketHook);
-		return Engine::sendPacket(address, port);
+		return sendPacketHook.callOriginal(Engine::sendPacket, address, port);
 	}
 }
 
 void bulletSimulation() {
+	ScopedTickPhase phase(tickProfiler, TickProfiler::Bullets);
+
 	isInBulletSimulation = true;
 	if (enabledKeys[EnableKeys::PhysicsBullets]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PhysicsBullets");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::PhysicsBullets, "PhysicsBullets");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&bulletSimulationHook);
-				Engine::bulletSimulation();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPhysicsBullets");
-				noLuaCallError(&res);
-			}
+			bulletSimulationHook.callOriginal(Engine::bulletSimulation);
+			runPost(EnableKeys::PhysicsBullets, "PostPhysicsBullets");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&bulletSimulationHook);
-		Engine::bulletSimulation();
+		bulletSimulationHook.callOriginal(Engine::bulletSimulation);
 	}
 	isInBulletSimulation = false;
 }
 
 void economyCarMarket() {
 	if (enabledKeys[EnableKeys::EconomyCarMarket]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("EconomyCarMarket");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::EconomyCarMarket, "EconomyCarMarket");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&economyCarMarketHook);
-				Engine::economyCarMarket();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEconomyCarMarket");
-				noLuaCallError(&res);
-			}
+			economyCarMarketHook.callOriginal(Engine::economyCarMarket);
+			runPost(EnableKeys::EconomyCarMarket, "PostEconomyCarMarket");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&economyCarMarketHook);
-		Engine::economyCarMarket();
+		economyCarMarketHook.callOriginal(Engine::economyCarMarket);
 	}
 }
 
 void saveAccountsServer() {
 	if (enabledKeys[EnableKeys::AccountsSave]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("AccountsSave");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::AccountsSave, "AccountsSave");
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&saveAccountsServerHook);
-				Engine::saveAccountsServer();
-			}
-			if (run != sol::nil) {
-				auto res = run("PostAccountsSave");
-				noLuaCallError(&res);
-			}
+			saveAccountsServerHook.callOriginal(Engine::saveAccountsServer);
+			runPost(EnableKeys::AccountsSave, "PostAccountsSave");
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&saveAccountsServerHook);
-		Engine::saveAccountsServer();
+		saveAccountsServerHook.callOriginal(Engine::saveAccountsServer);
 	}
 }
 
@@ -904,130 +963,94 @@ int createAccountByJoinTicket(int identifier, unsigned int ticket) {
 	if (enabledKeys[EnableKeys::AccountTicketBegin] ||
 	    enabledKeys[EnableKeys::AccountTicketFound] ||
 	    enabledKeys[EnableKeys::AccountTicket]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("AccountTicketBegin", identifier, ticket);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::AccountTicketBegin, "AccountTicketBegin",
+		                       identifier, ticket);
 		if (!noParent) {
-			int id;
-			{
-				subhook::ScopedHookRemove remove(&createAccountByJoinTicketHook);
-				id = Engine::createAccountByJoinTicket(identifier, ticket);
-			}
-			if (run != sol::nil) {
-				auto res =
-				    run("AccountTicketFound", id < 0 ? nullptr : &Engine::accounts[id]);
-				noParent = false;
-				if (noLuaCallError(&res)) noParent = (bool)res;
-
-				if (!noParent) {
-					auto res = run("PostAccountTicket",
-					               id < 0 ? nullptr : &Engine::accounts[id]);
-					noLuaCallError(&res);
-					return id;
-				}
-				return -1;
+			int id = createAccountByJoinTicketHook.callOriginal(
+			    Engine::createAccountByJoinTicket, identifier, ticket);
+			invalidateAccountLookups();
+			Account* account = id < 0 ? nullptr : &Engine::accounts[id];
+
+			noParent = runPre(EnableKeys::AccountTicketFound, "AccountTicketFound",
+			                  account);
+			if (!noParent) {
+				runPost(EnableKeys::AccountTicket, "PostAccountTicket", account);
+				return id;
 			}
-			return id;
+			return -1;
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&createAccountByJoinTicketHook);
-		return Engine::createAccountByJoinTicket(identifier, ticket);
+		int id = createAccountByJoinTicketHook.callOriginal(
+		    Engine::createAccountByJoinTicket, identifier, ticket);
+		invalidateAccountLookups();
+		return id;
 	}
 }
 
 void serverSendConnectResponse(unsigned int address, unsigned int port, int unk,
                                const char* message) {
 	if (enabledKeys[EnableKeys::SendConnectResponse]) {
-		bool noParent = false;
-
 		auto addressString = addressFromInteger(address);
 
 		auto data = lua->create_table();
 		data["message"] = message;
-		std::string newMessage;
-
-		if (run != sol::nil) {
-			auto res = run("SendConnectResponse", addressString, port, data);
-			if (noLuaCallError(&res)) {
-				noParent = (bool)res;
-				newMessage = data["message"];
-				message = newMessage.c_str();
-			}
-		}
+
+		bool noParent = runPre(EnableKeys::SendConnectResponse,
+		                       "SendConnectResponse", addressString, port, data);
+		std::string newMessage = data["message"];
+		message = newMessage.c_str();
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&serverSendConnectResponseHook);
-				Engine::serverSendConnectResponse(address, port, unk, message);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostSendConnectResponse", addressString, port, data);
-				noLuaCallError(&res);
-			}
+			serverSendConnectResponseHook.callOriginal(
+			    Engine::serverSendConnectResponse, address, port, unk, message);
+			runPost(EnableKeys::SendConnectResponse, "PostSendConnectResponse",
+			        addressString, port, data);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&serverSendConnectResponseHook);
-		Engine::serverSendConnectResponse(address, port, unk, message);
+		serverSendConnectResponseHook.callOriginal(
+		    Engine::serverSendConnectResponse, address, port, unk, message);
 	}
 }
 
 int createBullet(int type, Vector* pos, Vector* vel, int playerID) {
 	if (enabledKeys[EnableKeys::BulletCreate]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res =
-			    run("BulletCreate", type, pos, vel, &Engine::players[playerID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::BulletCreate, "BulletCreate", type, pos,
+		                       vel, &Engine::players[playerID]);
 		if (!noParent) {
-			int id;
-			{
-				subhook::ScopedHookRemove remove(&createBulletHook);
-				id = Engine::createBullet(type, pos, vel, playerID);
-			}
-			if (run != sol::nil && id != -1) {
-				auto res = run("PostBulletCreate", &Engine::bullets[id]);
-				noLuaCallError(&res);
+			int id = createBulletHook.callOriginal(
+			    Engine::createBullet, type, pos, vel, playerID);
+			if (id != -1) {
+				runPost(EnableKeys::BulletCreate, "PostBulletCreate",
+				        &Engine::bullets[id]);
 			}
 			return id;
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&createBulletHook);
-		return Engine::createBullet(type, pos, vel, playerID);
+		return createBulletHook.callOriginal(
+		    Engine::createBullet, type, pos, vel, playerID);
 	}
 }
 
 int createPlayer() {
 	if (enabledKeys[EnableKeys::PlayerCreate]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PlayerCreate");
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::PlayerCreate, "PlayerCreate");
 		if (!noParent) {
-			int id;
-			{
-				subhook::ScopedHookRemove remove(&createPlayerHook);
-				id = Engine::createPlayer();
-
-				if (id != -1 && playerDataTables[id]) {
-					delete playerDataTables[id];
-					playerDataTables[id] = nullptr;
-				}
+			int id = createPlayerHook.callOriginal(Engine::createPlayer);
+
+			if (id != -1 && playerDataTables[id]) {
+				delete playerDataTables[id];
+				playerDataTables[id] = nullptr;
 			}
-			if (run != sol::nil && id != -1) {
-				auto res = run("PostPlayerCreate", &Engine::players[id]);
-				noLuaCallError(&res);
+			if (id != -1) {
+				runPost(EnableKeys::PlayerCreate, "PostPlayerCreate",
+				        &Engine::players[id]);
 			}
 			return id;
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&createPlayerHook);
-		int id = Engine::createPlayer();
+		int id = createPlayerHook.callOriginal(Engine::createPlayer);
 
 		if (id != -1 && playerDataTables[id]) {
 			delete playerDataTables[id];
@@ -1040,28 +1063,19 @@ int createPlayer() {
 
 void deletePlayer(int playerID) {
 	if (enabledKeys[EnableKeys::PlayerDelete]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PlayerDelete", &Engine::players[playerID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::PlayerDelete, "PlayerDelete",
+		                       &Engine::players[playerID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&deletePlayerHook);
-				Engine::deletePlayer(playerID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPlayerDelete", &Engine::players[playerID]);
-				noLuaCallError(&res);
-			}
+			deletePlayerHook.callOriginal(Engine::deletePlayer, playerID);
+			runPost(EnableKeys::PlayerDelete, "PostPlayerDelete",
+			        &Engine::players[playerID]);
 			if (playerDataTables[playerID]) {
 				delete playerDataTables[playerID];
 				playerDataTables[playerID] = nullptr;
 			}
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&deletePlayerHook);
-		Engine::deletePlayer(playerID);
+		deletePlayerHook.callOriginal(Engine::deletePlayer, playerID);
 
 		if (playerDataTables[playerID]) {
 			delete playerDataTables[playerID];
@@ -1072,32 +1086,28 @@ void deletePlayer(int playerID) {
 
 int createHuman(Vector* pos, RotMatrix* rot, int playerID) {
 	if (enabledKeys[EnableKeys::HumanCreate]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("HumanCreate", pos, rot, &Engine::players[playerID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::HumanCreate, "HumanCreate", pos, rot,
+		                       &Engine::players[playerID]);
 		if (!noParent) {
-			int id;
-			{
-				subhook::ScopedHookRemove remove(&createHumanHook);
-				id = Engine::createHuman(pos, rot, playerID);
-
-				if (id != -1 && humanDataTables[id]) {
-					delete humanDataTables[id];
-					humanDataTables[id] = nullptr;
-				}
+			int id = createHumanHook.callOriginal(
+			    Engine::createHuman, pos, rot, playerID);
+			if (id != -1) trackCreated(SpatialHash::Humans, id);
+
+			if (id != -1 && humanDataTables[id]) {
+				delete humanDataTables[id];
+				humanDataTables[id] = nullptr;
 			}
-			if (run != sol::nil && id != -1) {
-				auto res = run("PostHumanCreate", &Engine::humans[id]);
-				noLuaCallError(&res);
+			if (id != -1) {
+				runPost(EnableKeys::HumanCreate, "PostHumanCreate",
+				        &Engine::humans[id]);
 			}
 			return id;
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&createHumanHook);
-		int id = Engine::createHuman(pos, rot, playerID);
+		int id = createHumanHook.callOriginal(
+		    Engine::createHuman, pos, rot, playerID);
+		if (id != -1) trackCreated(SpatialHash::Humans, id);
 
 		if (id != -1 && humanDataTables[id]) {
 			delete humanDataTables[id];
@@ -1110,28 +1120,21 @@ int createHuman(Vector* pos, RotMatrix* rot, int playerID) {
 
 void deleteHuman(int humanID) {
 	if (enabledKeys[EnableKeys::HumanDelete]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("HumanDelete", &Engine::humans[humanID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::HumanDelete, "HumanDelete",
+		                       &Engine::humans[humanID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&deleteHumanHook);
-				Engine::deleteHuman(humanID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostHumanDelete", &Engine::humans[humanID]);
-				noLuaCallError(&res);
-			}
+			deleteHumanHook.callOriginal(Engine::deleteHuman, humanID);
+			trackDeleted(SpatialHash::Humans, humanID);
+			runPost(EnableKeys::HumanDelete, "PostHumanDelete",
+			        &Engine::humans[humanID]);
 			if (humanDataTables[humanID]) {
 				delete humanDataTables[humanID];
 				humanDataTables[humanID] = nullptr;
 			}
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&deleteHumanHook);
-		Engine::deleteHuman(humanID);
+		deleteHumanHook.callOriginal(Engine::deleteHuman, humanID);
+		trackDeleted(SpatialHash::Humans, humanID);
 
 		if (humanDataTables[humanID]) {
 			delete humanDataTables[humanID];
@@ -1142,20 +1145,14 @@ void deleteHuman(int humanID) {
 
 int createItem(int type, Vector* pos, Vector* vel, RotMatrix* rot) {
 	if (enabledKeys[EnableKeys::ItemCreate]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("ItemCreate", &Engine::itemTypes[type], pos, rot);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::ItemCreate, "ItemCreate",
+		                       &Engine::itemTypes[type], pos, rot);
 		if (!noParent) {
-			int id;
-			{
-				subhook::ScopedHookRemove remove(&createItemHook);
-				id = Engine::createItem(type, pos, vel, rot);
-			}
-			if (id != -1 && run != sol::nil) {
-				auto res = run("PostItemCreate", &Engine::items[id]);
-				noLuaCallError(&res);
+			int id = createItemHook.callOriginal(
+			    Engine::createItem, type, pos, vel, rot);
+			if (id != -1) trackCreated(SpatialHash::Items, id);
+			if (id != -1) {
+				runPost(EnableKeys::ItemCreate, "PostItemCreate", &Engine::items[id]);
 			}
 			if (id != -1 && itemDataTables[id]) {
 				delete itemDataTables[id];
@@ -1165,8 +1162,9 @@ int createItem(int type, Vector* pos, Vector* vel, RotMatrix* rot) {
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&createItemHook);
-		int id = Engine::createItem(type, pos, vel, rot);
+		int id = createItemHook.callOriginal(
+		    Engine::createItem, type, pos, vel, rot);
+		if (id != -1) trackCreated(SpatialHash::Items, id);
 
 		if (id != -1 && itemDataTables[id]) {
 			delete itemDataTables[id];
@@ -1179,28 +1177,20 @@ int createItem(int type, Vector* pos, Vector* vel, RotMatrix* rot) {
 
 void deleteItem(int itemID) {
 	if (enabledKeys[EnableKeys::ItemDelete]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("ItemDelete", &Engine::items[itemID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::ItemDelete, "ItemDelete",
+		                       &Engine::items[itemID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&deleteItemHook);
-				Engine::deleteItem(itemID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostItemDelete", &Engine::items[itemID]);
-				noLuaCallError(&res);
-			}
+			deleteItemHook.callOriginal(Engine::deleteItem, itemID);
+			trackDeleted(SpatialHash::Items, itemID);
+			runPost(EnableKeys::ItemDelete, "PostItemDelete", &Engine::items[itemID]);
 			if (itemDataTables[itemID]) {
 				delete itemDataTables[itemID];
 				itemDataTables[itemID] = nullptr;
 			}
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&deleteItemHook);
-		Engine::deleteItem(itemID);
+		deleteItemHook.callOriginal(Engine::deleteItem, itemID);
+		trackDeleted(SpatialHash::Items, itemID);
 
 		if (itemDataTables[itemID]) {
 			delete itemDataTables[itemID];
@@ -1212,33 +1202,28 @@ void deleteItem(int itemID) {
 int createVehicle(int type, Vector* pos, Vector* vel, RotMatrix* rot,
                   int color) {
 	if (enabledKeys[EnableKeys::VehicleCreate]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res =
-			    run("VehicleCreate", &Engine::vehicleTypes[type], pos, rot, color);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::VehicleCreate, "VehicleCreate",
+		                       &Engine::vehicleTypes[type], pos, rot, color);
 		if (!noParent) {
-			int id;
-			{
-				subhook::ScopedHookRemove remove(&createVehicleHook);
-				id = Engine::createVehicle(type, pos, vel, rot, color);
-
-				if (id != -1 && vehicleDataTables[id]) {
-					delete vehicleDataTables[id];
-					vehicleDataTables[id] = nullptr;
-				}
+			int id = createVehicleHook.callOriginal(
+			    Engine::createVehicle, type, pos, vel, rot, color);
+			if (id != -1) trackCreated(SpatialHash::Vehicles, id);
+
+			if (id != -1 && vehicleDataTables[id]) {
+				delete vehicleDataTables[id];
+				vehicleDataTables[id] = nullptr;
 			}
-			if (id != -1 && run != sol::nil) {
-				auto res = run("PostVehicleCreate", &Engine::vehicles[id]);
-				noLuaCallError(&res);
+			if (id != -1) {
+				runPost(EnableKeys::VehicleCreate, "PostVehicleCreate",
+				        &Engine::vehicles[id]);
 			}
 			return id;
 		}
 		return -1;
 	} else {
-		subhook::ScopedHookRemove remove(&createVehicleHook);
-		int id = Engine::createVehicle(type, pos, vel, rot, color);
+		int id = createVehicleHook.callOriginal(
+		    Engine::createVehicle, type, pos, vel, rot, color);
+		if (id != -1) trackCreated(SpatialHash::Vehicles, id);
 
 		if (id != -1 && vehicleDataTables[id]) {
 			delete vehicleDataTables[id];
@@ -1251,28 +1236,21 @@ int createVehicle(int type, Vector* pos, Vector* vel, RotMatrix* rot,
 
 void deleteVehicle(int vehicleID) {
 	if (enabledKeys[EnableKeys::VehicleDelete]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("VehicleDelete", &Engine::vehicles[vehicleID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::VehicleDelete, "VehicleDelete",
+		                       &Engine::vehicles[vehicleID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&deleteVehicleHook);
-				Engine::deleteVehicle(vehicleID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostVehicleDelete", &Engine::vehicles[vehicleID]);
-				noLuaCallError(&res);
-			}
+			deleteVehicleHook.callOriginal(Engine::deleteVehicle, vehicleID);
+			trackDeleted(SpatialHash::Vehicles, vehicleID);
+			runPost(EnableKeys::VehicleDelete, "PostVehicleDelete",
+			        &Engine::vehicles[vehicleID]);
 			if (vehicleDataTables[vehicleID]) {
 				delete vehicleDataTables[vehicleID];
 				vehicleDataTables[vehicleID] = nullptr;
 			}
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&deleteVehicleHook);
-		Engine::deleteVehicle(vehicleID);
+		deleteVehicleHook.callOriginal(Engine::deleteVehicle, vehicleID);
+		trackDeleted(SpatialHash::Vehicles, vehicleID);
 
 		if (vehicleDataTables[vehicleID]) {
 			delete vehicleDataTables[vehicleID];
@@ -1283,11 +1261,9 @@ void deleteVehicle(int vehicleID) {
 
 int createRigidBody(int type, Vector* pos, RotMatrix* rot, Vector* vel,
                     Vector* scale, float mass) {
-	int id;
-	{
-		subhook::ScopedHookRemove remove(&createRigidBodyHook);
-		id = Engine::createRigidBody(type, pos, rot, vel, scale, mass);
-	}
+	int id = createRigidBodyHook.callOriginal(
+	    Engine::createRigidBody, type, pos, rot, vel, scale, mass);
+	if (id != -1) trackCreated(SpatialHash::RigidBodies, id);
 	if (id != -1 && bodyDataTables[id]) {
 		delete bodyDataTables[id];
 		bodyDataTables[id] = nullptr;
@@ -1297,107 +1273,72 @@ int createRigidBody(int type, Vector* pos, RotMatrix* rot, Vector* vel,
 
 int linkItem(int itemID, int childItemID, int parentHumanID, int slot) {
 	if (enabledKeys[EnableKeys::ItemLink]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run(
-			    "ItemLink", &Engine::items[itemID],
-			    childItemID == -1 ? nullptr : &Engine::items[childItemID],
-			    parentHumanID == -1 ? nullptr : &Engine::humans[parentHumanID], slot);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(
+		    EnableKeys::ItemLink, "ItemLink", &Engine::items[itemID],
+		    childItemID == -1 ? nullptr : &Engine::items[childItemID],
+		    parentHumanID == -1 ? nullptr : &Engine::humans[parentHumanID], slot);
 		if (!noParent) {
-			int worked;
-			{
-				subhook::ScopedHookRemove remove(&linkItemHook);
-				worked = Engine::linkItem(itemID, childItemID, parentHumanID, slot);
-			}
-			if (run != sol::nil) {
-				auto res =
-				    run("PostItemLink", &Engine::items[itemID],
-				        childItemID == -1 ? nullptr : &Engine::items[childItemID],
-				        parentHumanID == -1 ? nullptr : &Engine::humans[parentHumanID],
-				        slot, (bool)worked);
-				noLuaCallError(&res);
-			}
+			int worked = linkItemHook.callOriginal(
+			    Engine::linkItem, itemID, childItemID, parentHumanID, slot);
+			runPost(EnableKeys::ItemLink, "PostItemLink", &Engine::items[itemID],
+			        childItemID == -1 ? nullptr : &Engine::items[childItemID],
+			        parentHumanID == -1 ? nullptr : &Engine::humans[parentHumanID],
+			        slot, (bool)worked);
 			return worked;
 		}
 		return 0;
 	} else {
-		subhook::ScopedHookRemove remove(&linkItemHook);
-		return Engine::linkItem(itemID, childItemID, parentHumanID, slot);
+		return linkItemHook.callOriginal(
+		    Engine::linkItem, itemID, childItemID, parentHumanID, slot);
 	}
 }
 
 void itemComputerInput(int itemID, unsigned int character) {
 	if (enabledKeys[EnableKeys::ItemComputerInput]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("ItemComputerInput", &Engine::items[itemID], character);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::ItemComputerInput, "ItemComputerInput",
+		                       &Engine::items[itemID], character);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&itemComputerInputHook);
-				Engine::itemComputerInput(itemID, character);
-			}
-			if (run != sol::nil) {
-				auto res =
-				    run("PostItemComputerInput", &Engine::items[itemID], character);
-				noLuaCallError(&res);
-			}
+			itemComputerInputHook.callOriginal(
+			    Engine::itemComputerInput, itemID, character);
+			runPost(EnableKeys::ItemComputerInput, "PostItemComputerInput",
+			        &Engine::items[itemID], character);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&itemComputerInputHook);
-		Engine::itemComputerInput(itemID, character);
+		itemComputerInputHook.callOriginal(
+		    Engine::itemComputerInput, itemID, character);
 	}
 }
 
 void humanApplyDamage(int humanID, int bone, int unk, int damage) {
 	if (enabledKeys[EnableKeys::HumanDamage]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("HumanDamage", &Engine::humans[humanID], bone, damage);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::HumanDamage, "HumanDamage",
+		                       &Engine::humans[humanID], bone, damage);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&humanApplyDamageHook);
-				Engine::humanApplyDamage(humanID, bone, unk, damage);
-			}
-			if (run != sol::nil) {
-				auto res =
-				    run("PostHumanDamage", &Engine::humans[humanID], bone, damage);
-				noLuaCallError(&res);
-			}
+			humanApplyDamageHook.callOriginal(
+			    Engine::humanApplyDamage, humanID, bone, unk, damage);
+			runPost(EnableKeys::HumanDamage, "PostHumanDamage",
+			        &Engine::humans[humanID], bone, damage);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&humanApplyDamageHook);
-		Engine::humanApplyDamage(humanID, bone, unk, damage);
+		humanApplyDamageHook.callOriginal(
+		    Engine::humanApplyDamage, humanID, bone, unk, damage);
 	}
 }
 
 void humanCollisionVehicle(int humanID, int vehicleID) {
 	if (enabledKeys[EnableKeys::HumanCollisionVehicle]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("HumanCollisionVehicle", &Engine::humans[humanID],
-			               &Engine::vehicles[vehicleID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::HumanCollisionVehicle,
+		                       "HumanCollisionVehicle", &Engine::humans[humanID],
+		                       &Engine::vehicles[vehicleID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&humanCollisionVehicleHook);
-				Engine::humanCollisionVehicle(humanID, vehicleID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostHumanCollisionVehicle", &Engine::humans[humanID],
-				               &Engine::vehicles[vehicleID]);
-				noLuaCallError(&res);
-			}
+			humanCollisionVehicleHook.callOriginal(
+			    Engine::humanCollisionVehicle, humanID, vehicleID);
+			runPost(EnableKeys::HumanCollisionVehicle, "PostHumanCollisionVehicle",
+			        &Engine::humans[humanID], &Engine::vehicles[vehicleID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&humanCollisionVehicleHook);
-		Engine::humanCollisionVehicle(humanID, vehicleID);
+		humanCollisionVehicleHook.callOriginal(
+		    Engine::humanCollisionVehicle, humanID, vehicleID);
 	}
 }
 
@@ -1408,199 +1349,143 @@ void humanLimbInverseKinematics(int humanID, int trunkBoneID, int branchBoneID,
                                 Vector* vecB, Vector* vecC, Vector* vecD,
                                 char flags) {
 	if (enabledKeys[EnableKeys::HumanLimbInverseKinematics]) {
-		bool noParent = false;
 
-		if (run != sol::nil) {
-			Float wrappedA = {a};
-			Float wrappedRot = {rot};
-			Float wrappedStrength = {strength};
-			Integer wrappedFlags = {+flags};
-
-			auto res = run("HumanLimbInverseKinematics", &Engine::humans[humanID],
-			               trunkBoneID, branchBoneID, destination, destinationAxis,
-			               vecA, &wrappedA, &wrappedRot, &wrappedStrength, vecB, vecC,
-			               vecD, &wrappedFlags);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-
-			a = wrappedA.value;
-			rot = wrappedRot.value;
-			strength = wrappedStrength.value;
-			flags = wrappedFlags.value;
-		}
+		Float wrappedA = {a};
+		Float wrappedRot = {rot};
+		Float wrappedStrength = {strength};
+		Integer wrappedFlags = {+flags};
+
+		bool noParent = runPre(EnableKeys::HumanLimbInverseKinematics,
+		                       "HumanLimbInverseKinematics",
+		                       &Engine::humans[humanID], trunkBoneID, branchBoneID,
+		                       destination, destinationAxis, vecA, &wrappedA,
+		                       &wrappedRot, &wrappedStrength, vecB, vecC, vecD,
+		                       &wrappedFlags);
+
+		a = wrappedA.value;
+		rot = wrappedRot.value;
+		strength = wrappedStrength.value;
+		flags = wrappedFlags.value;
 		if (!noParent) {
-			subhook::ScopedHookRemove remove(&humanLimbInverseKinematicsHook);
-			Engine::humanLimbInverseKinematics(
-			    humanID, trunkBoneID, branchBoneID, destination, destinationAxis,
-			    vecA, a, rot, strength, d, vecB, vecC, vecD, flags);
+			humanLimbInverseKinematicsHook.callOriginal(
+			    Engine::humanLimbInverseKinematics, humanID, trunkBoneID,
+			    branchBoneID, destination, destinationAxis, vecA, a, rot, strength, d,
+			    vecB, vecC, vecD, flags);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&humanLimbInverseKinematicsHook);
-		Engine::humanLimbInverseKinematics(
-		    humanID, trunkBoneID, branchBoneID, destination, destinationAxis, vecA,
-		    a, rot, strength, d, vecB, vecC, vecD, flags);
+		humanLimbInverseKinematicsHook.callOriginal(
+		    Engine::humanLimbInverseKinematics, humanID, trunkBoneID, branchBoneID,
+		    destination, destinationAxis, vecA, a, rot, strength, d, vecB, vecC,
+		    vecD, flags);
 	}
 }
 
 void grenadeExplosion(int itemID) {
 	if (enabledKeys[EnableKeys::GrenadeExplode]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("GrenadeExplode", &Engine::items[itemID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::GrenadeExplode, "GrenadeExplode",
+		                       &Engine::items[itemID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&grenadeExplosionHook);
-				Engine::grenadeExplosion(itemID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostGrenadeExplode", &Engine::items[itemID]);
-				noLuaCallError(&res);
-			}
+			grenadeExplosionHook.callOriginal(Engine::grenadeExplosion, itemID);
+			runPost(EnableKeys::GrenadeExplode, "PostGrenadeExplode",
+			        &Engine::items[itemID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&grenadeExplosionHook);
-		Engine::grenadeExplosion(itemID);
+		grenadeExplosionHook.callOriginal(Engine::grenadeExplosion, itemID);
 	}
 }
 
 void vehicleApplyDamage(int vehicleID, int damage) {
 	if (enabledKeys[EnableKeys::VehicleDamage]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("VehicleDamage", &Engine::vehicles[vehicleID], damage);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::VehicleDamage, "VehicleDamage",
+		                       &Engine::vehicles[vehicleID], damage);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&vehicleApplyDamageHook);
-				Engine::vehicleApplyDamage(vehicleID, damage);
-			}
-			if (run != sol::nil) {
-				auto res =
-				    run("PostVehicleDamage", &Engine::vehicles[vehicleID], damage);
-				noLuaCallError(&res);
-			}
+			vehicleApplyDamageHook.callOriginal(
+			    Engine::vehicleApplyDamage, vehicleID, damage);
+			runPost(EnableKeys::VehicleDamage, "PostVehicleDamage",
+			        &Engine::vehicles[vehicleID], damage);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&vehicleApplyDamageHook);
-		Engine::vehicleApplyDamage(vehicleID, damage);
+		vehicleApplyDamageHook.callOriginal(
+		    Engine::vehicleApplyDamage, vehicleID, damage);
 	}
 }
 
 int serverPlayerMessage(int playerID, char* message) {
 	if (enabledKeys[EnableKeys::PlayerChat]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PlayerChat", &Engine::players[playerID], message);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::PlayerChat, "PlayerChat",
+		                       &Engine::players[playerID], message);
 		if (!noParent) {
-			subhook::ScopedHookRemove remove(&serverPlayerMessageHook);
-			return Engine::serverPlayerMessage(playerID, message);
+			return serverPlayerMessageHook.callOriginal(
+			    Engine::serverPlayerMessage, playerID, message);
 		}
 		return 1;
 	} else {
-		subhook::ScopedHookRemove remove(&serverPlayerMessageHook);
-		return Engine::serverPlayerMessage(playerID, message);
+		return serverPlayerMessageHook.callOriginal(
+		    Engine::serverPlayerMessage, playerID, message);
 	}
 }
 
 void playerAI(int playerID) {
 	if (enabledKeys[EnableKeys::PlayerAI]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PlayerAI", &Engine::players[playerID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::PlayerAI, "PlayerAI",
+		                       &Engine::players[playerID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&playerAIHook);
-				Engine::playerAI(playerID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPlayerAI", &Engine::players[playerID]);
-				noLuaCallError(&res);
-			}
+			playerAIHook.callOriginal(Engine::playerAI, playerID);
+			runPost(EnableKeys::PlayerAI, "PostPlayerAI", &Engine::players[playerID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&playerAIHook);
-		Engine::playerAI(playerID);
+		playerAIHook.callOriginal(Engine::playerAI, playerID);
 	}
 }
 
 void playerDeathTax(int playerID) {
 	if (enabledKeys[EnableKeys::PlayerDeathTax]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("PlayerDeathTax", &Engine::players[playerID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::PlayerDeathTax, "PlayerDeathTax",
+		                       &Engine::players[playerID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&playerDeathTaxHook);
-				Engine::playerDeathTax(playerID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPlayerDeathTax", &Engine::players[playerID]);
-				noLuaCallError(&res);
-			}
+			playerDeathTaxHook.callOriginal(Engine::playerDeathTax, playerID);
+			runPost(EnableKeys::PlayerDeathTax, "PostPlayerDeathTax",
+			        &Engine::players[playerID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&playerDeathTaxHook);
-		Engine::playerDeathTax(playerID);
+		playerDeathTaxHook.callOriginal(Engine::playerDeathTax, playerID);
 	}
 }
 
 void accountDeathTax(int accountID) {
 	if (enabledKeys[EnableKeys::AccountDeathTax]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("AccountDeathTax", &Engine::accounts[accountID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::AccountDeathTax, "AccountDeathTax",
+		                       &Engine::accounts[accountID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&accountDeathTaxHook);
-				Engine::accountDeathTax(accountID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostAccountDeathTax", &Engine::accounts[accountID]);
-				noLuaCallError(&res);
-			}
+			accountDeathTaxHook.callOriginal(Engine::accountDeathTax, accountID);
+			runPost(EnableKeys::AccountDeathTax, "PostAccountDeathTax",
+			        &Engine::accounts[accountID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&accountDeathTaxHook);
-		Engine::accountDeathTax(accountID);
+		accountDeathTaxHook.callOriginal(Engine::accountDeathTax, accountID);
 	}
 }
 
 void playerGiveWantedLevel(int playerID, int victimPlayerID, int basePoints) {
 	if (enabledKeys[EnableKeys::PlayerGiveWantedLevel]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			Integer wrappedBasePoints = {basePoints};
+		Integer wrappedBasePoints = {basePoints};
 
-			auto res = run("PlayerGiveWantedLevel", &Engine::players[playerID],
-			               &Engine::players[victimPlayerID], &wrappedBasePoints);
-			if (noLuaCallError(&res)) noParent = (bool)res;
+		bool noParent = runPre(EnableKeys::PlayerGiveWantedLevel,
+		                       "PlayerGiveWantedLevel", &Engine::players[playerID],
+		                       &Engine::players[victimPlayerID],
+		                       &wrappedBasePoints);
 
-			basePoints = wrappedBasePoints.value;
-		}
+		basePoints = wrappedBasePoints.value;
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&playerGiveWantedLevelHook);
-				Engine::playerGiveWantedLevel(playerID, victimPlayerID, basePoints);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostPlayerGiveWantedLevel", &Engine::players[playerID],
-				               &Engine::players[victimPlayerID], basePoints);
-				noLuaCallError(&res);
-			}
+			playerGiveWantedLevelHook.callOriginal(
+			    Engine::playerGiveWantedLevel, playerID, victimPlayerID, basePoints);
+			runPost(EnableKeys::PlayerGiveWantedLevel, "PostPlayerGiveWantedLevel",
+			        &Engine::players[playerID], &Engine::players[victimPlayerID],
+			        basePoints);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&playerGiveWantedLevelHook);
-		Engine::playerGiveWantedLevel(playerID, victimPlayerID, basePoints);
+		playerGiveWantedLevelHook.callOriginal(
+		    Engine::playerGiveWantedLevel, playerID, victimPlayerID, basePoints);
 	}
 }
 
@@ -1609,22 +1494,18 @@ void addCollisionRigidBodyOnRigidBody(int aBodyID, int bBodyID,
                                       Vector* normal, float a, float b, float c,
                                       float d) {
 	if (enabledKeys[EnableKeys::CollideBodies]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("CollideBodies", &Engine::bodies[aBodyID],
-			               &Engine::bodies[bBodyID], aLocalPos, bLocalPos, normal, a,
-			               b, c, d);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::CollideBodies, "CollideBodies",
+		                       &Engine::bodies[aBodyID], &Engine::bodies[bBodyID],
+		                       aLocalPos, bLocalPos, normal, a, b, c, d);
 		if (!noParent) {
-			subhook::ScopedHookRemove remove(&addCollisionRigidBodyOnRigidBodyHook);
-			Engine::addCollisionRigidBodyOnRigidBody(aBodyID, bBodyID, aLocalPos,
-			                                         bLocalPos, normal, a, b, c, d);
+			addCollisionRigidBodyOnRigidBodyHook.callOriginal(
+			    Engine::addCollisionRigidBodyOnRigidBody, aBodyID, bBodyID, aLocalPos,
+			    bLocalPos, normal, a, b, c, d);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&addCollisionRigidBodyOnRigidBodyHook);
-		Engine::addCollisionRigidBodyOnRigidBody(aBodyID, bBodyID, aLocalPos,
-		                                         bLocalPos, normal, a, b, c, d);
+		addCollisionRigidBodyOnRigidBodyHook.callOriginal(
+		    Engine::addCollisionRigidBodyOnRigidBody, aBodyID, bBodyID, aLocalPos,
+		    bLocalPos, normal, a, b, c, d);
 	}
 }
 
@@ -1641,25 +1522,18 @@ void addCollisionRigidBodyOnRigidBody(int aBodyID, int bBodyID,
 void createEventMessage(int speakerType, char* message, int speakerID,
                         int distance) {
 	if (enabledKeys[EnableKeys::EventMessage]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("EventMessage", speakerType, message, speakerID, distance);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::EventMessage, "EventMessage",
+		                       speakerType, message, speakerID, distance);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventMessageHook);
-				Engine::createEventMessage(speakerType, message, speakerID, distance);
-			}
-			if (run != sol::nil) {
-				auto res =
-				    run("PostEventMessage", speakerType, message, speakerID, distance);
-				noLuaCallError(&res);
-			}
+			createEventMessageHook.callOriginal(
+			    Engine::createEventMessage, speakerType, message, speakerID,
+			    distance);
+			runPost(EnableKeys::EventMessage, "PostEventMessage", speakerType,
+			        message, speakerID, distance);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventMessageHook);
-		Engine::createEventMessage(speakerType, message, speakerID, distance);
+		createEventMessageHook.callOriginal(
+		    Engine::createEventMessage, speakerType, message, speakerID, distance);
 	}
 }
 
@@ -1670,24 +1544,17 @@ void createEventUpdateItemInfo(int id) {
 	asm("mov %%r8, %0" : "=r"(r8) :);
 
 	if (enabledKeys[EnableKeys::EventUpdateItemInfo]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("EventUpdateItemInfo", &Engine::items[id]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::EventUpdateItemInfo,
+		                       "EventUpdateItemInfo", &Engine::items[id]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventUpdateItemInfoHook);
-				Engine::createEventUpdateItemInfo(id);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEventUpdateItemInfo", &Engine::items[id]);
-				noLuaCallError(&res);
-			}
+			createEventUpdateItemInfoHook.callOriginal(
+			    Engine::createEventUpdateItemInfo, id);
+			runPost(EnableKeys::EventUpdateItemInfo, "PostEventUpdateItemInfo",
+			        &Engine::items[id]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventUpdateItemInfoHook);
-		Engine::createEventUpdateItemInfo(id);
+		createEventUpdateItemInfoHook.callOriginal(
+		    Engine::createEventUpdateItemInfo, id);
 	}
 
 	asm("mov %0, %%r8" : : "r"(r8));
@@ -1695,52 +1562,37 @@ void createEventUpdateItemInfo(int id) {
 
 void createEventUpdatePlayer(int id) {
 	if (enabledKeys[EnableKeys::EventUpdatePlayer]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("EventUpdatePlayer", &Engine::players[id]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::EventUpdatePlayer, "EventUpdatePlayer",
+		                       &Engine::players[id]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventUpdatePlayerHook);
-				Engine::createEventUpdatePlayer(id);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEventUpdatePlayer", &Engine::players[id]);
-				noLuaCallError(&res);
-			}
+			createEventUpdatePlayerHook.callOriginal(
+			    Engine::createEventUpdatePlayer, id);
+			runPost(EnableKeys::EventUpdatePlayer, "PostEventUpdatePlayer",
+			        &Engine::players[id]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventUpdatePlayerHook);
-		Engine::createEventUpdatePlayer(id);
+		createEventUpdatePlayerHook.callOriginal(
+		    Engine::createEventUpdatePlayer, id);
 	}
 }
 
 void createEventUpdateVehicle(int vehicleID, int updateType, int partID,
                               Vector* pos, Vector* normal) {
 	if (enabledKeys[EnableKeys::EventUpdateVehicle]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("EventUpdateVehicle", &Engine::vehicles[vehicleID],
-			               updateType, partID, pos, normal);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::EventUpdateVehicle, "EventUpdateVehicle",
+		                       &Engine::vehicles[vehicleID], updateType, partID,
+		                       pos, normal);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventUpdateVehicleHook);
-				Engine::createEventUpdateVehicle(vehicleID, updateType, partID, pos,
-				                                 normal);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEventUpdateVehicle", &Engine::vehicles[vehicleID],
-				               updateType, partID, pos, normal);
-				noLuaCallError(&res);
-			}
+			createEventUpdateVehicleHook.callOriginal(
+			    Engine::createEventUpdateVehicle, vehicleID, updateType, partID, pos,
+			    normal);
+			runPost(EnableKeys::EventUpdateVehicle, "PostEventUpdateVehicle",
+			        &Engine::vehicles[vehicleID], updateType, partID, pos, normal);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventUpdateVehicleHook);
-		Engine::createEventUpdateVehicle(vehicleID, updateType, partID, pos,
-		                                 normal);
+		createEventUpdateVehicleHook.callOriginal(
+		    Engine::createEventUpdateVehicle, vehicleID, updateType, partID, pos,
+		    normal);
 	}
 }
 
@@ -1756,34 +1608,27 @@ void createEventSoundItem(unsigned int soundType, int itemID, float volume,
 	asm("mov %%r11, %0" : "=r"(r11) :);
 
 	if (enabledKeys[EnableKeys::EventSoundItem]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			Float wrappedVolume = {volume};
-			Float wrappedPitch = {pitch};
-			UnsignedInteger wrappedType = {soundType};
-
-			auto res = run("EventSoundItem", wrappedType,
-			               itemID == -1 ? nullptr : &Engine::items[itemID],
-			               wrappedVolume, wrappedPitch);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-
-			soundType = wrappedType.value;
-			volume = wrappedVolume.value;
-			pitch = wrappedPitch.value;
-		}
+		Float wrappedVolume = {volume};
+		Float wrappedPitch = {pitch};
+		UnsignedInteger wrappedType = {soundType};
+
+		bool noParent = runPre(EnableKeys::EventSoundItem, "EventSoundItem",
+		                       wrappedType,
+		                       itemID == -1 ? nullptr : &Engine::items[itemID],
+		                       wrappedVolume, wrappedPitch);
+
+		soundType = wrappedType.value;
+		volume = wrappedVolume.value;
+		pitch = wrappedPitch.value;
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventSoundItemHook);
-				Engine::createEventSoundItem(soundType, itemID, volume, pitch);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEventSoundItem", soundType, itemID, volume, pitch);
-				noLuaCallError(&res);
-			}
+			createEventSoundItemHook.callOriginal(
+			    Engine::createEventSoundItem, soundType, itemID, volume, pitch);
+			runPost(EnableKeys::EventSoundItem, "PostEventSoundItem", soundType,
+			        itemID, volume, pitch);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventSoundItemHook);
-		Engine::createEventSoundItem(soundType, itemID, volume, pitch);
+		createEventSoundItemHook.callOriginal(
+		    Engine::createEventSoundItem, soundType, itemID, volume, pitch);
 	}
 
 	asm("mov %0, %%r8" : : "r"(r8));
@@ -1797,30 +1642,23 @@ void createEventSound(int soundType, Vector* pos, float volume, float pitch) {
 	asm("mov %%r10, %0" : "=r"(r10) :);
 
 	if (enabledKeys[EnableKeys::EventSound]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			Float wrappedVolume = {volume};
-			Float wrappedPitch = {pitch};
+		Float wrappedVolume = {volume};
+		Float wrappedPitch = {pitch};
 
-			auto res = run("EventSound", soundType, pos, wrappedVolume, wrappedPitch);
-			if (noLuaCallError(&res)) noParent = (bool)res;
+		bool noParent = runPre(EnableKeys::EventSound, "EventSound", soundType, pos,
+		                       wrappedVolume, wrappedPitch);
 
-			volume = wrappedVolume.value;
-			pitch = wrappedPitch.value;
-		}
+		volume = wrappedVolume.value;
+		pitch = wrappedPitch.value;
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventSoundHook);
-				Engine::createEventSound(soundType, pos, volume, pitch);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEventSound", soundType, pos, volume, pitch);
-				noLuaCallError(&res);
-			}
+			createEventSoundHook.callOriginal(
+			    Engine::createEventSound, soundType, pos, volume, pitch);
+			runPost(EnableKeys::EventSound, "PostEventSound", soundType, pos, volume,
+			        pitch);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventSoundHook);
-		Engine::createEventSound(soundType, pos, volume, pitch);
+		createEventSoundHook.callOriginal(
+		    Engine::createEventSound, soundType, pos, volume, pitch);
 	}
 
 	asm("mov %0, %%r10" : : "r"(r10));
@@ -1828,122 +1666,98 @@ void createEventSound(int soundType, Vector* pos, float volume, float pitch) {
 
 void createEventBullet(int bulletType, Vector* pos, Vector* vel, int itemID) {
 	if (enabledKeys[EnableKeys::EventBullet]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res =
-			    run("EventBullet", bulletType, pos, vel, &Engine::items[itemID]);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::EventBullet, "EventBullet", bulletType,
+		                       pos, vel, &Engine::items[itemID]);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventBulletHook);
-				Engine::createEventBullet(bulletType, pos, vel, itemID);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEventBullet", bulletType, pos, vel,
-				               &Engine::items[itemID]);
-				noLuaCallError(&res);
-			}
+			createEventBulletHook.callOriginal(
+			    Engine::createEventBullet, bulletType, pos, vel, itemID);
+			runPost(EnableKeys::EventBullet, "PostEventBullet", bulletType, pos, vel,
+			        &Engine::items[itemID]);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventBulletHook);
-		Engine::createEventBullet(bulletType, pos, vel, itemID);
+		createEventBulletHook.callOriginal(
+		    Engine::createEventBullet, bulletType, pos, vel, itemID);
 	}
 }
 
 void createEventBulletHit(int unk, int hitType, Vector* pos, Vector* normal) {
 	if (enabledKeys[EnableKeys::EventBulletHit]) {
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("EventBulletHit", hitType, pos, normal);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-		}
+		bool noParent = runPre(EnableKeys::EventBulletHit, "EventBulletHit",
+		                       hitType, pos, normal);
 		if (!noParent) {
-			{
-				subhook::ScopedHookRemove remove(&createEventBulletHitHook);
-				Engine::createEventBulletHit(unk, hitType, pos, normal);
-			}
-			if (run != sol::nil) {
-				auto res = run("PostEventBulletHit", hitType, pos, normal);
-				noLuaCallError(&res);
-			}
+			createEventBulletHitHook.callOriginal(
+			    Engine::createEventBulletHit, unk, hitType, pos, normal);
+			runPost(EnableKeys::EventBulletHit, "PostEventBulletHit", hitType, pos,
+			        normal);
 		}
 	} else {
-		subhook::ScopedHookRemove remove(&createEventBulletHitHook);
-		Engine::createEventBulletHit(unk, hitType, pos, normal);
+		createEventBulletHitHook.callOriginal(
+		    Engine::createEventBulletHit, unk, hitType, pos, normal);
 	}
 }
 
+sol::table lineIntersectHumanResult;
+
 int lineIntersectHuman(int humanID, Vector* posA, Vector* posB, float padding) {
-	Bullet* bullet;
+	Bullet* bullet = nullptr;
 
 	if (isInBulletSimulation) {
-		if (run != sol::nil) {
-			// posA is Bullet.pos in this case
-			bullet =
-			    reinterpret_cast<Bullet*>(reinterpret_cast<uintptr_t>(posA) - 0x20);
-			auto res = run("BulletMayHitHuman", bullet);
-			noLuaCallError(&res);
-		}
+		// posA is Bullet.pos in this case
+		bullet =
+		    reinterpret_cast<Bullet*>(reinterpret_cast<uintptr_t>(posA) - 0x20);
+		if (enabledKeys[EnableKeys::BulletMayHitHuman])
+			runPre(EnableKeys::BulletMayHitHuman, "BulletMayHitHuman", bullet);
 	}
 
 	if (enabledKeys[EnableKeys::LineIntersectHuman]) {
-		int didHit;
-		{
-			subhook::ScopedHookRemove remove(&lineIntersectHumanHook);
-			didHit = Engine::lineIntersectHuman(humanID, posA, posB, padding);
-		}
+		int didHit = lineIntersectHumanHook.callOriginal(
+		    Engine::lineIntersectHuman, humanID, posA, posB, padding);
 
 		if (!didHit) {
 			return didHit;
 		}
 
+		// The same table and vectors are handed to every call
 		auto lineResult = Engine::lineIntersectResult;
-		auto result = lua->create_table();
-		result["pos"] = lineResult->pos;
-		result["normal"] = lineResult->normal;
+		auto& result = lineIntersectHumanResult;
+		if (!result.valid()) result = lua->create_table();
+		setTableVector(result, "pos", lineResult->pos);
+		setTableVector(result, "normal", lineResult->normal);
 		result["fraction"] = lineResult->fraction;
 		result["bone"] = lineResult->humanBone;
 		result["hit"] = true;
 
-		bool noParent = false;
-		if (run != sol::nil) {
-			auto res = run("LineIntersectHuman", &Engine::humans[humanID], posA, posB,
-			               padding, result);
-			if (noLuaCallError(&res)) noParent = (bool)res;
-
-			if (bullet && !noParent) {
-				if (Engine::humans[humanID].playerID != bullet->playerID ||
-				    ((lineResult->humanBone - 8 > 1 && lineResult->humanBone - 5 > 1) &&
-				     (Engine::humans[humanID].playerID == -1 ||
-				      Engine::players[Engine::humans[humanID].playerID].isGodMode ==
-				          0)))
-					res = run("BulletHitHuman", &Engine::humans[humanID], bullet);
-
-				if (noLuaCallError(&res)) noParent = (bool)res;
-			}
+		bool noParent = runPre(EnableKeys::LineIntersectHuman, "LineIntersectHuman",
+		                       &Engine::humans[humanID], posA, posB, padding,
+		                       result);
+
+		if (bullet && !noParent && enabledKeys[EnableKeys::BulletHitHuman]) {
+			if (Engine::humans[humanID].playerID != bullet->playerID ||
+			    ((lineResult->humanBone - 8 > 1 && lineResult->humanBone - 5 > 1) &&
+			     (Engine::humans[humanID].playerID == -1 ||
+			      Engine::players[Engine::humans[humanID].playerID].isGodMode ==
+			          0)))
+				noParent = runPre(EnableKeys::BulletHitHuman, "BulletHitHuman",
+				                  &Engine::humans[humanID], bullet);
 		}
 
 		return !noParent;
 	} else {
-		subhook::ScopedHookRemove remove(&lineIntersectHumanHook);
-		return Engine::lineIntersectHuman(humanID, posA, posB, padding);
+		return lineIntersectHumanHook.callOriginal(
+		    Engine::lineIntersectHuman, humanID, posA, posB, padding);
 	}
 }
 
 int lineIntersectLevel(Vector* posA, Vector* posB, int unk) {
-	if (isInBulletSimulation) {
-		if (run != sol::nil) {
-			// posA is Bullet.pos in this case
-			Bullet* bullet =
-			    reinterpret_cast<Bullet*>(reinterpret_cast<uintptr_t>(posA) - 0x20);
-			auto res = run("BulletMayHit", bullet);
-			noLuaCallError(&res);
-		}
+	if (isInBulletSimulation && enabledKeys[EnableKeys::BulletMayHit]) {
+		// posA is Bullet.pos in this case
+		Bullet* bullet =
+		    reinterpret_cast<Bullet*>(reinterpret_cast<uintptr_t>(posA) - 0x20);
+		runPre(EnableKeys::BulletMayHit, "BulletMayHit", bullet);
 	}
 
-	subhook::ScopedHookRemove remove(&lineIntersectLevelHook);
-	return Engine::lineIntersectLevel(posA, posB, unk);
+	return lineIntersectLevelHook.callOriginal(
+	    Engine::lineIntersectLevel, posA, posB, unk);
 }
 
 bool isInBulletSimulation = false;
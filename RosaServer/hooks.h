@@ -1,12 +1,55 @@
 #pragma once
 #include <set>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "hookobserver.h"
+#include "latencyhistogram.h"
 #include "structs.h"
 #include "subhook.h"
+#include "tickprofiler.h"
+#include "tracerecorder.h"
+
+bool noLuaCallError(sol::protected_function_result* res);
 
 namespace Hooks {
 extern sol::protected_function run;
+extern bool collectStats;
+
+// A detour whose original function is called through subhook's trampoline.
+// When the prologue of the original couldn't be relocated there is no
+// trampoline, and the detour is removed for the duration of the call instead.
+class TrampolineHook : public subhook::Hook {
+ public:
+	const char* name = nullptr;
+	unsigned long long trampolineCalls = 0;
+	unsigned long long removeCalls = 0;
+	LatencyHistogram originalLatency;
+
+	bool install(const char* hookName, void* source, void* destination);
+	bool hasTrampoline() const { return GetTrampoline() != nullptr; }
+
+	template <typename Function, typename... Args>
+	inline auto callOriginal(Function original, Args... args) {
+		LatencyTimer timer(collectStats ? &originalLatency : nullptr);
+		auto trampoline = reinterpret_cast<Function>(GetTrampoline());
+		if (trampoline != nullptr) {
+			trampolineCalls++;
+			return trampoline(args...);
+		}
+
+		removeCalls++;
+		subhook::ScopedHookRemove remove(this);
+		return original(args...);
+	}
+};
+
+extern std::vector<TrampolineHook*> trampolineHooks;
+// Installs or removes hooks which are only needed while their keys are enabled
+void updateInstalledHooks();
+
+extern TickProfiler tickProfiler;
 
 enum EnableKeys {
 	ResetGame,
@@ -34,6 +77,7 @@ enum EnableKeys {
 	ServerReceive,
 	ServerSend,
 	PacketBuilding,
+	PacketBuildingBatch,
 	CalculateEarShots,
 	SendPacket,
 	PhysicsBullets,
@@ -74,166 +118,261 @@ enum EnableKeys {
 	EventBullet,
 	EventBulletHit,
 	LineIntersectHuman,
+	BulletMayHit,
+	BulletMayHitHuman,
+	BulletHitHuman,
+	TickOverBudget,
 	SIZE
 };
 
 extern const std::unordered_map<std::string, EnableKeys> enableNames;
 extern bool enabledKeys[EnableKeys::SIZE];
+// Keys turned on by hook.enable. A key is enabled while either this is set or
+// it has a handler registered; see updateEnabledKey.
+extern bool scriptEnabledKeys[EnableKeys::SIZE];
+
+// Natively registered handlers, called directly instead of by name through
+// Hooks::run. The pre and post slots are separate: whichever one is empty
+// goes through run, but only if the key was also turned on by hook.enable.
+// Observers can't cancel anything; their arguments are buffered and they're
+// called after the tick by flushObservedEvents.
+struct Callbacks {
+	sol::protected_function pre;
+	sol::protected_function post;
+	sol::protected_function preObserver;
+	sol::protected_function postObserver;
+
+	bool isRegistered() const {
+		return pre.valid() || post.valid() || preObserver.valid() ||
+		       postObserver.valid();
+	}
+};
+
+extern Callbacks callbacks[EnableKeys::SIZE];
+extern ObservedEventBuffer observedEvents;
+extern TraceRecorder* traceRecorder;
+
+template <typename... Args>
+inline void recordTrace(EnableKeys key, const char* name, bool isPost,
+                        const Args&... args) {
+	ObservedEvent event;
+	event.set(key, isPost, args...);
+	traceRecorder->record(name, event);
+}
+
+struct HookStats {
+	LatencyHistogram pre;
+	LatencyHistogram post;
+};
+
+extern HookStats hookStats[EnableKeys::SIZE];
+
+inline LatencyHistogram* preLatency(EnableKeys key) {
+	return collectStats ? &hookStats[key].pre : nullptr;
+}
+
+inline LatencyHistogram* postLatency(EnableKeys key) {
+	return collectStats ? &hookStats[key].post : nullptr;
+}
+
+template <typename... Args>
+inline bool runCallback(const sol::protected_function& function,
+                        Args&&... args) {
+	auto res = function(std::forward<Args>(args)...);
+	return noLuaCallError(&res) && (bool)res;
+}
+
+template <typename... Args>
+inline bool runPre(EnableKeys key, const char* name, Args&&... args) {
+	const auto& callback = callbacks[key];
+	if (traceRecorder) recordTrace(key, name, false, args...);
+	if (callback.preObserver.valid()) observedEvents.push(key, false, args...);
+	if (callback.pre.valid()) {
+		LatencyTimer timer(preLatency(key));
+		return runCallback(callback.pre, std::forward<Args>(args)...);
+	}
+	if (!scriptEnabledKeys[key] || run == sol::nil) return false;
+
+	LatencyTimer timer(preLatency(key));
+	return runCallback(run, name, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+inline void runPost(EnableKeys key, const char* name, Args&&... args) {
+	const auto& callback = callbacks[key];
+	if (traceRecorder) recordTrace(key, name, true, args...);
+	if (callback.postObserver.valid()) observedEvents.push(key, true, args...);
+	if (callback.post.valid()) {
+		LatencyTimer timer(postLatency(key));
+		runCallback(callback.post, std::forward<Args>(args)...);
+	} else if (scriptEnabledKeys[key] && run != sol::nil) {
+		LatencyTimer timer(postLatency(key));
+		runCallback(run, name, std::forward<Args>(args)...);
+	}
+}
+
+void clearCallbacks();
+void updateEnabledKey(size_t key);
+void flushObservedEvents();
+const char* getKeyName(EnableKeys key);
+void resetStats();
+void logStats();
 
-extern subhook::Hook subRosaPutsHook;
+extern TrampolineHook subRosaPutsHook;
 int subRosaPuts(const char* str);
-extern subhook::Hook subRosa__printf_chkHook;
+extern TrampolineHook subRosa__printf_chkHook;
 int subRosa__printf_chk(int flag, const char* format, ...);
 
-extern subhook::Hook resetGameHook;
+extern TrampolineHook resetGameHook;
 void resetGame();
 
-extern subhook::Hook createTrafficHook;
+extern TrampolineHook createTrafficHook;
 void createTraffic(int amount);
 
-extern subhook::Hook trafficSimulationHook;
+extern TrampolineHook trafficSimulationHook;
 void trafficSimulation();
 
-extern subhook::Hook aiTrafficCarHook;
+extern TrampolineHook aiTrafficCarHook;
 void aiTrafficCar(int id);
 
-extern subhook::Hook aiTrafficCarDestinationHook;
+extern TrampolineHook aiTrafficCarDestinationHook;
 void aiTrafficCarDestination(int id, int a, int b, int c, int d);
 
-extern subhook::Hook areaCreateBlockHook;
+extern TrampolineHook areaCreateBlockHook;
 void areaCreateBlock(int zero, int blockX, int blockY, int blockZ,
                      unsigned int flags, short[8]);
 void areaGetBlock(int zero, int blockX, int blockY, int blockZ);
-extern subhook::Hook areaDeleteBlockHook;
+extern TrampolineHook areaDeleteBlockHook;
 void areaDeleteBlock(int zero, int blockX, int blockY, int blockZ);
 
-extern subhook::Hook logicSimulationHook;
+extern TrampolineHook logicSimulationHook;
 void logicSimulation();
-extern subhook::Hook logicSimulationRaceHook;
+extern TrampolineHook logicSimulationRaceHook;
 void logicSimulationRace();
-extern subhook::Hook logicSimulationRoundHook;
+extern TrampolineHook logicSimulationRoundHook;
 void logicSimulationRound();
-extern subhook::Hook logicSimulationWorldHook;
+extern TrampolineHook logicSimulationWorldHook;
 void logicSimulationWorld();
-extern subhook::Hook logicSimulationTerminatorHook;
+extern TrampolineHook logicSimulationTerminatorHook;
 void logicSimulationTerminator();
-extern subhook::Hook logicSimulationCoopHook;
+extern TrampolineHook logicSimulationCoopHook;
 void logicSimulationCoop();
-extern subhook::Hook logicSimulationVersusHook;
+extern TrampolineHook logicSimulationVersusHook;
 void logicSimulationVersus();
-extern subhook::Hook logicPlayerActionsHook;
+extern TrampolineHook logicPlayerActionsHook;
 void logicPlayerActions(int playerID);
 
-extern subhook::Hook physicsSimulationHook;
+extern TrampolineHook physicsSimulationHook;
 void physicsSimulation();
-extern subhook::Hook rigidBodySimulationHook;
+extern TrampolineHook rigidBodySimulationHook;
 void rigidBodySimulation();
-extern subhook::Hook vehicleSimulateSuspensionsHook;
+extern TrampolineHook vehicleSimulateSuspensionsHook;
 void vehicleSimulateSuspensions();
-extern subhook::Hook itemWeaponSimulationHook;
+extern TrampolineHook itemWeaponSimulationHook;
 void itemWeaponSimulation(int itemID);
-extern subhook::Hook serverReceiveHook;
+extern TrampolineHook serverReceiveHook;
 int serverReceive();
-extern subhook::Hook serverSendHook;
+extern TrampolineHook serverSendHook;
 void serverSend();
-extern subhook::Hook packetWriteHook;
+extern TrampolineHook packetWriteHook;
 int packetWrite(void* source, int elementSize, int elementCount);
-extern subhook::Hook calculatePlayerVoiceHook;
+extern TrampolineHook calculatePlayerVoiceHook;
 void calculatePlayerVoice(int connectionID, int playerID);
-extern subhook::Hook sendPacketHook;
+extern TrampolineHook sendPacketHook;
 int sendPacket(unsigned int address, unsigned short port);
-extern subhook::Hook bulletSimulationHook;
+extern TrampolineHook bulletSimulationHook;
 void bulletSimulation();
 
-extern subhook::Hook economyCarMarketHook;
+extern TrampolineHook economyCarMarketHook;
 void economyCarMarket();
-extern subhook::Hook saveAccountsServerHook;
+extern TrampolineHook saveAccountsServerHook;
 void saveAccountsServer();
 
-extern subhook::Hook createAccountByJoinTicketHook;
+extern TrampolineHook createAccountByJoinTicketHook;
 int createAccountByJoinTicket(int identifier, unsigned int ticket);
-extern subhook::Hook serverSendConnectResponseHook;
+extern TrampolineHook serverSendConnectResponseHook;
 void serverSendConnectResponse(unsigned int address, unsigned int port, int unk,
                                const char* message);
 
-extern subhook::Hook createBulletHook;
+extern TrampolineHook createBulletHook;
 int createBullet(int type, Vector* pos, Vector* vel, int playerID);
-extern subhook::Hook createPlayerHook;
+extern TrampolineHook createPlayerHook;
 int createPlayer();
-extern subhook::Hook deletePlayerHook;
+extern TrampolineHook deletePlayerHook;
 void deletePlayer(int playerID);
-extern subhook::Hook createHumanHook;
+extern TrampolineHook createHumanHook;
 int createHuman(Vector* pos, RotMatrix* rot, int playerID);
-extern subhook::Hook deleteHumanHook;
+extern TrampolineHook deleteHumanHook;
 void deleteHuman(int humanID);
-extern subhook::Hook createItemHook;
+extern TrampolineHook createItemHook;
 int createItem(int type, Vector* pos, Vector* vel, RotMatrix* rot);
-extern subhook::Hook deleteItemHook;
+extern TrampolineHook deleteItemHook;
 void deleteItem(int itemID);
-extern subhook::Hook createVehicleHook;
+extern TrampolineHook createVehicleHook;
 int createVehicle(int type, Vector* pos, Vector* vel, RotMatrix* rot,
                   int color);
-extern subhook::Hook deleteVehicleHook;
+extern TrampolineHook deleteVehicleHook;
 void deleteVehicle(int vehicleID);
-extern subhook::Hook createRigidBodyHook;
+extern TrampolineHook createRigidBodyHook;
 int createRigidBody(int type, Vector* pos, RotMatrix* rot, Vector* vel,
                     Vector* scale, float mass);
 
-extern subhook::Hook linkItemHook;
+extern TrampolineHook linkItemHook;
 int linkItem(int itemID, int childItemID, int parentHumanID, int slot);
-extern subhook::Hook itemComputerInputHook;
+extern TrampolineHook itemComputerInputHook;
 void itemComputerInput(int itemID, unsigned int character);
-extern subhook::Hook humanApplyDamageHook;
+extern TrampolineHook humanApplyDamageHook;
 void humanApplyDamage(int humanID, int bone, int unk, int damage);
-extern subhook::Hook humanCollisionVehicleHook;
+extern TrampolineHook humanCollisionVehicleHook;
 void humanCollisionVehicle(int humanID, int vehicleID);
-extern subhook::Hook humanLimbInverseKinematicsHook;
+extern TrampolineHook humanLimbInverseKinematicsHook;
 void humanLimbInverseKinematics(int, int, int, Vector*, RotMatrix*, Vector*,
                                 float, float, float, float* /* Quaternion? */,
                                 Vector*, Vector*, Vector*, char);
-extern subhook::Hook grenadeExplosionHook;
+extern TrampolineHook grenadeExplosionHook;
 void grenadeExplosion(int itemID);
-extern subhook::Hook vehicleApplyDamageHook;
+extern TrampolineHook vehicleApplyDamageHook;
 void vehicleApplyDamage(int vehicleID, int damage);
-extern subhook::Hook serverPlayerMessageHook;
+extern TrampolineHook serverPlayerMessageHook;
 int serverPlayerMessage(int playerID, char* message);
-extern subhook::Hook playerAIHook;
+extern TrampolineHook playerAIHook;
 void playerAI(int playerID);
-extern subhook::Hook playerDeathTaxHook;
+extern TrampolineHook playerDeathTaxHook;
 void playerDeathTax(int playerID);
-extern subhook::Hook accountDeathTaxHook;
+extern TrampolineHook accountDeathTaxHook;
 void accountDeathTax(int accountID);
-extern subhook::Hook playerGiveWantedLevelHook;
+extern TrampolineHook playerGiveWantedLevelHook;
 void playerGiveWantedLevel(int playerID, int victimPlayerID, int basePoints);
 
-extern subhook::Hook addCollisionRigidBodyOnRigidBodyHook;
+extern TrampolineHook addCollisionRigidBodyOnRigidBodyHook;
 void addCollisionRigidBodyOnRigidBody(int aBodyID, int bBodyID,
                                       Vector* aLocalPos, Vector* bLocalPos,
                                       Vector* normal, float, float, float,
                                       float);
 
-extern subhook::Hook createEventMessageHook;
+extern TrampolineHook createEventMessageHook;
 void createEventMessage(int speakerType, char* message, int speakerID,
                         int distance);
-extern subhook::Hook createEventUpdateItemInfoHook;
+extern TrampolineHook createEventUpdateItemInfoHook;
 void createEventUpdateItemInfo(int id);
-extern subhook::Hook createEventUpdatePlayerHook;
+extern TrampolineHook createEventUpdatePlayerHook;
 void createEventUpdatePlayer(int id);
-extern subhook::Hook createEventUpdateVehicleHook;
+extern TrampolineHook createEventUpdateVehicleHook;
 void createEventUpdateVehicle(int vehicleID, int updateType, int partID,
                               Vector* pos, Vector* normal);
-extern subhook::Hook createEventSoundHook;
+extern TrampolineHook createEventSoundHook;
 void createEventSound(int soundType, Vector* pos, float volume, float pitch);
-extern subhook::Hook createEventSoundItemHook;
+extern TrampolineHook createEventSoundItemHook;
 void createEventSoundItem(unsigned int soundType, int itemID, float volume, float pitch);
-extern subhook::Hook createEventBulletHook;
+extern TrampolineHook createEventBulletHook;
 void createEventBullet(int bulletType, Vector* pos, Vector* vel, int itemID);
-extern subhook::Hook createEventBulletHitHook;
+extern TrampolineHook createEventBulletHitHook;
 void createEventBulletHit(int unk, int hitType, Vector* pos, Vector* normal);
 
-extern subhook::Hook lineIntersectHumanHook;
+extern sol::table lineIntersectHumanResult;
+extern TrampolineHook lineIntersectHumanHook;
 int lineIntersectHuman(int humanID, Vector* posA, Vector* posB, float padding);
-extern subhook::Hook lineIntersectLevelHook;
+extern TrampolineHook lineIntersectLevelHook;
 int lineIntersectLevel(Vector* posA, Vector* posB, int unk);
 
 struct Float {
@@ -0,0 +1,166 @@
+#include "httppool.h"
+
+#include <stdexcept>
+
+void HTTPClientPool::removeExpired(std::vector<IdleClient>& removed) {
+	auto now = std::chrono::steady_clock::now();
+	while (!idle.empty() && now - idle.front().since >= idleTimeout) {
+		removed.push_back(std::move(idle.front()));
+		idle.pop_front();
+		expired++;
+	}
+}
+
+void HTTPClientPool::trim(std::vector<IdleClient>& removed) {
+	while (idle.size() > maxSize) {
+		removed.push_back(std::move(idle.front()));
+		idle.pop_front();
+	}
+}
+
+std::unique_ptr<httplib::Client> HTTPClientPool::acquire(
+    const std::string& scheme) {
+	// Closing connections can block, so it's done after unlocking
+	std::vector<IdleClient> removed;
+	std::lock_guard<std::mutex> guard(mutex);
+	removeExpired(removed);
+
+	// Newest first, as it's the most likely to still be connected
+	for (auto it = idle.rbegin(); it != idle.rend(); ++it) {
+		if (it->scheme == scheme) {
+			auto client = std::move(it->client);
+			idle.erase(std::next(it).base());
+			hits++;
+			return client;
+		}
+	}
+
+	misses++;
+	auto client = std::make_unique<httplib::Client>(scheme);
+	client->set_keep_alive(true);
+	return client;
+}
+
+void HTTPClientPool::release(const std::string& scheme,
+                             std::unique_ptr<httplib::Client> client) {
+	std::vector<IdleClient> removed;
+	std::lock_guard<std::mutex> guard(mutex);
+	if (!maxSize) return;
+
+	idle.push_back({scheme, std::move(client), std::chrono::steady_clock::now()});
+	removeExpired(removed);
+	trim(removed);
+}
+
+void HTTPClientPool::setLimits(size_t maxSize, int idleTimeout) {
+	if (idleTimeout < 0) throw std::invalid_argument("Invalid idle timeout");
+
+	std::vector<IdleClient> removed;
+	std::lock_guard<std::mutex> guard(mutex);
+	this->maxSize = maxSize;
+	this->idleTimeout = std::chrono::seconds(idleTimeout);
+	removeExpired(removed);
+	trim(removed);
+}
+
+HTTPClientPool::Stats HTTPClientPool::getStats() {
+	std::lock_guard<std::mutex> guard(mutex);
+	return {hits, misses, expired, idle.size()};
+}
+
+HTTPPool::~HTTPPool() {
+	{
+		std::lock_guard<std::mutex> guard(requestsMutex);
+		stopping = true;
+	}
+	requestsCondition.notify_all();
+	for (auto& thread : threads) thread.join();
+}
+
+bool HTTPPool::enqueue(LuaHTTPRequest&& request) {
+	{
+		std::lock_guard<std::mutex> guard(requestsMutex);
+		if (pending >= maxPending) return false;
+		pending++;
+		requests.push_back(std::move(request));
+
+		while (threads.size() < numThreads)
+			threads.emplace_back(&HTTPPool::runThread, this);
+	}
+	requestsCondition.notify_one();
+	return true;
+}
+
+void HTTPPool::cancel(unsigned int id) {
+	std::lock_guard<std::mutex> guard(requestsMutex);
+	cancelled.insert(id);
+}
+
+bool HTTPPool::receive(LuaHTTPResponse& response) {
+	{
+		std::lock_guard<std::mutex> guard(responsesMutex);
+		if (responses.empty()) return false;
+		response = std::move(responses.front());
+		responses.pop();
+	}
+
+	// It may have been cancelled after it finished
+	std::lock_guard<std::mutex> guard(requestsMutex);
+	cancelled.erase(response.id);
+	return true;
+}
+
+size_t HTTPPool::getPending() {
+	std::lock_guard<std::mutex> guard(requestsMutex);
+	return pending;
+}
+
+void HTTPPool::finish(LuaHTTPResponse&& response) {
+	{
+		std::lock_guard<std::mutex> guard(requestsMutex);
+		pending--;
+		if (cancelled.erase(response.id)) return;
+	}
+
+	std::lock_guard<std::mutex> guard(responsesMutex);
+	responses.push(std::move(response));
+}
+
+void HTTPPool::runThread() {
+	while (true) {
+		LuaHTTPRequest request;
+		{
+			std::unique_lock<std::mutex> lock(requestsMutex);
+			requestsCondition.wait(
+			    lock, [this] { return stopping || !requests.empty(); });
+			if (stopping) return;
+
+			request = std::move(requests.front());
+			requests.pop_front();
+			if (cancelled.erase(request.id)) {
+				pending--;
+				continue;
+			}
+		}
+
+		auto client = clients.acquire(request.scheme);
+		client->set_connection_timeout(request.timeout);
+		client->set_read_timeout(request.timeout);
+		client->set_write_timeout(request.timeout);
+
+		auto res = request.type == post
+		               ? client->Post(request.path.c_str(), request.headers,
+		                              request.body, request.contentType.c_str())
+		               : client->Get(request.path.c_str(), request.headers);
+
+		LuaHTTPResponse response{request.id, false, 0, {}, {}};
+		if (res) {
+			response.responded = true;
+			response.status = res->status;
+			response.body = std::move(res->body);
+			response.headers = std::move(res->headers);
+			clients.release(request.scheme, std::move(client));
+		}
+		finish(std::move(response));
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#define CPPHTTPLIB_OPENSSL_SUPPORT
+#include "../cpp-httplib/httplib.h"
+
+enum LuaRequestType { get, post };
+
+// Requests and responses only hold plain data so they can cross threads; the
+// Lua callbacks stay on the main thread, looked up by id.
+struct LuaHTTPRequest {
+	unsigned int id;
+	LuaRequestType type;
+	std::string scheme;
+	std::string path;
+	std::string contentType;
+	std::string body;
+	httplib::Headers headers;
+	time_t timeout;
+};
+
+struct LuaHTTPResponse {
+	unsigned int id;
+	bool responded;
+	int status;
+	std::string body;
+	httplib::Headers headers;
+};
+
+// Idle keep-alive clients keyed by scheme and host, so repeated requests to the
+// same server skip the TCP and TLS handshakes. Shared by every thread.
+class HTTPClientPool {
+ public:
+	struct Stats {
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t expired;
+		size_t idle;
+	};
+
+ private:
+	struct IdleClient {
+		std::string scheme;
+		std::unique_ptr<httplib::Client> client;
+		std::chrono::steady_clock::time_point since;
+	};
+
+	std::mutex mutex;
+	// Oldest first
+	std::deque<IdleClient> idle;
+	size_t maxSize;
+	std::chrono::seconds idleTimeout;
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t expired = 0;
+
+	void removeExpired(std::vector<IdleClient>& removed);
+	void trim(std::vector<IdleClient>& removed);
+
+ public:
+	HTTPClientPool(size_t maxSize, int idleTimeout)
+	    : maxSize(maxSize), idleTimeout(idleTimeout) {}
+	// Takes an idle client for the scheme, or makes a new one.
+	std::unique_ptr<httplib::Client> acquire(const std::string& scheme);
+	// Only give back clients whose last request succeeded.
+	void release(const std::string& scheme,
+	             std::unique_ptr<httplib::Client> client);
+	void setLimits(size_t maxSize, int idleTimeout);
+	Stats getStats();
+};
+
+// Fixed set of threads making HTTP requests off the game thread. The threads
+// are started by the first request.
+class HTTPPool {
+	HTTPClientPool& clients;
+	size_t numThreads;
+	size_t maxPending;
+	std::vector<std::thread> threads;
+	bool stopping = false;
+
+	std::mutex requestsMutex;
+	std::condition_variable requestsCondition;
+	std::deque<LuaHTTPRequest> requests;
+	std::unordered_set<unsigned int> cancelled;
+	size_t pending = 0;
+
+	std::mutex responsesMutex;
+	std::queue<LuaHTTPResponse> responses;
+
+	void runThread();
+	void finish(LuaHTTPResponse&& response);
+
+ public:
+	HTTPPool(HTTPClientPool& clients, size_t numThreads, size_t maxPending)
+	    : clients(clients), numThreads(numThreads), maxPending(maxPending) {}
+	~HTTPPool();
+	// Returns false if too many requests are already pending.
+	bool enqueue(LuaHTTPRequest&& request);
+	// Skips the request if no thread has started on it yet.
+	void cancel(unsigned int id);
+	bool receive(LuaHTTPResponse& response);
+	size_t getPending();
+};
@@ -0,0 +1,173 @@
+#include "httpserver.h"
+
+#include <chrono>
+#include <stdexcept>
+
+// cpp-httplib can't answer a request after its handler returns, so each
+// request waiting on Lua holds a thread. Only some of the threads may wait, so
+// the rest are always free for cached and mounted responses.
+static constexpr size_t numThreads = 64;
+static constexpr size_t maxWaitingRequests = 48;
+static constexpr auto responseTimeout = std::chrono::seconds(10);
+static constexpr auto closingCheckInterval = std::chrono::milliseconds(100);
+
+static constexpr const char* errorNotOpen = "Server is not open";
+
+HTTPServerRequest::~HTTPServerRequest() {
+	// Don't leave the server thread waiting if Lua dropped it
+	if (!responded) promise.set_value({500, "", "text/plain", {}});
+}
+
+sol::table HTTPServerRequest::getHeaders(sol::this_state s) const {
+	sol::state_view lua(s);
+	sol::table table = lua.create_table();
+	for (const auto& h : headers) table[h.first] = h.second;
+	return table;
+}
+
+sol::table HTTPServerRequest::getParams(sol::this_state s) const {
+	sol::state_view lua(s);
+	sol::table table = lua.create_table();
+	for (const auto& p : params) table[p.first] = p.second;
+	return table;
+}
+
+void HTTPServerRequest::respond(int status, sol::optional<std::string> body,
+                                sol::optional<std::string> contentType,
+                                sol::optional<sol::table> headers) {
+	if (responded) throw std::runtime_error("Already responded");
+
+	HTTPServerResponse response{status, body.value_or(""),
+	                            contentType.value_or("text/plain"), {}};
+	if (headers) {
+		for (const auto& pair : *headers)
+			response.headers.emplace(pair.first.as<std::string>(),
+			                         pair.second.as<std::string>());
+	}
+
+	responded = true;
+	promise.set_value(std::move(response));
+}
+
+HTTPServer::HTTPServer(unsigned short port, sol::optional<sol::table> mounts)
+    : port(port), requests(maxWaitingRequests) {
+	server.new_task_queue = [] { return new httplib::ThreadPool(numThreads); };
+
+	if (mounts) {
+		for (const auto& pair : *mounts) {
+			if (!server.set_mount_point(pair.first.as<std::string>(),
+			                            pair.second.as<std::string>()))
+				throw std::invalid_argument("Mounted directory does not exist");
+		}
+	}
+
+	auto handler = [this](const httplib::Request& req, httplib::Response& res) {
+		handle(req, res);
+	};
+	server.Get(".*", handler);
+	server.Post(".*", handler);
+	server.Put(".*", handler);
+	server.Patch(".*", handler);
+	server.Delete(".*", handler);
+
+	if (!server.bind_to_port("0.0.0.0", port))
+		throw std::runtime_error("Could not bind to port");
+
+	thread = std::thread([this] { server.listen_after_bind(); });
+}
+
+HTTPServer::~HTTPServer() {
+	if (isOpen()) close();
+}
+
+void HTTPServer::handle(const httplib::Request& req, httplib::Response& res) {
+	if (req.method == "GET") {
+		std::shared_lock<std::shared_mutex> lock(cacheMutex);
+		auto it = cache.find(req.path);
+		if (it != cache.end()) {
+			res.status = it->second.status;
+			res.set_content(it->second.body, it->second.contentType.c_str());
+			return;
+		}
+	}
+
+	if (closing) {
+		res.status = 503;
+		return;
+	}
+
+	struct WaitingGuard {
+		std::atomic_size_t& waiting;
+		~WaitingGuard() { waiting--; }
+	} guard{waiting};
+	if (waiting++ >= maxWaitingRequests) {
+		res.status = 503;
+		return;
+	}
+
+	auto request = std::make_shared<HTTPServerRequest>();
+	request->method = req.method;
+	request->path = req.path;
+	request->body = req.body;
+	request->address = req.remote_addr;
+	request->headers = req.headers;
+	request->params = req.params;
+
+	auto future = request->getFuture();
+	if (!requests.push(std::move(request))) {
+		res.status = 503;
+		return;
+	}
+
+	auto deadline = std::chrono::steady_clock::now() + responseTimeout;
+	while (future.wait_for(closingCheckInterval) != std::future_status::ready) {
+		if (closing) {
+			res.status = 503;
+			return;
+		}
+		if (std::chrono::steady_clock::now() >= deadline) {
+			res.status = 504;
+			return;
+		}
+	}
+
+	auto response = future.get();
+	res.status = response.status;
+	for (const auto& h : response.headers) res.set_header(h.first, h.second);
+	res.set_content(response.body, response.contentType.c_str());
+}
+
+void HTTPServer::rejectQueued() {
+	std::shared_ptr<HTTPServerRequest> request;
+	while (requests.pop(request)) request->respond(503, {}, {}, {});
+}
+
+void HTTPServer::close() {
+	if (!isOpen()) throw std::runtime_error(errorNotOpen);
+
+	closing = true;
+	server.stop();
+	thread.join();
+	rejectQueued();
+}
+
+sol::object HTTPServer::receive(sol::this_state s) {
+	if (!isOpen()) throw std::runtime_error(errorNotOpen);
+
+	sol::state_view lua(s);
+
+	std::shared_ptr<HTTPServerRequest> request;
+	if (!requests.pop(request)) return sol::make_object(lua, sol::nil);
+	return sol::make_object(lua, request);
+}
+
+void HTTPServer::setCached(std::string path, int status, std::string body,
+                           sol::optional<std::string> contentType) {
+	std::unique_lock<std::shared_mutex> lock(cacheMutex);
+	cache[path] = {status, body, contentType.value_or("text/plain")};
+}
+
+bool HTTPServer::removeCached(std::string path) {
+	std::unique_lock<std::shared_mutex> lock(cacheMutex);
+	return cache.erase(path);
+}
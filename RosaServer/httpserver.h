@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <future>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "mpmcqueue.h"
+#include "sol/sol.hpp"
+
+#define CPPHTTPLIB_OPENSSL_SUPPORT
+#include "../cpp-httplib/httplib.h"
+
+struct HTTPServerResponse {
+	int status;
+	std::string body;
+	std::string contentType;
+	httplib::Headers headers;
+};
+
+// A request waiting on Lua. The server thread handling it blocks until it's
+// responded to, times out, or the server closes.
+class HTTPServerRequest {
+	std::promise<HTTPServerResponse> promise;
+	bool responded = false;
+
+ public:
+	std::string method;
+	std::string path;
+	std::string body;
+	std::string address;
+	httplib::Headers headers;
+	httplib::Params params;
+
+	~HTTPServerRequest();
+	std::future<HTTPServerResponse> getFuture() { return promise.get_future(); }
+
+	const char* getClass() const { return "HTTPServerRequest"; }
+	std::string getMethod() const { return method; }
+	std::string getPath() const { return path; }
+	std::string getBody() const { return body; }
+	std::string getAddress() const { return address; }
+	bool hasResponded() const { return responded; }
+	sol::table getHeaders(sol::this_state s) const;
+	sol::table getParams(sol::this_state s) const;
+	void respond(int status, sol::optional<std::string> body,
+	             sol::optional<std::string> contentType,
+	             sol::optional<sol::table> headers);
+};
+
+// Listens on its own threads. Mounted directories and cached responses are
+// served there; everything else is queued for Lua to receive each tick. At
+// most 48 requests wait on Lua at once, and more get a 503.
+class HTTPServer {
+	struct CachedResponse {
+		int status;
+		std::string body;
+		std::string contentType;
+	};
+
+	httplib::Server server;
+	std::thread thread;
+	unsigned short port;
+	std::atomic_bool closing = false;
+	// Requests sent to Lua which haven't been answered yet
+	std::atomic_size_t waiting = 0;
+
+	MPMCQueue<std::shared_ptr<HTTPServerRequest>> requests;
+
+	std::shared_mutex cacheMutex;
+	std::unordered_map<std::string, CachedResponse> cache;
+
+	void handle(const httplib::Request& req, httplib::Response& res);
+	void rejectQueued();
+
+ public:
+	HTTPServer(unsigned short port, sol::optional<sol::table> mounts);
+	~HTTPServer();
+
+	const char* getClass() const { return "HTTPServer"; }
+	bool isOpen() const { return thread.joinable(); }
+	unsigned short getPort() const { return port; }
+	void close();
+	sol::object receive(sol::this_state s);
+	void setCached(std::string path, int status, std::string body,
+	               sol::optional<std::string> contentType);
+	bool removeCached(std::string path);
+};
@@ -0,0 +1,52 @@
+#include "latencyhistogram.h"
+
+int LatencyHistogram::getBucketIndex(uint64_t value) {
+	if (value < subBucketCount) return value;
+
+	int exponent = 63 - __builtin_clzll(value);
+	if (exponent > maxExponent) return bucketCount - 1;
+
+	int subBucket = (value >> (exponent - subBucketBits)) & (subBucketCount - 1);
+	return (exponent - subBucketBits + 1) * subBucketCount + subBucket;
+}
+
+uint64_t LatencyHistogram::getBucketUpperBound(int index) {
+	if (index < subBucketCount) return index;
+
+	int exponent = index / subBucketCount + subBucketBits - 1;
+	uint64_t subBucket = index % subBucketCount;
+	int shift = exponent - subBucketBits;
+	return ((subBucketCount + subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds) {
+	buckets[getBucketIndex(nanoseconds)]++;
+	if (count == 0 || nanoseconds < min) min = nanoseconds;
+	if (nanoseconds > max) max = nanoseconds;
+	count++;
+	total += nanoseconds;
+}
+
+void LatencyHistogram::reset() { *this = LatencyHistogram(); }
+
+double LatencyHistogram::getMean() const {
+	if (count == 0) return 0.0;
+	return static_cast<double>(total) / count;
+}
+
+uint64_t LatencyHistogram::getPercentile(double percentile) const {
+	if (count == 0) return 0;
+
+	uint64_t target = static_cast<uint64_t>(percentile / 100.0 * count + 0.5);
+	if (target < 1) target = 1;
+
+	uint64_t seen = 0;
+	for (int i = 0; i < bucketCount; i++) {
+		seen += buckets[i];
+		if (seen >= target) {
+			uint64_t upperBound = getBucketUpperBound(i);
+			return upperBound < max ? upperBound : max;
+		}
+	}
+	return max;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+// Log-linear latency histogram in nanoseconds, in the style of HdrHistogram.
+// Every power of two is split into 16 buckets, so any reported percentile is
+// within ~6% of the recorded value.
+class LatencyHistogram {
+	static constexpr int subBucketBits = 4;
+	static constexpr int subBucketCount = 1 << subBucketBits;
+	static constexpr int maxExponent = 40;
+	static constexpr int bucketCount =
+	    (maxExponent - subBucketBits + 1) * subBucketCount;
+
+	uint64_t buckets[bucketCount] = {0};
+	uint64_t count = 0;
+	uint64_t total = 0;
+	uint64_t min = 0;
+	uint64_t max = 0;
+
+	static int getBucketIndex(uint64_t value);
+	static uint64_t getBucketUpperBound(int index);
+
+ public:
+	void record(uint64_t nanoseconds);
+	void reset();
+	uint64_t getCount() const { return count; }
+	uint64_t getTotal() const { return total; }
+	uint64_t getMin() const { return min; }
+	uint64_t getMax() const { return max; }
+	double getMean() const;
+	uint64_t getPercentile(double percentile) const;
+};
+
+// Records the time until it goes out of scope, unless given no histogram.
+class LatencyTimer {
+	LatencyHistogram* histogram;
+	std::chrono::steady_clock::time_point start;
+
+ public:
+	LatencyTimer(LatencyHistogram* histogram) : histogram(histogram) {
+		if (histogram) start = std::chrono::steady_clock::now();
+	}
+	~LatencyTimer() {
+		if (histogram) {
+			auto elapsed = std::chrono::steady_clock::now() - start;
+			histogram->record(
+			    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+			        .count());
+		}
+	}
+};
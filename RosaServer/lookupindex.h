@@ -0,0 +1,33 @@
+#pragma once
+#include <unordered_map>
+
+// Maps a key such as a phone number to the first index in one of the engine's
+// arrays holding it. The map is rebuilt from the array the next time it's used
+// after being invalidated, and every hit is checked against the array so that
+// a write which didn't invalidate it can't return the wrong entity.
+template <typename Key>
+class LookupIndex {
+	std::unordered_map<Key, int> indices;
+	bool stale = true;
+
+ public:
+	void invalidate() { stale = true; }
+
+	// Rebuild is called with a function taking (key, index) for every entity in
+	// index order, and Matches checks whether an index still holds a key.
+	template <typename Rebuild, typename Matches>
+	int find(const Key& key, Rebuild rebuild, Matches matches) {
+		if (!stale) {
+			auto search = indices.find(key);
+			if (search == indices.end()) return -1;
+			if (matches(search->second, key)) return search->second;
+		}
+
+		indices.clear();
+		rebuild([this](const Key& key, int index) { indices.emplace(key, index); });
+		stale = false;
+
+		auto search = indices.find(key);
+		return search == indices.end() ? -1 : search->second;
+	}
+};
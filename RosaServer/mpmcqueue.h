@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bounded lock-free queue for any number of producers and consumers, after
+// Dmitry Vyukov's. Each cell's sequence number says whether it's ready to be
+// written or read, so a full or empty queue fails instead of blocking.
+template <typename T>
+class MPMCQueue {
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	size_t mask;
+	alignas(64) std::atomic<size_t> enqueuePosition{0};
+	alignas(64) std::atomic<size_t> dequeuePosition{0};
+
+ public:
+	// Rounded up to a power of two.
+	MPMCQueue(size_t capacity) {
+		size_t size = 2;
+		while (size < capacity) size <<= 1;
+		cells = std::make_unique<Cell[]>(size);
+		mask = size - 1;
+		for (size_t i = 0; i < size; i++)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	bool push(T&& value) {
+		Cell* cell;
+		size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		while (true) {
+			cell = &cells[position & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			auto difference =
+			    static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+			if (difference == 0) {
+				if (enqueuePosition.compare_exchange_weak(position, position + 1,
+				                                          std::memory_order_relaxed))
+					break;
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = enqueuePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		cell->value = std::move(value);
+		cell->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T& value) {
+		Cell* cell;
+		size_t position = dequeuePosition.load(std::memory_order_relaxed);
+		while (true) {
+			cell = &cells[position & mask];
+			size_t sequence = cell->sequence.load(std::memory_order_acquire);
+			auto difference = static_cast<intptr_t>(sequence) -
+			                  static_cast<intptr_t>(position + 1);
+			if (difference == 0) {
+				if (dequeuePosition.compare_exchange_weak(position, position + 1,
+				                                          std::memory_order_relaxed))
+					break;
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = dequeuePosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		value = std::move(cell->value);
+		cell->value = T();
+		cell->sequence.store(position + mask + 1, std::memory_order_release);
+		return true;
+	}
+};
@@ -0,0 +1,77 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Names of one of the engine's type arrays sorted case-insensitively, so that
+// looking a type up by name or prefix is a binary search instead of a strcmp
+// against every type. Rebuilt when the level loads or a name is written.
+class NameIndex {
+	struct Entry {
+		std::string lowerName;
+		std::string name;
+		int index;
+	};
+
+	std::vector<Entry> entries;
+	bool stale = true;
+
+	static std::string toLower(std::string_view string) {
+		std::string lower(string);
+		for (char& c : lower) c = std::tolower(static_cast<unsigned char>(c));
+		return lower;
+	}
+
+	auto lowerBound(const std::string& lowerName) const {
+		return std::lower_bound(entries.begin(), entries.end(), lowerName,
+		                        [](const Entry& entry, const std::string& name) {
+			                        return entry.lowerName < name;
+		                        });
+	}
+
+ public:
+	void invalidate() { stale = true; }
+	bool isStale() const { return stale; }
+
+	template <typename GetName>
+	void rebuild(int count, GetName getName) {
+		entries.clear();
+		for (int i = 0; i < count; i++) {
+			std::string name = getName(i);
+			entries.push_back({toLower(name), std::move(name), i});
+		}
+		std::sort(entries.begin(), entries.end(),
+		          [](const Entry& a, const Entry& b) {
+			          if (a.lowerName != b.lowerName)
+				          return a.lowerName < b.lowerName;
+			          return a.index < b.index;
+		          });
+		stale = false;
+	}
+
+	// The lowest index with the given name, or -1.
+	int find(std::string_view name, bool ignoreCase) const {
+		std::string lowerName = toLower(name);
+		for (auto it = lowerBound(lowerName);
+		     it != entries.end() && it->lowerName == lowerName; it++) {
+			if (ignoreCase || it->name == name) return it->index;
+		}
+		return -1;
+	}
+
+	// Indices of every name starting with the prefix, ignoring case, in name
+	// order.
+	std::vector<int> findPrefix(std::string_view prefix) const {
+		std::string lowerPrefix = toLower(prefix);
+		std::vector<int> indices;
+		for (auto it = lowerBound(lowerPrefix);
+		     it != entries.end() && it->lowerName.compare(0, lowerPrefix.size(),
+		                                                 lowerPrefix) == 0;
+		     it++) {
+			indices.push_back(it->index);
+		}
+		return indices;
+	}
+};
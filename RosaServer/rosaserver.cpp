@@ -64,11 +64,8 @@ void defineThreadSafeAPIs(sol::state* state) {
 
 	{
 		auto meta = state->new_usertype<Vector>("new", sol::no_constructor);
-		meta["x"] = &Vector::x;
-		meta["y"] = &Vector::y;
-		meta["z"] = &Vector::z;
+		bindEntityFields(meta);
 
-		meta["class"] = sol::property(&Vector::getClass);
 		meta["__tostring"] = &Vector::__tostring;
 		meta["__add"] = &Vector::__add;
 		meta["__sub"] = &Vector::__sub;
@@ -77,6 +74,10 @@ void defineThreadSafeAPIs(sol::state* state) {
 		meta["__div"] = &Vector::__div;
 		meta["__unm"] = &Vector::__unm;
 		meta["add"] = &Vector::add;
+		meta["addInPlace"] = &Vector::add;
+		meta["subInPlace"] = &Vector::subInPlace;
+		meta["rotateInPlace"] = &Vector::rotateInPlace;
+		meta["lerpInto"] = &Vector::lerpInto;
 		meta["mult"] = &Vector::mult;
 		meta["set"] = &Vector::set;
 		meta["clone"] = &Vector::clone;
@@ -91,19 +92,11 @@ void defineThreadSafeAPIs(sol::state* state) {
 
 	{
 		auto meta = state->new_usertype<RotMatrix>("new", sol::no_constructor);
-		meta["x1"] = &RotMatrix::x1;
-		meta["y1"] = &RotMatrix::y1;
-		meta["z1"] = &RotMatrix::z1;
-		meta["x2"] = &RotMatrix::x2;
-		meta["y2"] = &RotMatrix::y2;
-		meta["z2"] = &RotMatrix::z2;
-		meta["x3"] = &RotMatrix::x3;
-		meta["y3"] = &RotMatrix::y3;
-		meta["z3"] = &RotMatrix::z3;
-
-		meta["class"] = sol::property(&RotMatrix::getClass);
+		bindEntityFields(meta);
+
 		meta["__tostring"] = &RotMatrix::__tostring;
 		meta["__mul"] = &RotMatrix::__mul;
+		meta["mulInPlace"] = &RotMatrix::mulInPlace;
 		meta["set"] = &RotMatrix::set;
 		meta["clone"] = &RotMatrix::clone;
 		meta["getForward"] = &RotMatrix::getForward;
@@ -166,6 +159,7 @@ void defineThreadSafeAPIs(sol::state* state) {
 		    "TCPServer", sol::constructors<TCPServer(unsigned short)>());
 		meta["close"] = &TCPServer::close;
 		meta["accept"] = &TCPServer::accept;
+		meta["poll"] = &TCPServer::poll;
 
 		meta["isOpen"] = sol::property(&TCPServer::isOpen);
 	}
@@ -182,6 +176,36 @@ void defineThreadSafeAPIs(sol::state* state) {
 		meta["address"] = sol::property(&TCPServerConnection::getAddress);
 	}
 
+	{
+		auto meta = state->new_usertype<HTTPServer>(
+		    "HTTPServer",
+		    sol::constructors<HTTPServer(unsigned short,
+		                                 sol::optional<sol::table>)>());
+		meta["close"] = &HTTPServer::close;
+		meta["receive"] = &HTTPServer::receive;
+		meta["setCached"] = &HTTPServer::setCached;
+		meta["removeCached"] = &HTTPServer::removeCached;
+
+		meta["class"] = sol::property(&HTTPServer::getClass);
+		meta["isOpen"] = sol::property(&HTTPServer::isOpen);
+		meta["port"] = sol::property(&HTTPServer::getPort);
+	}
+
+	{
+		auto meta =
+		    state->new_usertype<HTTPServerRequest>("new", sol::no_constructor);
+		meta["getHeaders"] = &HTTPServerRequest::getHeaders;
+		meta["getParams"] = &HTTPServerRequest::getParams;
+		meta["respond"] = &HTTPServerRequest::respond;
+
+		meta["class"] = sol::property(&HTTPServerRequest::getClass);
+		meta["method"] = sol::property(&HTTPServerRequest::getMethod);
+		meta["path"] = sol::property(&HTTPServerRequest::getPath);
+		meta["body"] = sol::property(&HTTPServerRequest::getBody);
+		meta["address"] = sol::property(&HTTPServerRequest::getAddress);
+		meta["responded"] = sol::property(&HTTPServerRequest::hasResponded);
+	}
+
 	(*state)["print"] = Lua::print;
 
 	(*state)["Vector"] = sol::overload(Lua::Vector_, Lua::Vector_3f);
@@ -214,6 +238,13 @@ void defineThreadSafeAPIs(sol::state* state) {
 		cryptoTable["sha256"] = Lua::crypto::sha256;
 	}
 
+	{
+		auto worldDeltaTable = state->create_table();
+		(*state)["worldDelta"] = worldDeltaTable;
+		worldDeltaTable["receive"] = Lua::worldDelta::receive;
+		worldDeltaTable["getQueued"] = Lua::worldDelta::getQueued;
+	}
+
 	(*state)["FILE_WATCH_ACCESS"] = IN_ACCESS;
 	(*state)["FILE_WATCH_ATTRIB"] = IN_ATTRIB;
 	(*state)["FILE_WATCH_CLOSE_WRITE"] = IN_CLOSE_WRITE;
@@ -243,6 +274,14 @@ void luaInit(bool redo) {
 	std::lock_guard<std::mutex> guard(stateResetMutex);
 
 	Hooks::run = sol::nil;
+	Hooks::clearCallbacks();
+	Lua::http::clearCallbacks();
+	Hooks::lineIntersectHumanResult = sol::table();
+	spatialHash.enabled = false;
+	spatialHash.clear();
+	accountLookupsEnabled = false;
+	worldDelta.enabled = false;
+	worldDelta.reset();
 
 	if (redo) {
 		Console::log(LUA_PREFIX "Resetting state...\n");
@@ -378,13 +417,9 @@ void luaInit(bool redo) {
 
 	{
 		auto meta = lua->new_usertype<Connection>("new", sol::no_constructor);
-		meta["port"] = &Connection::port;
-		meta["timeoutTime"] = &Connection::timeoutTime;
+		bindEntityFields(meta);
 
-		meta["class"] = sol::property(&Connection::getClass);
 		meta["address"] = sol::property(&Connection::getAddress);
-		meta["adminVisible"] = sol::property(&Connection::getAdminVisible,
-		                                     &Connection::setAdminVisible);
 		meta["player"] =
 		    sol::property(&Connection::getPlayer, &Connection::setPlayer);
 		meta["spectatingHuman"] = sol::property(&Connection::getSpectatingHuman);
@@ -395,21 +430,13 @@ void luaInit(bool redo) {
 
 	{
 		auto meta = lua->new_usertype<Account>("new", sol::no_constructor);
-		meta["subRosaID"] = &Account::subRosaID;
-		meta["phoneNumber"] = &Account::phoneNumber;
-		meta["money"] = &Account::money;
-		meta["corporateRating"] = &Account::corporateRating;
-		meta["criminalRating"] = &Account::criminalRating;
-		meta["spawnTimer"] = &Account::spawnTimer;
-		meta["playTime"] = &Account::playTime;
-		meta["banTime"] = &Account::banTime;
-
-		meta["class"] = sol::property(&Account::getClass);
+		bindEntityFields(meta);
+
+		meta["phoneNumber"] =
+		    sol::property(&Account::getPhoneNumber, &Account::setPhoneNumber);
 		meta["__tostring"] = &Account::__tostring;
 		meta["index"] = sol::property(&Account::getIndex);
 		meta["data"] = sol::property(&Account::getDataTable);
-		meta["name"] = sol::property(&Account::getName);
-		meta["steamID"] = sol::property(&Account::getSteamID);
 	}
 
 	{
@@ -427,61 +454,11 @@ void luaInit(bool redo) {
 
 	{
 		auto meta = lua->new_usertype<Player>("new", sol::no_constructor);
-		meta["subRosaID"] = &Player::subRosaID;
-		meta["phoneNumber"] = &Player::phoneNumber;
-		meta["money"] = &Player::money;
-		meta["teamMoney"] = &Player::teamMoney;
-		meta["budget"] = &Player::budget;
-		meta["corporateRating"] = &Player::corporateRating;
-		meta["criminalRating"] = &Player::criminalRating;
-		meta["itemsBought"] = &Player::itemsBought;
-		meta["team"] = &Player::team;
-		meta["teamSwitchTimer"] = &Player::teamSwitchTimer;
-		meta["stocks"] = &Player::stocks;
-		meta["spawnTimer"] = &Player::spawnTimer;
-		meta["gearX"] = &Player::gearX;
-		meta["leftRightInput"] = &Player::leftRightInput;
-		meta["gearY"] = &Player::gearY;
-		meta["forwardBackInput"] = &Player::forwardBackInput;
-		meta["viewYawDelta"] = &Player::viewYawDelta;
-		meta["viewPitch"] = &Player::viewPitch;
-		meta["freeLookYaw"] = &Player::freeLookYaw;
-		meta["freeLookPitch"] = &Player::freeLookPitch;
-		meta["viewYaw"] = &Player::viewYaw;
-		meta["viewPitchDelta"] = &Player::viewPitchDelta;
-		meta["inputFlags"] = &Player::inputFlags;
-		meta["lastInputFlags"] = &Player::lastInputFlags;
-		meta["zoomLevel"] = &Player::zoomLevel;
-		meta["inputType"] = &Player::inputType;
-		meta["menuTab"] = &Player::menuTab;
-		meta["numActions"] = &Player::numActions;
-		meta["lastNumActions"] = &Player::lastNumActions;
-		meta["numMenuButtons"] = &Player::numMenuButtons;
-		meta["gender"] = &Player::gender;
-		meta["skinColor"] = &Player::skinColor;
-		meta["hairColor"] = &Player::hairColor;
-		meta["hair"] = &Player::hair;
-		meta["eyeColor"] = &Player::eyeColor;
-		meta["model"] = &Player::model;
-		meta["suitColor"] = &Player::suitColor;
-		meta["tieColor"] = &Player::tieColor;
-		meta["head"] = &Player::head;
-		meta["necklace"] = &Player::necklace;
-
-		meta["class"] = sol::property(&Player::getClass);
+		bindEntityFields(meta);
+
 		meta["__tostring"] = &Player::__tostring;
 		meta["index"] = sol::property(&Player::getIndex);
-		meta["isActive"] =
-		    sol::property(&Player::getIsActive, &Player::setIsActive);
 		meta["data"] = sol::property(&Player::getDataTable);
-		meta["name"] = sol::property(&Player::getName, &Player::setName);
-		meta["isAdmin"] = sol::property(&Player::getIsAdmin, &Player::setIsAdmin);
-		meta["isReady"] = sol::property(&Player::getIsReady, &Player::setIsReady);
-		meta["isGodMode"] =
-		    sol::property(&Player::getIsGodMode, &Player::setIsGodMode);
-		meta["isBot"] = sol::property(&Player::getIsBot, &Player::setIsBot);
-		meta["isZombie"] =
-		    sol::property(&Player::getIsZombie, &Player::setIsZombie);
 		meta["human"] = sol::property(&Player::getHuman, &Player::setHuman);
 		meta["connection"] = sol::property(&Player::getConnection);
 		meta["account"] = sol::property(&Player::getAccount, &Player::setAccount);
@@ -499,64 +476,12 @@ void luaInit(bool redo) {
 
 	{
 		auto meta = lua->new_usertype<Human>("new", sol::no_constructor);
-		meta["stamina"] = &Human::stamina;
-		meta["maxStamina"] = &Human::maxStamina;
-		meta["vehicleSeat"] = &Human::vehicleSeat;
-		meta["despawnTime"] = &Human::despawnTime;
-		meta["spawnProtection"] = &Human::spawnProtection;
-		meta["movementState"] = &Human::movementState;
-		meta["zoomLevel"] = &Human::zoomLevel;
-		meta["damage"] = &Human::damage;
-		meta["pos"] = &Human::pos;
-		meta["viewYaw"] = &Human::viewYaw;
-		meta["viewPitch"] = &Human::viewPitch;
-		meta["viewYaw2"] = &Human::viewYaw2;
-		meta["strafeInput"] = &Human::strafeInput;
-		meta["walkInput"] = &Human::walkInput;
-		meta["viewPitch2"] = &Human::viewPitch2;
-		meta["inputFlags"] = &Human::inputFlags;
-		meta["lastInputFlags"] = &Human::lastInputFlags;
-		meta["health"] = &Human::health;
-		meta["bloodLevel"] = &Human::bloodLevel;
-		meta["chestHP"] = &Human::chestHP;
-		meta["headHP"] = &Human::headHP;
-		meta["leftArmHP"] = &Human::leftArmHP;
-		meta["rightArmHP"] = &Human::rightArmHP;
-		meta["leftLegHP"] = &Human::leftLegHP;
-		meta["rightLegHP"] = &Human::rightLegHP;
-		meta["progressBar"] = &Human::progressBar;
-		meta["inventoryAnimationFlags"] = &Human::inventoryAnimationFlags;
-		meta["inventoryAnimationProgress"] = &Human::inventoryAnimationProgress;
-		meta["inventoryAnimationDuration"] = &Human::inventoryAnimationDuration;
-		meta["inventoryAnimationHand"] = &Human::inventoryAnimationHand;
-		meta["inventoryAnimationSlot"] = &Human::inventoryAnimationSlot;
-		meta["inventoryAnimationCounterFinished"] =
-		    &Human::inventoryAnimationCounterFinished;
-		meta["inventoryAnimationCounter"] = &Human::inventoryAnimationCounter;
-		meta["gender"] = &Human::gender;
-		meta["head"] = &Human::head;
-		meta["skinColor"] = &Human::skinColor;
-		meta["hairColor"] = &Human::hairColor;
-		meta["hair"] = &Human::hair;
-		meta["eyeColor"] = &Human::eyeColor;
-		meta["model"] = &Human::model;
-		meta["suitColor"] = &Human::suitColor;
-		meta["tieColor"] = &Human::tieColor;
-		meta["necklace"] = &Human::necklace;
-		meta["lastUpdatedWantedGroup"] = &Human::lastUpdatedWantedGroup;
-
-		meta["class"] = sol::property(&Human::getClass);
+		bindEntityFields(meta);
+
 		meta["__tostring"] = &Human::__tostring;
 		meta["index"] = sol::property(&Human::getIndex);
 		meta["isActive"] = sol::property(&Human::getIsActive, &Human::setIsActive);
 		meta["data"] = sol::property(&Human::getDataTable);
-		meta["isAlive"] = sol::property(&Human::getIsAlive, &Human::setIsAlive);
-		meta["isImmortal"] =
-		    sol::property(&Human::getIsImmortal, &Human::setIsImmortal);
-		meta["isOnGround"] = sol::property(&Human::getIsOnGround);
-		meta["isStanding"] = sol::property(&Human::getIsStanding);
-		meta["isBleeding"] =
-		    sol::property(&Human::getIsBleeding, &Human::setIsBleeding);
 		meta["player"] = sol::property(&Human::getPlayer, &Human::setPlayer);
 		meta["account"] = sol::property(&Human::getAccount, &Human::setAccount);
 		meta["vehicle"] = sol::property(&Human::getVehicle, &Human::setVehicle);
@@ -576,28 +501,11 @@ void luaInit(bool redo) {
 
 	{
 		auto meta = lua->new_usertype<ItemType>("new", sol::no_constructor);
-		meta["price"] = &ItemType::price;
-		meta["mass"] = &ItemType::mass;
-		meta["fireRate"] = &ItemType::fireRate;
-		meta["magazineAmmo"] = &ItemType::magazineAmmo;
-		meta["bulletType"] = &ItemType::bulletType;
-		meta["bulletVelocity"] = &ItemType::bulletVelocity;
-		meta["bulletSpread"] = &ItemType::bulletSpread;
-		meta["numHands"] = &ItemType::numHands;
-		meta["rightHandPos"] = &ItemType::rightHandPos;
-		meta["leftHandPos"] = &ItemType::leftHandPos;
-		meta["primaryGripStiffness"] = &ItemType::primaryGripStiffness;
-		meta["primaryGripRotation"] = &ItemType::primaryGripRotation;
-		meta["secondaryGripStiffness"] = &ItemType::secondaryGripStiffness;
-		meta["secondaryGripRotation"] = &ItemType::secondaryGripRotation;
-		meta["boundsCenter"] = &ItemType::boundsCenter;
-		meta["gunHoldingPos"] = &ItemType::gunHoldingPos;
-
-		meta["class"] = sol::property(&ItemType::getClass);
+		bindEntityFields(meta);
+
 		meta["__tostring"] = &ItemType::__tostring;
 		meta["index"] = sol::property(&ItemType::getIndex);
 		meta["name"] = sol::property(&ItemType::getName, &ItemType::setName);
-		meta["isGun"] = sol::property(&ItemType::getIsGun, &ItemType::setIsGun);
 
 		meta["getCanMountTo"] = &ItemType::getCanMountTo;
 		meta["setCanMountTo"] = &ItemType::setCanMountTo;
@@ -605,38 +513,12 @@ void luaInit(bool redo) {
 
 	{
 		auto meta = lua->new_usertype<Item>("new", sol::no_constructor);
-		meta["physicsSettledTimer"] = &Item::physicsSettledTimer;
-		meta["despawnTime"] = &Item::despawnTime;
-		meta["parentSlot"] = &Item::parentSlot;
-		meta["pos"] = &Item::pos;
-		meta["vel"] = &Item::vel;
-		meta["rot"] = &Item::rot;
-		meta["bullets"] = &Item::bullets;
-		meta["numChildItems"] = &Item::numChildItems;
-		meta["cooldown"] = &Item::cooldown;
-		meta["cashSpread"] = &Item::cashSpread;
-		meta["cashAmount"] = &Item::cashBillAmount;
-		meta["cashPureValue"] = &Item::cashPureValue;
-		meta["phoneNumber"] = &Item::phoneNumber;
-		meta["displayPhoneNumber"] = &Item::displayPhoneNumber;
-		meta["enteredPhoneNumber"] = &Item::enteredPhoneNumber;
-		meta["phoneTexture"] = &Item::phoneTexture;
-		meta["computerCurrentLine"] = &Item::computerCurrentLine;
-		meta["computerTopLine"] = &Item::computerTopLine;
-		meta["computerCursor"] = &Item::computerCursor;
-
-		meta["class"] = sol::property(&Item::getClass);
+		bindEntityFields(meta);
+
 		meta["__tostring"] = &Item::__tostring;
 		meta["index"] = sol::property(&Item::getIndex);
 		meta["isActive"] = sol::property(&Item::getIsActive, &Item::setIsActive);
 		meta["data"] = sol::property(&Item::getDataTable);
-		meta["hasPhysics"] =
-		    sol::property(&Item::getHasPhysics, &Item::setHasPhysics);
-		meta["physicsSettled"] =
-		    sol::property(&Item::getPhysicsSettled, &Item::setPhysicsSettled);
-		meta["isStatic"] = sol::property(&Item::getIsStatic, &Item::setIsStatic);
-		meta["isInPocket"] =
-		    sol::property(&Item::getIsInPocket, &Item::setIsInPocket);
 		meta["type"] = sol::property(&Item::getType, &Item::setType);
 		meta["rigidBody"] = sol::property(&Item::getRigidBody);
 		meta["connectedPhone"] =
@@ -670,17 +552,11 @@ void luaInit(bool redo) {
 
 	{
 		auto meta = lua->new_usertype<VehicleType>("new", sol::no_constructor);
-		meta["controllableState"] = &VehicleType::controllableState;
-		meta["price"] = &VehicleType::price;
-		meta["mass"] = &VehicleType::mass;
-		meta["numWheels"] = &VehicleType::numWheels;
+		bindEntityFields(meta);
 
-		meta["class"] = sol::property(&VehicleType::getClass);
 		meta["__tostring"] = &VehicleType::__tostring;
 		meta["index"] = sol::property(&VehicleType::getIndex);
 		meta["name"] = sol::property(&VehicleType::getName, &VehicleType::setName);
-		meta["usesExternalModel"] =
-		    sol::property(&VehicleType::getUsesExternalModel);
 	}
 
 	{
@@ -696,31 +572,13 @@ void luaInit(bool redo) {
 
 	{
 		auto meta = lua->new_usertype<Vehicle>("new", sol::no_constructor);
-		meta["controllableState"] = &Vehicle::controllableState;
-		meta["health"] = &Vehicle::health;
-		meta["color"] = &Vehicle::color;
-		meta["despawnTime"] = &Vehicle::despawnTime;
-		meta["pos"] = &Vehicle::pos;
-		meta["pos2"] = &Vehicle::pos2;
-		meta["rot"] = &Vehicle::rot;
-		meta["vel"] = &Vehicle::vel;
-		meta["gearX"] = &Vehicle::gearX;
-		meta["steerControl"] = &Vehicle::steerControl;
-		meta["gearY"] = &Vehicle::gearY;
-		meta["gasControl"] = &Vehicle::gasControl;
-		meta["engineRPM"] = &Vehicle::engineRPM;
-		meta["bladeBodyID"] = &Vehicle::bladeBodyID;
-		meta["numSeats"] = &Vehicle::numSeats;
-		meta["numWheels"] = &Vehicle::numWheels;
-
-		meta["class"] = sol::property(&Vehicle::getClass);
+		bindEntityFields(meta);
+
 		meta["__tostring"] = &Vehicle::__tostring;
 		meta["index"] = sol::property(&Vehicle::getIndex);
 		meta["isActive"] =
 		    sol::property(&Vehicle::getIsActive, &Vehicle::setIsActive);
 		meta["type"] = sol::property(&Vehicle::getType, &Vehicle::setType);
-		meta["isLocked"] =
-		    sol::property(&Vehicle::getIsLocked, &Vehicle::setIsLocked);
 		meta["data"] = sol::property(&Vehicle::getDataTable);
 		meta["lastDriver"] = sol::property(&Vehicle::getLastDriver);
 		meta["rigidBody"] = sol::property(&Vehicle::getRigidBody);
@@ -737,13 +595,8 @@ void luaInit(bool redo) {
 
 	{
 		auto meta = lua->new_usertype<Bullet>("new", sol::no_constructor);
-		meta["type"] = &Bullet::type;
-		meta["time"] = &Bullet::time;
-		meta["lastPos"] = &Bullet::lastPos;
-		meta["pos"] = &Bullet::pos;
-		meta["vel"] = &Bullet::vel;
+		bindEntityFields(meta);
 
-		meta["class"] = sol::property(&Bullet::getClass);
 		meta["player"] = sol::property(&Bullet::getPlayer);
 	}
 
@@ -759,22 +612,13 @@ void luaInit(bool redo) {
 
 	{
 		auto meta = lua->new_usertype<RigidBody>("new", sol::no_constructor);
-		meta["type"] = &RigidBody::type;
-		meta["unk0"] = &RigidBody::unk0;
-		meta["mass"] = &RigidBody::mass;
-		meta["pos"] = &RigidBody::pos;
-		meta["vel"] = &RigidBody::vel;
-		meta["rot"] = &RigidBody::rot;
-		meta["rotVel"] = &RigidBody::rotVel;
-
-		meta["class"] = sol::property(&RigidBody::getClass);
+		bindEntityFields(meta);
+
 		meta["__tostring"] = &RigidBody::__tostring;
 		meta["index"] = sol::property(&RigidBody::getIndex);
 		meta["isActive"] =
 		    sol::property(&RigidBody::getIsActive, &RigidBody::setIsActive);
 		meta["data"] = sol::property(&RigidBody::getDataTable);
-		meta["isSettled"] =
-		    sol::property(&RigidBody::getIsSettled, &RigidBody::setIsSettled);
 
 		meta["bondTo"] = &RigidBody::bondTo;
 		meta["bondRotTo"] = &RigidBody::bondRotTo;
@@ -845,6 +689,17 @@ void luaInit(bool redo) {
 		                                         &EarShot::setTransmittingItem);
 	}
 
+	{
+		auto meta = lua->new_usertype<EventCursor>(
+		    "EventCursor",
+		    sol::constructors<EventCursor(), EventCursor(sol::table)>());
+		meta["class"] = sol::property(&EventCursor::getClass);
+		meta["position"] = sol::property(&EventCursor::getPosition);
+		meta["wraps"] = sol::property(&EventCursor::getWraps);
+		meta["poll"] = &EventCursor::poll;
+		meta["skip"] = &EventCursor::skip;
+	}
+
 	{
 		auto meta = lua->new_usertype<Worker>(
 		    "Worker", sol::constructors<Worker(std::string)>());
@@ -917,21 +772,12 @@ void luaInit(bool redo) {
 
 	{
 		auto meta = lua->new_usertype<TrafficCar>("new", sol::no_constructor);
-		meta["pos"] = &TrafficCar::pos;
-		meta["vel"] = &TrafficCar::vel;
-		meta["yaw"] = &TrafficCar::yaw;
-		meta["rot"] = &TrafficCar::rot;
-		meta["color"] = &TrafficCar::color;
-		meta["state"] = &TrafficCar::state;
-
-		meta["class"] = sol::property(&TrafficCar::getClass);
+		bindEntityFields(meta);
+
 		meta["__tostring"] = &TrafficCar::__tostring;
 		meta["index"] = sol::property(&TrafficCar::getIndex);
 		meta["type"] = sol::property(&TrafficCar::getType, &TrafficCar::setType);
 		meta["human"] = sol::property(&TrafficCar::getHuman, &TrafficCar::setHuman);
-		meta["isBot"] = sol::property(&TrafficCar::getIsBot, &TrafficCar::setIsBot);
-		meta["isAggressive"] = sol::property(&TrafficCar::getIsAggressive,
-		                                     &TrafficCar::setIsAggressive);
 		meta["vehicle"] =
 		    sol::property(&TrafficCar::getVehicle, &TrafficCar::setVehicle);
 	}
@@ -981,6 +827,13 @@ void luaInit(bool redo) {
 		meta["message"] = sol::property(&Event::getMessage, &Event::setMessage);
 	}
 
+	{
+		auto meta = lua->new_usertype<SpatialQuery>("new", sol::no_constructor);
+		meta["class"] = sol::property(&SpatialQuery::getClass);
+		meta["count"] = sol::property(&SpatialQuery::getCount);
+		meta["__call"] = &SpatialQuery::next;
+	}
+
 	{
 		auto meta = lua->new_usertype<Hooks::Float>("new", sol::no_constructor);
 		meta["value"] = &Hooks::Float::value;
@@ -1006,9 +859,29 @@ void luaInit(bool redo) {
 		hookTable["enable"] = Lua::hook::enable;
 		hookTable["disable"] = Lua::hook::disable;
 		hookTable["clear"] = Lua::hook::clear;
+		hookTable["register"] = Lua::hook::registerCallback;
+		hookTable["observe"] = Lua::hook::observe;
+		hookTable["unregister"] = Lua::hook::unregisterCallback;
+		hookTable["getStats"] = Lua::hook::getStats;
+		hookTable["setStatsEnabled"] = Lua::hook::setStatsEnabled;
+		hookTable["resetStats"] = Lua::hook::resetStats;
+		hookTable["startTrace"] = Lua::hook::startTrace;
+		hookTable["stopTrace"] = Lua::hook::stopTrace;
+		hookTable["getTrampolineStats"] = Lua::hook::getTrampolineStats;
 		Lua::hook::clear();
 	}
 
+	{
+		auto tickProfilerTable = lua->create_table();
+		(*lua)["tickProfiler"] = tickProfilerTable;
+		tickProfilerTable["setEnabled"] = Lua::tickProfiler::setEnabled;
+		tickProfilerTable["getBudget"] = Lua::tickProfiler::getBudget;
+		tickProfilerTable["setBudget"] = Lua::tickProfiler::setBudget;
+		tickProfilerTable["setCapacity"] = Lua::tickProfiler::setCapacity;
+		tickProfilerTable["getTicks"] = Lua::tickProfiler::getTicks;
+		tickProfilerTable["getStats"] = Lua::tickProfiler::getStats;
+	}
+
 	{
 		auto physicsTable = lua->create_table();
 		(*lua)["physics"] = physicsTable;
@@ -1022,6 +895,14 @@ void luaInit(bool redo) {
 		physicsTable["lineIntersectVehicleQuick"] =
 		    Lua::physics::lineIntersectVehicleQuick;
 		physicsTable["lineIntersectAnyQuick"] = Lua::physics::lineIntersectAnyQuick;
+		physicsTable["RAY_LEVEL"] = Lua::physics::RaycastLevel;
+		physicsTable["RAY_HUMANS"] = Lua::physics::RaycastHumans;
+		physicsTable["RAY_VEHICLES"] = Lua::physics::RaycastVehicles;
+		physicsTable["RAY_WHEELS"] = Lua::physics::RaycastWheels;
+		physicsTable["RAY_ONLY_CITY"] = Lua::physics::RaycastOnlyCity;
+		physicsTable["raycastBatch"] = Lua::physics::raycastBatch;
+		physicsTable["getBroadPhaseStats"] = Lua::physics::getBroadPhaseStats;
+		physicsTable["resetBroadPhaseStats"] = Lua::physics::resetBroadPhaseStats;
 		physicsTable["lineIntersectTriangle"] = Lua::physics::lineIntersectTriangle;
 		physicsTable["garbageCollectBullets"] = Lua::physics::garbageCollectBullets;
 		physicsTable["createBlock"] = Lua::physics::createBlock;
@@ -1029,6 +910,42 @@ void luaInit(bool redo) {
 		physicsTable["deleteBlock"] = Lua::physics::deleteBlock;
 	}
 
+	{
+		auto worldTable = lua->create_table();
+		(*lua)["world"] = worldTable;
+		worldTable["saveSnapshot"] = Lua::world::saveSnapshot;
+		worldTable["loadSnapshot"] = Lua::world::loadSnapshot;
+	}
+
+	{
+		sol::table httpTable = (*lua)["http"];
+		httpTable["get"] = Lua::http::get;
+		httpTable["post"] = Lua::http::post;
+		httpTable["cancel"] = Lua::http::cancel;
+		httpTable["getPending"] = Lua::http::getPending;
+		httpTable["getPoolStats"] = Lua::http::getPoolStats;
+		httpTable["setPoolLimits"] = Lua::http::setPoolLimits;
+	}
+
+	{
+		sol::table worldDeltaTable = (*lua)["worldDelta"];
+		worldDeltaTable["setEnabled"] = Lua::worldDelta::setEnabled;
+		worldDeltaTable["reset"] = Lua::worldDelta::reset;
+		worldDeltaTable["setCapacity"] = Lua::worldDelta::setCapacity;
+	}
+
+	{
+		auto spatialTable = lua->create_table();
+		(*lua)["spatial"] = spatialTable;
+		spatialTable["HUMANS"] = 1 << SpatialHash::Humans;
+		spatialTable["VEHICLES"] = 1 << SpatialHash::Vehicles;
+		spatialTable["ITEMS"] = 1 << SpatialHash::Items;
+		spatialTable["RIGID_BODIES"] = 1 << SpatialHash::RigidBodies;
+		spatialTable["queryRadius"] = Lua::spatial::queryRadius;
+		spatialTable["nearest"] = Lua::spatial::nearest;
+		spatialTable["queryBox"] = Lua::spatial::queryBox;
+	}
+
 	{
 		auto chatTable = lua->create_table();
 		(*lua)["chat"] = chatTable;
@@ -1043,6 +960,8 @@ void luaInit(bool redo) {
 		accountsTable["getCount"] = Lua::accounts::getCount;
 		accountsTable["getAll"] = Lua::accounts::getAll;
 		accountsTable["getByPhone"] = Lua::accounts::getByPhone;
+		accountsTable["getBySteamID"] = Lua::accounts::getBySteamID;
+		accountsTable["getByName"] = Lua::accounts::getByName;
 
 		sol::table _meta = lua->create_table();
 		accountsTable[sol::metatable_key] = _meta;
@@ -1055,7 +974,10 @@ void luaInit(bool redo) {
 		(*lua)["players"] = playersTable;
 		playersTable["getCount"] = Lua::players::getCount;
 		playersTable["getAll"] = Lua::players::getAll;
+		playersTable["each"] = Lua::players::each;
+		playersTable["eachNonBot"] = Lua::players::eachNonBot;
 		playersTable["getByPhone"] = Lua::players::getByPhone;
+		playersTable["getByName"] = Lua::players::getByName;
 		playersTable["getNonBots"] = Lua::players::getNonBots;
 		playersTable["getBots"] = Lua::players::getBots;
 		playersTable["createBot"] = Lua::players::createBot;
@@ -1071,6 +993,7 @@ void luaInit(bool redo) {
 		(*lua)["humans"] = humansTable;
 		humansTable["getCount"] = Lua::humans::getCount;
 		humansTable["getAll"] = Lua::humans::getAll;
+		humansTable["each"] = Lua::humans::each;
 		humansTable["create"] = Lua::humans::create;
 
 		sol::table _meta = lua->create_table();
@@ -1085,6 +1008,7 @@ void luaInit(bool redo) {
 		itemTypesTable["getCount"] = Lua::itemTypes::getCount;
 		itemTypesTable["getAll"] = Lua::itemTypes::getAll;
 		itemTypesTable["getByName"] = Lua::itemTypes::getByName;
+		itemTypesTable["findByPrefix"] = Lua::itemTypes::findByPrefix;
 
 		sol::table _meta = lua->create_table();
 		itemTypesTable[sol::metatable_key] = _meta;
@@ -1097,6 +1021,7 @@ void luaInit(bool redo) {
 		(*lua)["items"] = itemsTable;
 		itemsTable["getCount"] = Lua::items::getCount;
 		itemsTable["getAll"] = Lua::items::getAll;
+		itemsTable["each"] = Lua::items::each;
 		itemsTable["create"] =
 		    sol::overload(Lua::items::create, Lua::items::createVel);
 		itemsTable["createRope"] = Lua::items::createRope;
@@ -1113,6 +1038,7 @@ void luaInit(bool redo) {
 		vehicleTypesTable["getCount"] = Lua::vehicleTypes::getCount;
 		vehicleTypesTable["getAll"] = Lua::vehicleTypes::getAll;
 		vehicleTypesTable["getByName"] = Lua::vehicleTypes::getByName;
+		vehicleTypesTable["findByPrefix"] = Lua::vehicleTypes::findByPrefix;
 
 		sol::table _meta = lua->create_table();
 		vehicleTypesTable[sol::metatable_key] = _meta;
@@ -1125,6 +1051,9 @@ void luaInit(bool redo) {
 		(*lua)["vehicles"] = vehiclesTable;
 		vehiclesTable["getCount"] = Lua::vehicles::getCount;
 		vehiclesTable["getAll"] = Lua::vehicles::getAll;
+		vehiclesTable["each"] = Lua::vehicles::each;
+		vehiclesTable["eachTraffic"] = Lua::vehicles::eachTraffic;
+		vehiclesTable["eachNonTraffic"] = Lua::vehicles::eachNonTraffic;
 		vehiclesTable["getNonTrafficCars"] = Lua::vehicles::getNonTrafficCars;
 		vehiclesTable["getTrafficCars"] = Lua::vehicles::getTrafficCars;
 		vehiclesTable["create"] =
@@ -1149,6 +1078,7 @@ void luaInit(bool redo) {
 		(*lua)["rigidBodies"] = rigidBodiesTable;
 		rigidBodiesTable["getCount"] = Lua::rigidBodies::getCount;
 		rigidBodiesTable["getAll"] = Lua::rigidBodies::getAll;
+		rigidBodiesTable["each"] = Lua::rigidBodies::each;
 
 		sol::table _meta = lua->create_table();
 		rigidBodiesTable[sol::metatable_key] = _meta;
@@ -1252,7 +1182,8 @@ void luaInit(bool redo) {
 		    &Lua::memory::getAddressOfStreetLane, &Lua::memory::getAddressOfStreet,
 		    &Lua::memory::getAddressOfStreetIntersection,
 		    &Lua::memory::getAddressOfInventorySlot,
-		    &Lua::memory::getAddressOfWheel);
+		    &Lua::memory::getAddressOfWheel, &Lua::memory::getAddressOfVector,
+		    &Lua::memory::getAddressOfRotMatrix);
 		memoryTable["toHexByte"] = Lua::memory::toHexByte;
 		memoryTable["toHexShort"] = Lua::memory::toHexShort;
 		memoryTable["toHexInt"] = Lua::memory::toHexInt;
@@ -1282,6 +1213,8 @@ void luaInit(bool redo) {
 		memoryTable["writeFloat"] = Lua::memory::writeFloat;
 		memoryTable["writeDouble"] = Lua::memory::writeDouble;
 		memoryTable["writeBytes"] = Lua::memory::writeBytes;
+
+		FFIStructs::define(*lua, memoryTable);
 	}
 
 	(*lua)["RESET_REASON_BOOT"] = RESET_REASON_BOOT;
@@ -1542,8 +1475,18 @@ static inline void installHook(
 	}
 }
 
-#define INSTALL(name)                                               \
-	installHook(#name "Hook", Hooks::name##Hook, (void*)Engine::name, \
+static inline void installHook(const char* name, Hooks::TrampolineHook& hook,
+                               void* source, void* destination) {
+	if (!hook.install(name, source, destination)) {
+		std::ostringstream stream;
+		stream << RS_PREFIX "Hook " << name << "Hook failed to install";
+
+		throw std::runtime_error(stream.str());
+	}
+}
+
+#define INSTALL(name)                                        \
+	installHook(#name, Hooks::name##Hook, (void*)Engine::name, \
 	            (void*)Hooks::name);
 
 static inline void installHooks() {
@@ -1611,6 +1554,25 @@ static inline void installHooks() {
 	INSTALL(createEventBulletHit);
 	INSTALL(lineIntersectHuman);
 	INSTALL(lineIntersectLevel);
+
+	int numWithoutTrampoline = 0;
+	for (const auto hook : Hooks::trampolineHooks) {
+		if (!hook->hasTrampoline()) {
+			numWithoutTrampoline++;
+
+			std::ostringstream stream;
+			stream << RS_PREFIX "No trampoline for " << hook->name
+			       << ", calls will remove the hook\n";
+			Console::log(stream.str());
+		}
+	}
+
+	std::ostringstream stream;
+	stream << RS_PREFIX "Installed " << Hooks::trampolineHooks.size()
+	       << " hooks (" << numWithoutTrampoline << " without trampolines)\n";
+	Console::log(stream.str());
+
+	Hooks::updateInstalledHooks();
 }
 
 static inline void attachInterruptSignalHandler() {
@@ -9,8 +9,12 @@
 #include "console.h"
 #include "crypto.h"
 #include "engine.h"
+#include "entitybindings.h"
+#include "eventcursor.h"
+#include "ffistructs.h"
 #include "filewatcher.h"
 #include "hooks.h"
+#include "httpserver.h"
 #include "image.h"
 #include "opusencoder.h"
 #include "pointgraph.h"
@@ -3,7 +3,7 @@
 #include "engine.h"
 
 struct Server {
-	const int TPS = 60;
+	const int TPS = ticksPerSecond;
 
 	const char* getClass() const { return "Server"; }
 	int getPort() const { return *Engine::serverPort; }
@@ -0,0 +1,237 @@
+#include "spatialhash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+static constexpr int maxCellCoordinate = 1 << 30;
+
+SpatialHash::SpatialHash(float cellSize) : cellSize(cellSize) {
+	const int capacities[NumKinds] = {maxNumberOfHumans, maxNumberOfVehicles,
+	                                  maxNumberOfItems, maxNumberOfRigidBodies};
+	for (int kind = 0; kind < NumKinds; kind++) {
+		slots[kind].resize(capacities[kind]);
+		members.emplace_back(capacities[kind]);
+	}
+}
+
+int SpatialHash::getCellCoordinate(float value) const {
+	float cell = std::floor(value / cellSize);
+	if (!(cell > -maxCellCoordinate)) return -maxCellCoordinate;
+	if (!(cell < maxCellCoordinate)) return maxCellCoordinate;
+	return static_cast<int>(cell);
+}
+
+uint64_t SpatialHash::getCellKey(int x, int z) {
+	return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 |
+	       static_cast<uint32_t>(z);
+}
+
+void SpatialHash::set(Kind kind, int index, const Vector& pos) {
+	int x = getCellCoordinate(pos.x);
+	int z = getCellCoordinate(pos.z);
+	uint64_t cell = getCellKey(x, z);
+	auto& slot = slots[kind][index];
+
+	if (members[kind].contains(index)) {
+		if (slot.cell == cell) {
+			cells[cell][slot.position].pos = pos;
+			return;
+		}
+		removeFromCell(kind, index);
+	} else {
+		members[kind].insert(index);
+	}
+
+	auto& entries = cells[cell];
+	slot = {cell, entries.size()};
+	entries.push_back({kind, index, pos});
+
+	if (minCellX > maxCellX) {
+		minCellX = maxCellX = x;
+		minCellZ = maxCellZ = z;
+	} else {
+		minCellX = std::min(minCellX, x);
+		maxCellX = std::max(maxCellX, x);
+		minCellZ = std::min(minCellZ, z);
+		maxCellZ = std::max(maxCellZ, z);
+	}
+}
+
+void SpatialHash::removeFromCell(Kind kind, int index) {
+	const auto& slot = slots[kind][index];
+	auto search = cells.find(slot.cell);
+	auto& entries = search->second;
+
+	const auto& last = entries.back();
+	slots[last.kind][last.index].position = slot.position;
+	entries[slot.position] = last;
+	entries.pop_back();
+
+	if (entries.empty()) cells.erase(search);
+}
+
+void SpatialHash::remove(Kind kind, int index) {
+	if (!members[kind].contains(index)) return;
+	removeFromCell(kind, index);
+	members[kind].erase(index);
+}
+
+void SpatialHash::removeMissing(Kind kind, const ActiveSet& keep) {
+	std::vector<int> missing;
+	for (int index : members[kind]) {
+		if (!keep.contains(index)) missing.push_back(index);
+	}
+	for (int index : missing) remove(kind, index);
+}
+
+void SpatialHash::clear() {
+	cells.clear();
+	for (auto& set : members) set.rebuild([](int) { return false; });
+	minCellX = minCellZ = 0;
+	maxCellX = maxCellZ = -1;
+}
+
+template <typename Visit>
+void SpatialHash::forEachCell(int minX, int minZ, int maxX, int maxZ,
+                              Visit visit) const {
+	minX = std::max(minX, minCellX);
+	minZ = std::max(minZ, minCellZ);
+	maxX = std::min(maxX, maxCellX);
+	maxZ = std::min(maxZ, maxCellZ);
+	if (minX > maxX || minZ > maxZ) return;
+
+	// Walking every occupied cell is cheaper than a mostly empty range
+	uint64_t area = static_cast<uint64_t>(maxX - minX + 1) * (maxZ - minZ + 1);
+	if (area > cells.size()) {
+		for (const auto& [key, entries] : cells) {
+			int x = static_cast<int32_t>(key >> 32);
+			int z = static_cast<int32_t>(key);
+			if (x >= minX && x <= maxX && z >= minZ && z <= maxZ) visit(entries);
+		}
+		return;
+	}
+
+	for (int x = minX; x <= maxX; x++) {
+		for (int z = minZ; z <= maxZ; z++) {
+			auto search = cells.find(getCellKey(x, z));
+			if (search != cells.end()) visit(search->second);
+		}
+	}
+}
+
+static float distanceSquare(const Vector& a, const Vector& b) {
+	float dx = a.x - b.x;
+	float dy = a.y - b.y;
+	float dz = a.z - b.z;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+void SpatialHash::queryRadius(const Vector& pos, float radius,
+                              unsigned int kinds,
+                              std::vector<Result>& results) const {
+	float radiusSquare = radius * radius;
+	auto visit = [&](const std::vector<Entry>& entries) {
+		for (const auto& entry : entries) {
+			if (!(kinds & (1 << entry.kind))) continue;
+			float distSquare = distanceSquare(entry.pos, pos);
+			if (distSquare <= radiusSquare) {
+				results.push_back({entry.kind, entry.index, std::sqrt(distSquare)});
+			}
+		}
+	};
+
+	forEachCell(getCellCoordinate(pos.x - radius),
+	            getCellCoordinate(pos.z - radius),
+	            getCellCoordinate(pos.x + radius),
+	            getCellCoordinate(pos.z + radius), visit);
+}
+
+void SpatialHash::queryBox(const Vector& min, const Vector& max,
+                           unsigned int kinds,
+                           std::vector<Result>& results) const {
+	Vector center = {(min.x + max.x) / 2, (min.y + max.y) / 2,
+	                 (min.z + max.z) / 2};
+	auto visit = [&](const std::vector<Entry>& entries) {
+		for (const auto& entry : entries) {
+			if (!(kinds & (1 << entry.kind))) continue;
+			const auto& p = entry.pos;
+			if (p.x < min.x || p.y < min.y || p.z < min.z || p.x > max.x ||
+			    p.y > max.y || p.z > max.z)
+				continue;
+			results.push_back(
+			    {entry.kind, entry.index, std::sqrt(distanceSquare(p, center))});
+		}
+	};
+
+	forEachCell(getCellCoordinate(min.x), getCellCoordinate(min.z),
+	            getCellCoordinate(max.x), getCellCoordinate(max.z), visit);
+}
+
+void SpatialHash::nearest(const Vector& pos, unsigned int kinds, size_t count,
+                          std::vector<Result>& results,
+                          bool (*filter)(Kind kind, int index)) const {
+	if (!count || cells.empty()) return;
+
+	auto further = [](const Result& a, const Result& b) {
+		return a.distance < b.distance;
+	};
+	// Max heap of the closest entities found so far
+	std::priority_queue<Result, std::vector<Result>, decltype(further)> closest(
+	    further);
+
+	auto visit = [&](const std::vector<Entry>& entries) {
+		for (const auto& entry : entries) {
+			if (!(kinds & (1 << entry.kind))) continue;
+			if (filter && !filter(entry.kind, entry.index)) continue;
+			float distance = std::sqrt(distanceSquare(entry.pos, pos));
+			if (closest.size() < count) {
+				closest.push({entry.kind, entry.index, distance});
+			} else if (distance < closest.top().distance) {
+				closest.pop();
+				closest.push({entry.kind, entry.index, distance});
+			}
+		}
+	};
+
+	int x = getCellCoordinate(pos.x);
+	int z = getCellCoordinate(pos.z);
+	int maxRing = std::max({x - minCellX, maxCellX - x, z - minCellZ,
+	                        maxCellZ - z});
+
+	// Search rings of cells outwards until nothing closer can be left
+	for (int ring = 0; ring <= maxRing; ring++) {
+		if (static_cast<uint64_t>(ring) * ring > cells.size()) {
+			// The rings are mostly empty from here on, so check the rest at once
+			auto visitUnseen = [&](const std::vector<Entry>& entries) {
+				const auto& first = entries.front();
+				uint64_t cell = slots[first.kind][first.index].cell;
+				int cellX = static_cast<int32_t>(cell >> 32);
+				int cellZ = static_cast<int32_t>(cell);
+				if (std::abs(cellX - x) >= ring || std::abs(cellZ - z) >= ring)
+					visit(entries);
+			};
+			forEachCell(minCellX, minCellZ, maxCellX, maxCellZ, visitUnseen);
+			break;
+		}
+
+		if (ring == 0) {
+			forEachCell(x, z, x, z, visit);
+		} else {
+			forEachCell(x - ring, z - ring, x + ring, z - ring, visit);
+			forEachCell(x - ring, z + ring, x + ring, z + ring, visit);
+			forEachCell(x - ring, z - ring + 1, x - ring, z + ring - 1, visit);
+			forEachCell(x + ring, z - ring + 1, x + ring, z + ring - 1, visit);
+		}
+
+		if (closest.size() == count && closest.top().distance <= ring * cellSize)
+			break;
+	}
+
+	size_t first = results.size();
+	while (!closest.empty()) {
+		results.push_back(closest.top());
+		closest.pop();
+	}
+	std::reverse(results.begin() + first, results.end());
+}
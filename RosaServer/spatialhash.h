@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "activeset.h"
+#include "sol/sol.hpp"
+#include "structs.h"
+
+// Uniform grid over the x/z plane holding the positions of active entities.
+// Entities are added and removed as they're created and deleted. Positions are
+// brought up to date once per tick after physics, and only entities which
+// crossed into another cell touch the grid.
+class SpatialHash {
+ public:
+	enum Kind : uint8_t { Humans, Vehicles, Items, RigidBodies, NumKinds };
+	static constexpr unsigned int allKinds = (1 << NumKinds) - 1;
+
+	struct Result {
+		Kind kind;
+		int index;
+		float distance;
+	};
+
+	// Only maintained once something has queried it
+	bool enabled = false;
+
+	SpatialHash(float cellSize);
+	void set(Kind kind, int index, const Vector& pos);
+	void remove(Kind kind, int index);
+	// Removes every entity of a kind which is not in the given set.
+	void removeMissing(Kind kind, const ActiveSet& keep);
+	void clear();
+
+	void queryRadius(const Vector& pos, float radius, unsigned int kinds,
+	                 std::vector<Result>& results) const;
+	void queryBox(const Vector& min, const Vector& max, unsigned int kinds,
+	              std::vector<Result>& results) const;
+	// Entities failing the filter don't count towards the closest count.
+	void nearest(const Vector& pos, unsigned int kinds, size_t count,
+	             std::vector<Result>& results,
+	             bool (*filter)(Kind kind, int index) = nullptr) const;
+
+ private:
+	struct Entry {
+		Kind kind;
+		int index;
+		Vector pos;
+	};
+
+	struct Slot {
+		uint64_t cell;
+		size_t position;
+	};
+
+	float cellSize;
+	std::unordered_map<uint64_t, std::vector<Entry>> cells;
+	std::vector<Slot> slots[NumKinds];
+	std::vector<ActiveSet> members;
+	int minCellX = 0, maxCellX = -1;
+	int minCellZ = 0, maxCellZ = -1;
+
+	int getCellCoordinate(float value) const;
+	static uint64_t getCellKey(int x, int z);
+	void removeFromCell(Kind kind, int index);
+	template <typename Visit>
+	void forEachCell(int minX, int minZ, int maxX, int maxZ, Visit visit) const;
+};
+
+// Results of a spatial query, handed to Lua as the iterator of a generic for.
+struct SpatialQuery {
+	std::vector<SpatialHash::Result> results;
+	size_t position = 0;
+
+	const char* getClass() const { return "SpatialQuery"; }
+	int getCount() const { return results.size(); }
+	std::tuple<sol::object, sol::object> next(sol::variadic_args,
+	                                          sol::this_state s);
+};
@@ -15,6 +15,7 @@ static constexpr int maxNumberOfVehicleTypes = 17;
 static constexpr int maxNumberOfVehicles = 512;
 static constexpr int maxNumberOfRigidBodies = 8192;
 static constexpr int maxNumberOfBonds = 16384;
+static constexpr int ticksPerSecond = 60;
 
 using padding = uint8_t;
 
@@ -109,6 +110,8 @@ struct Account {
 	std::string __tostring() const;
 	int getIndex() const;
 	sol::table getDataTable() const;
+	int getPhoneNumber() const { return phoneNumber; }
+	void setPhoneNumber(int number);
 	char* getName() { return name; }
 	std::string getSteamID() { return std::to_string(steamID); }
 };
@@ -128,6 +131,9 @@ struct Vector {
 	Vector __div(float scalar) const;
 	Vector __unm() const;
 	void add(Vector* other);
+	void subInPlace(Vector* other);
+	void rotateInPlace(RotMatrix* rot);
+	void lerpInto(Vector* other, float t, Vector* out) const;
 	void mult(float scalar);
 	void set(Vector* other);
 	Vector clone() const;
@@ -148,6 +154,7 @@ struct RotMatrix {
 	const char* getClass() const { return "RotMatrix"; }
 	std::string __tostring() const;
 	RotMatrix __mul(RotMatrix* other) const;
+	void mulInPlace(RotMatrix* other);
 	void set(RotMatrix* other);
 	RotMatrix clone() const;
 	Vector getForward() const;
@@ -499,7 +506,7 @@ struct Human {
 	std::string __tostring() const;
 	int getIndex() const;
 	bool getIsActive() const { return active; }
-	void setIsActive(bool b) { active = b; }
+	void setIsActive(bool b);
 	sol::table getDataTable() const;
 	bool getIsAlive() const { return oldHealth > 0; }
 	void setIsAlive(bool b) { oldHealth = b ? 100 : 0; }
@@ -573,9 +580,7 @@ struct ItemType {
 	std::string __tostring() const;
 	int getIndex() const;
 	char* getName() { return name; }
-	void setName(const char* newName) {
-		std::strncpy(name, newName, sizeof(name) - 1);
-	}
+	void setName(const char* newName);
 	bool getIsGun() const { return isGun; }
 	void setIsGun(bool b) { isGun = b; }
 
@@ -644,7 +649,7 @@ struct Item {
 	std::string __tostring() const;
 	int getIndex() const;
 	bool getIsActive() const { return active; }
-	void setIsActive(bool b) { active = b; }
+	void setIsActive(bool b);
 	sol::table getDataTable() const;
 	bool getHasPhysics() const { return physicsSim; }
 	void setHasPhysics(bool b) { physicsSim = b; }
@@ -707,9 +712,7 @@ struct VehicleType {
 	int getIndex() const;
 	bool getUsesExternalModel() const { return usesExternalModel; }
 	char* getName() { return name; }
-	void setName(const char* newName) {
-		std::strncpy(name, newName, sizeof(name) - 1);
-	}
+	void setName(const char* newName);
 };
 
 // 171 bytes (AB)
@@ -786,7 +789,7 @@ struct Vehicle {
 	std::string __tostring() const;
 	int getIndex() const;
 	bool getIsActive() const { return active; }
-	void setIsActive(bool b) { active = b; }
+	void setIsActive(bool b);
 	VehicleType* getType();
 	void setType(VehicleType* vehicleType);
 	bool getIsLocked() const { return isLocked; }
@@ -847,7 +850,7 @@ struct RigidBody {
 	std::string __tostring() const;
 	int getIndex() const;
 	bool getIsActive() const { return active; }
-	void setIsActive(bool b) { active = b; }
+	void setIsActive(bool b);
 	sol::table getDataTable() const;
 	bool getIsSettled() const { return settled; }
 	void setIsSettled(bool b) { settled = b; }
@@ -2,6 +2,7 @@
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
@@ -10,6 +11,8 @@
 
 static constexpr int listenBacklog = 128;
 static constexpr size_t maxReadSize = 4096;
+static constexpr int maxPollEvents = 1024;
+static constexpr uint32_t connectionEvents = EPOLLIN | EPOLLRDHUP;
 
 static constexpr const char* errorNotOpen = "Socket is not open";
 
@@ -33,7 +36,18 @@ TCPServerConnection::~TCPServerConnection() {
 	}
 }
 
-ssize_t TCPServerConnection::send(std::string_view data) const {
+void TCPServerConnection::watchWritable(bool watch) {
+	epoll_event event{};
+	event.events = watch ? connectionEvents | EPOLLOUT : connectionEvents;
+	event.data.fd = socketDescriptor;
+	if (epoll_ctl(epollDescriptor, EPOLL_CTL_MOD, socketDescriptor, &event) ==
+	    -1) {
+		throwSafe();
+	}
+	waitingForWritable = watch;
+}
+
+ssize_t TCPServerConnection::send(std::string_view data) {
 	if (socketDescriptor == -1) {
 		throw std::runtime_error(errorNotOpen);
 	}
@@ -44,10 +58,16 @@ ssize_t TCPServerConnection::send(std::string_view data) const {
 
 	auto bytesWritten = write(socketDescriptor, data.data(), data.size());
 	if (bytesWritten == -1) {
-		if (errno == EAGAIN || errno == EWOULDBLOCK) {
-			return 0;
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			throwSafe();
 		}
-		throwSafe();
+		bytesWritten = 0;
+	}
+
+	// Anything short of everything means the send buffer is full
+	if (static_cast<size_t>(bytesWritten) < data.size() &&
+	    epollDescriptor != -1 && !waitingForWritable) {
+		watchWritable(true);
 	}
 
 	return bytesWritten;
@@ -104,13 +124,28 @@ TCPServer::TCPServer(unsigned short port) {
 	if (listen(socketDescriptor, listenBacklog) == -1) {
 		throwSafe();
 	}
+
+	epollDescriptor = epoll_create1(0);
+	if (epollDescriptor == -1) {
+		throwSafe();
+	}
+
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.fd = socketDescriptor;
+	if (epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, socketDescriptor, &event) ==
+	    -1) {
+		throwSafe();
+	}
 }
 
 void TCPServer::closeConnections() {
-	for (auto& connection : connections) {
+	for (auto& pair : connections) {
+		auto& connection = pair.second;
 		if (connection->socketDescriptor != -1) {
 			connection->close();
 		}
+		connection->epollDescriptor = -1;
 	}
 	connections.clear();
 }
@@ -118,7 +153,7 @@ void TCPServer::closeConnections() {
 void TCPServer::clearClosedConnections() {
 	auto it = connections.begin();
 	while (it != connections.end()) {
-		if ((*it)->socketDescriptor == -1) {
+		if (it->second->socketDescriptor == -1) {
 			it = connections.erase(it);
 		} else {
 			++it;
@@ -133,6 +168,8 @@ void TCPServer::close() {
 		throw std::runtime_error(errorNotOpen);
 	}
 
+	::close(epollDescriptor);
+	epollDescriptor = -1;
 	::close(socketDescriptor);
 	socketDescriptor = -1;
 }
@@ -143,13 +180,7 @@ TCPServer::~TCPServer() {
 	}
 }
 
-sol::object TCPServer::accept(sol::this_state s) {
-	if (socketDescriptor == -1) {
-		throw std::runtime_error(errorNotOpen);
-	}
-
-	sol::state_view lua(s);
-
+std::shared_ptr<TCPServerConnection> TCPServer::acceptConnection() {
 	sockaddr_in address;
 	socklen_t addressLength = sizeof(address);
 
@@ -158,7 +189,7 @@ sol::object TCPServer::accept(sol::this_state s) {
 	            &addressLength, SOCK_NONBLOCK);
 	if (clientDescriptor == -1) {
 		if (errno == EAGAIN || errno == EWOULDBLOCK) {
-			return sol::make_object(lua, sol::nil);
+			return nullptr;
 		}
 		throwSafe();
 	}
@@ -169,7 +200,93 @@ sol::object TCPServer::accept(sol::this_state s) {
 	auto connection = std::make_shared<TCPServerConnection>(
 	    clientDescriptor, ntohs(address.sin_port), std::string(addressString));
 
+	epoll_event event{};
+	event.events = connectionEvents;
+	event.data.fd = clientDescriptor;
+	if (epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, clientDescriptor, &event) ==
+	    -1) {
+		throwSafe();
+	}
+	connection->epollDescriptor = epollDescriptor;
+
+	// A closed connection's descriptor may have just been reused
 	clearClosedConnections();
-	connections.push_back(connection);
+	connections[clientDescriptor] = connection;
+	return connection;
+}
+
+sol::object TCPServer::accept(sol::this_state s) {
+	if (socketDescriptor == -1) {
+		throw std::runtime_error(errorNotOpen);
+	}
+
+	sol::state_view lua(s);
+
+	auto connection = acceptConnection();
+	if (!connection) {
+		return sol::make_object(lua, sol::nil);
+	}
 	return sol::make_object(lua, connection);
+}
+
+sol::table TCPServer::poll(sol::this_state s) {
+	if (socketDescriptor == -1) {
+		throw std::runtime_error(errorNotOpen);
+	}
+
+	sol::state_view lua(s);
+	sol::table accepted = lua.create_table();
+	sol::table readable = lua.create_table();
+	sol::table writable = lua.create_table();
+	sol::table closed = lua.create_table();
+
+	epoll_event events[maxPollEvents];
+	int numEvents = epoll_wait(epollDescriptor, events, maxPollEvents, 0);
+	if (numEvents == -1) {
+		if (errno != EINTR) {
+			throwSafe();
+		}
+		numEvents = 0;
+	}
+
+	for (int i = 0; i < numEvents; i++) {
+		const auto& event = events[i];
+
+		if (event.data.fd == socketDescriptor) {
+			while (auto connection = acceptConnection()) {
+				accepted.add(connection);
+			}
+			continue;
+		}
+
+		auto it = connections.find(event.data.fd);
+		if (it == connections.end() || it->second->socketDescriptor == -1) {
+			continue;
+		}
+		auto connection = it->second;
+
+		// Only a hangup in both directions; after EPOLLRDHUP alone there may be
+		// data left to read, and reading the end closes it as usual
+		if (event.events & (EPOLLHUP | EPOLLERR)) {
+			connection->close();
+			closed.add(connection);
+			continue;
+		}
+
+		if (event.events & (EPOLLIN | EPOLLRDHUP)) {
+			readable.add(connection);
+		}
+
+		if (event.events & EPOLLOUT) {
+			connection->watchWritable(false);
+			writable.add(connection);
+		}
+	}
+
+	sol::table result = lua.create_table();
+	result["accepted"] = accepted;
+	result["readable"] = readable;
+	result["writable"] = writable;
+	result["closed"] = closed;
+	return result;
 }
\ No newline at end of file
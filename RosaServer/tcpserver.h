@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "sol/sol.hpp"
@@ -10,6 +11,12 @@ class TCPServerConnection {
 	int socketDescriptor;
 	uint16_t port;
 	std::string address;
+	// The server's epoll instance, so a short send can ask to be told when the
+	// socket is writable again
+	int epollDescriptor = -1;
+	bool waitingForWritable = false;
+
+	void watchWritable(bool watch);
 
  public:
 	TCPServerConnection(int socketDescriptor, uint16_t port, std::string address)
@@ -17,7 +24,7 @@ class TCPServerConnection {
 	~TCPServerConnection();
 
 	void close();
-	ssize_t send(std::string_view data) const;
+	ssize_t send(std::string_view data);
 	sol::object receive(sol::this_state state);
 
 	bool isOpen() const { return socketDescriptor != -1; }
@@ -29,10 +36,13 @@ class TCPServerConnection {
 
 class TCPServer {
 	int socketDescriptor;
-	std::vector<std::shared_ptr<TCPServerConnection>> connections;
+	int epollDescriptor;
+	// Keyed by socket descriptor, to find connections from epoll events
+	std::unordered_map<int, std::shared_ptr<TCPServerConnection>> connections;
 
 	void closeConnections();
 	void clearClosedConnections();
+	std::shared_ptr<TCPServerConnection> acceptConnection();
 
  public:
 	TCPServer(unsigned short port);
@@ -40,6 +50,7 @@ class TCPServer {
 
 	void close();
 	sol::object accept(sol::this_state s);
+	sol::table poll(sol::this_state s);
 
 	bool isOpen() const { return socketDescriptor != -1; }
 };
\ No newline at end of file
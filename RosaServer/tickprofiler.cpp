@@ -0,0 +1,65 @@
+#include "tickprofiler.h"
+
+#include <stdexcept>
+
+const char* const TickProfiler::phaseNames[NumPhases] = {
+    "logicSimulation", "physicsSimulation", "rigidBodySimulation",
+    "bulletSimulation", "serverReceive",     "serverSend",
+    "consoleCommands", "httpCallbacks",     "observers",
+    "worldDelta"};
+
+TickProfiler::TickProfiler(size_t capacity, uint64_t budget)
+    : samples(capacity), budget(budget) {}
+
+void TickProfiler::setCapacity(size_t capacity) {
+	if (capacity < 1) throw std::invalid_argument("Capacity must be positive");
+
+	samples.assign(capacity, Sample());
+	nextSample = 0;
+	numSamples = 0;
+}
+
+const TickProfiler::Sample& TickProfiler::getSample(size_t age) const {
+	if (age >= numSamples) throw std::out_of_range("Tick not recorded");
+
+	return samples[(nextSample + samples.size() - 1 - age) % samples.size()];
+}
+
+const TickProfiler::Sample* TickProfiler::beginTick() {
+	if (!hasCurrent) {
+		hasCurrent = true;
+		return nullptr;
+	}
+
+	Sample& sample = samples[nextSample];
+	sample = current;
+	current = {};
+
+	nextSample = (nextSample + 1) % samples.size();
+	if (numSamples < samples.size()) numSamples++;
+
+	return sample.total > budget ? &sample : nullptr;
+}
+
+void TickProfiler::beginPhase(Phase phase) {
+	if (depth == maxDepth) {
+		depth++;
+		return;
+	}
+	stack[depth++] = {phase, std::chrono::steady_clock::now(), 0};
+}
+
+void TickProfiler::endPhase() {
+	if (--depth >= maxDepth) return;
+
+	const Frame& frame = stack[depth];
+	auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+	                   std::chrono::steady_clock::now() - frame.start)
+	                   .count();
+
+	current.phases[frame.phase] += elapsed - frame.childTime;
+	if (depth > 0)
+		stack[depth - 1].childTime += elapsed;
+	else
+		current.total += elapsed;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Records the exclusive wall-clock time of each phase of the server tick into
+// a ring buffer. Phases may nest; a nested phase's time is only counted once.
+class TickProfiler {
+ public:
+	enum Phase {
+		Logic,
+		Physics,
+		RigidBodies,
+		Bullets,
+		ServerReceive,
+		ServerSend,
+		ConsoleCommands,
+		HTTPCallbacks,
+		Observers,
+		WorldDelta,
+		NumPhases
+	};
+
+	static const char* const phaseNames[NumPhases];
+
+	struct Sample {
+		uint64_t total;
+		uint64_t phases[NumPhases];
+	};
+
+ private:
+	static constexpr int maxDepth = 8;
+
+	struct Frame {
+		Phase phase;
+		std::chrono::steady_clock::time_point start;
+		uint64_t childTime;
+	};
+
+	std::vector<Sample> samples;
+	size_t nextSample = 0;
+	size_t numSamples = 0;
+	Sample current = {};
+	bool hasCurrent = false;
+
+	Frame stack[maxDepth];
+	int depth = 0;
+
+ public:
+	// Off until a script asks for it, since it keeps the phase hooks installed
+	bool enabled = false;
+	uint64_t budget;
+
+	TickProfiler(size_t capacity, uint64_t budget);
+	void setCapacity(size_t capacity);
+	size_t getCapacity() const { return samples.size(); }
+	size_t getNumSamples() const { return numSamples; }
+	// 0 is the most recent completed tick.
+	const Sample& getSample(size_t age) const;
+
+	// Completes the tick in progress, returning it if it went over budget.
+	const Sample* beginTick();
+	void beginPhase(Phase phase);
+	void endPhase();
+};
+
+class ScopedTickPhase {
+	TickProfiler* profiler;
+
+ public:
+	ScopedTickPhase(TickProfiler& tickProfiler, TickProfiler::Phase phase)
+	    : profiler(tickProfiler.enabled ? &tickProfiler : nullptr) {
+		if (profiler) profiler->beginPhase(phase);
+	}
+	~ScopedTickPhase() {
+		if (profiler) profiler->endPhase();
+	}
+};
@@ -0,0 +1,131 @@
+#include "tracerecorder.h"
+
+#include "engine.h"
+
+using HookTrace::ArgType;
+using HookTrace::EntityType;
+
+TraceRecorder::TraceRecorder(const std::string& path) : writer(path) {}
+
+TraceRecorder::~TraceRecorder() { writer.flush(); }
+
+template <typename T>
+static void locate(const T* array, const void* pointer, int& index,
+                   size_t& size) {
+	index = static_cast<const T*>(pointer) - array;
+	size = sizeof(T);
+}
+
+void TraceRecorder::writeEntity(EntityType type, const void* pointer) {
+	int index = -1;
+	size_t size = 0;
+
+	switch (type) {
+		case EntityType::Connection:
+			locate(Engine::connections, pointer, index, size);
+			break;
+		case EntityType::Account:
+			locate(Engine::accounts, pointer, index, size);
+			break;
+		case EntityType::Player:
+			locate(Engine::players, pointer, index, size);
+			break;
+		case EntityType::Human:
+			locate(Engine::humans, pointer, index, size);
+			break;
+		case EntityType::ItemType:
+			locate(Engine::itemTypes, pointer, index, size);
+			break;
+		case EntityType::Item:
+			locate(Engine::items, pointer, index, size);
+			break;
+		case EntityType::VehicleType:
+			locate(Engine::vehicleTypes, pointer, index, size);
+			break;
+		case EntityType::Vehicle:
+			locate(Engine::vehicles, pointer, index, size);
+			break;
+		case EntityType::Bullet:
+			locate(Engine::bullets, pointer, index, size);
+			break;
+		case EntityType::RigidBody:
+			locate(Engine::bodies, pointer, index, size);
+			break;
+		case EntityType::TrafficCar:
+			locate(Engine::trafficCars, pointer, index, size);
+			break;
+		default:
+			break;
+	}
+
+	writer.write(type);
+	writer.write<int32_t>(index);
+
+	uint64_t id =
+	    static_cast<uint64_t>(type) << 32 | static_cast<uint32_t>(index);
+	bool hasSnapshot = size && snapshotted.insert(id).second;
+	writer.write<uint8_t>(hasSnapshot);
+	if (hasSnapshot) {
+		writer.write<uint32_t>(size);
+		writer.writeBytes(pointer, size);
+	}
+}
+
+void TraceRecorder::writeArg(const Hooks::ObservedEvent& event,
+                             const Hooks::ObservedArg& arg) {
+	switch (arg.type) {
+		case Hooks::ObservedArg::Boolean:
+			writer.write(ArgType::Boolean);
+			writer.write<uint8_t>(arg.boolean);
+			break;
+		case Hooks::ObservedArg::Integer:
+			writer.write(ArgType::Integer);
+			writer.write<int64_t>(arg.integer);
+			break;
+		case Hooks::ObservedArg::Number:
+			writer.write(ArgType::Number);
+			writer.write<double>(arg.number);
+			break;
+		case Hooks::ObservedArg::String:
+			writer.write(ArgType::String);
+			writer.write<uint16_t>(arg.string.length);
+			writer.writeBytes(event.strings + arg.string.offset, arg.string.length);
+			break;
+		case Hooks::ObservedArg::Vector:
+			writer.write(ArgType::Vector);
+			writer.writeBytes(&arg.vector, sizeof(float) * 3);
+			break;
+		case Hooks::ObservedArg::RotMatrix:
+			writer.write(ArgType::RotMatrix);
+			writer.writeBytes(&arg.rotMatrix, sizeof(float) * 9);
+			break;
+		case Hooks::ObservedArg::Pointer:
+			writer.write(ArgType::Entity);
+			writeEntity(arg.pointer.entityType, arg.pointer.pointer);
+			break;
+		default:
+			writer.write(ArgType::Nil);
+			break;
+	}
+}
+
+void TraceRecorder::record(const char* name,
+                           const Hooks::ObservedEvent& event) {
+	int tick = *Engine::ticksSinceReset;
+	if (tick != currentTick) {
+		currentTick = tick;
+		snapshotted.clear();
+	}
+
+	size_t nameLength = std::strlen(name);
+	if (nameLength > 255) nameLength = 255;
+
+	writer.write<uint32_t>(tick);
+	writer.write<uint8_t>(event.isPost);
+	writer.write<uint8_t>(nameLength);
+	writer.writeBytes(name, nameLength);
+	writer.write<uint8_t>(event.numArgs);
+	for (int i = 0; i < event.numArgs; i++) writeArg(event, event.args[i]);
+
+	numRecords++;
+}
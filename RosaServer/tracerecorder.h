@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <unordered_set>
+
+#include "hookobserver.h"
+#include "hooktrace.h"
+
+// Writes every hook call to a HookTrace file, along with snapshots of the
+// engine entities passed to it.
+class TraceRecorder {
+	HookTrace::Writer writer;
+	int currentTick = -1;
+	std::unordered_set<uint64_t> snapshotted;
+
+	void writeArg(const Hooks::ObservedEvent& event,
+	              const Hooks::ObservedArg& arg);
+	void writeEntity(HookTrace::EntityType type, const void* pointer);
+
+ public:
+	unsigned long long numRecords = 0;
+
+	TraceRecorder(const std::string& path);
+	~TraceRecorder();
+	void record(const char* name, const Hooks::ObservedEvent& event);
+};
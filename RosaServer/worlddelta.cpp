@@ -0,0 +1,145 @@
+#include "worlddelta.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include "engine.h"
+
+// Offsets of the 4 byte fields tracked for each kind, in the order they're
+// written. Every struct starts with its active flag.
+static const std::vector<size_t> trackedFields[WorldDelta::NumKinds] = {
+    {offsetof(Player, money), offsetof(Player, team), offsetof(Player, humanID),
+     offsetof(Player, phoneNumber), offsetof(Player, corporateRating),
+     offsetof(Player, criminalRating), offsetof(Player, isBot)},
+    {offsetof(Human, pos.x), offsetof(Human, pos.y), offsetof(Human, pos.z),
+     offsetof(Human, viewYaw), offsetof(Human, health),
+     offsetof(Human, bloodLevel), offsetof(Human, playerID),
+     offsetof(Human, vehicleID), offsetof(Human, vehicleSeat)},
+    {offsetof(Vehicle, pos.x), offsetof(Vehicle, pos.y),
+     offsetof(Vehicle, pos.z), offsetof(Vehicle, health),
+     offsetof(Vehicle, type), offsetof(Vehicle, color),
+     offsetof(Vehicle, lastDriverPlayerID), offsetof(Vehicle, trafficCarID)},
+    {offsetof(Item, pos.x), offsetof(Item, pos.y), offsetof(Item, pos.z),
+     offsetof(Item, type), offsetof(Item, parentHumanID),
+     offsetof(Item, parentItemID), offsetof(Item, parentSlot),
+     offsetof(Item, bullets)}};
+
+static constexpr size_t maxTrackedFields = 16;
+
+struct EntityArray {
+	const char* base;
+	size_t stride;
+	int count;
+};
+
+static EntityArray getArray(WorldDelta::Kind kind) {
+	switch (kind) {
+		case WorldDelta::Players:
+			return {reinterpret_cast<const char*>(Engine::players), sizeof(Player),
+			        maxNumberOfPlayers};
+		case WorldDelta::Humans:
+			return {reinterpret_cast<const char*>(Engine::humans), sizeof(Human),
+			        maxNumberOfHumans};
+		case WorldDelta::Vehicles:
+			return {reinterpret_cast<const char*>(Engine::vehicles),
+			        sizeof(Vehicle), maxNumberOfVehicles};
+		default:
+			return {reinterpret_cast<const char*>(Engine::items), sizeof(Item),
+			        maxNumberOfItems};
+	}
+}
+
+template <typename T>
+static void append(std::string& buffer, T value) {
+	buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void WorldDelta::capture(uint32_t tick) {
+	buffer.assign(sizeof(uint32_t) * 2, '\0');
+	uint32_t recordCount = 0;
+
+	for (int k = 0; k < NumKinds; k++) {
+		Kind kind = static_cast<Kind>(k);
+		const auto& fields = trackedFields[kind];
+		auto array = getArray(kind);
+		auto& snapshot = snapshots[kind];
+		if (snapshot.active.empty()) {
+			snapshot.active.resize(array.count);
+			snapshot.values.resize(array.count * fields.size());
+		}
+
+		for (int i = 0; i < array.count; i++) {
+			const char* entity = array.base + i * array.stride;
+			bool wasActive = snapshot.active[i];
+
+			if (!*reinterpret_cast<const int*>(entity)) {
+				if (wasActive) {
+					snapshot.active[i] = false;
+					append(buffer, kind);
+					append<uint16_t>(buffer, i);
+					append<uint16_t>(buffer, 0);
+					recordCount++;
+				}
+				continue;
+			}
+
+			uint32_t* previous = &snapshot.values[i * fields.size()];
+			uint32_t values[maxTrackedFields];
+			uint16_t mask = 0;
+			for (size_t f = 0; f < fields.size(); f++) {
+				std::memcpy(&values[f], entity + fields[f], sizeof(uint32_t));
+				if (!wasActive || values[f] != previous[f]) mask |= 1 << f;
+			}
+			if (!mask) continue;
+
+			snapshot.active[i] = true;
+			append(buffer, kind);
+			append<uint16_t>(buffer, i);
+			append(buffer, mask);
+			for (size_t f = 0; f < fields.size(); f++) {
+				if (!(mask & (1 << f))) continue;
+				append(buffer, values[f]);
+				previous[f] = values[f];
+			}
+			recordCount++;
+		}
+	}
+
+	// Ticks where nothing changed aren't queued
+	if (!recordCount) return;
+	std::memcpy(&buffer[0], &tick, sizeof(tick));
+	std::memcpy(&buffer[sizeof(tick)], &recordCount, sizeof(recordCount));
+
+	std::lock_guard<std::mutex> guard(mutex);
+	deltas.push_back(buffer);
+	while (deltas.size() > capacity) deltas.pop_front();
+}
+
+void WorldDelta::reset() {
+	for (auto& snapshot : snapshots) {
+		snapshot.active.clear();
+		snapshot.values.clear();
+	}
+
+	std::lock_guard<std::mutex> guard(mutex);
+	deltas.clear();
+}
+
+void WorldDelta::setCapacity(size_t newCapacity) {
+	std::lock_guard<std::mutex> guard(mutex);
+	capacity = newCapacity;
+	while (deltas.size() > capacity) deltas.pop_front();
+}
+
+std::optional<std::string> WorldDelta::receive() {
+	std::lock_guard<std::mutex> guard(mutex);
+	if (deltas.empty()) return std::nullopt;
+	std::string delta = std::move(deltas.front());
+	deltas.pop_front();
+	return delta;
+}
+
+size_t WorldDelta::getQueued() {
+	std::lock_guard<std::mutex> guard(mutex);
+	return deltas.size();
+}
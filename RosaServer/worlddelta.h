@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Compares the active players, humans, vehicles and items against the last
+// tick and queues a binary delta of what changed, for mirroring the world to
+// other services. Deltas can be taken from any thread.
+//
+// A delta is a header of {uint32 tick, uint32 recordCount} followed by
+// records of {uint8 kind, uint16 index, uint16 mask}, all little endian. A
+// mask of 0 means the entity was removed. Otherwise one 4 byte value follows
+// for every set bit, in field order; entities which just became active have
+// every bit set.
+class WorldDelta {
+ public:
+	enum Kind : uint8_t { Players, Humans, Vehicles, Items, NumKinds };
+
+	bool enabled = false;
+
+	WorldDelta(size_t capacity) : capacity(capacity) {}
+	void capture(uint32_t tick);
+	// Forgets the last tick so the next delta holds every active entity.
+	void reset();
+	void setCapacity(size_t newCapacity);
+	std::optional<std::string> receive();
+	size_t getQueued();
+
+ private:
+	struct Snapshot {
+		std::vector<bool> active;
+		std::vector<uint32_t> values;
+	};
+
+	Snapshot snapshots[NumKinds];
+	std::string buffer;
+
+	std::deque<std::string> deltas;
+	size_t capacity;
+	std::mutex mutex;
+};
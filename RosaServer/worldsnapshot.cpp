@@ -0,0 +1,198 @@
+#include "worldsnapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "engine.h"
+
+namespace WorldSnapshot {
+struct EntityArray {
+	char* base;
+	size_t structSize;
+	int count;
+	// Accounts end at the first unused one rather than being scattered
+	bool isList;
+};
+
+// Every struct starts with its active flag, or subRosaID for accounts.
+static EntityArray getArray(Kind kind) {
+	switch (kind) {
+		case Accounts:
+			return {reinterpret_cast<char*>(Engine::accounts), sizeof(Account),
+			        maxNumberOfAccounts, true};
+		case Players:
+			return {reinterpret_cast<char*>(Engine::players), sizeof(Player),
+			        maxNumberOfPlayers, false};
+		case Humans:
+			return {reinterpret_cast<char*>(Engine::humans), sizeof(Human),
+			        maxNumberOfHumans, false};
+		case Items:
+			return {reinterpret_cast<char*>(Engine::items), sizeof(Item),
+			        maxNumberOfItems, false};
+		case Vehicles:
+			return {reinterpret_cast<char*>(Engine::vehicles), sizeof(Vehicle),
+			        maxNumberOfVehicles, false};
+		case RigidBodies:
+			return {reinterpret_cast<char*>(Engine::bodies), sizeof(RigidBody),
+			        maxNumberOfRigidBodies, false};
+		default:
+			return {reinterpret_cast<char*>(Engine::bonds), sizeof(Bond),
+			        maxNumberOfBonds, false};
+	}
+}
+
+static int& getActiveFlag(const EntityArray& array, int index) {
+	return *reinterpret_cast<int*>(array.base + index * array.structSize);
+}
+
+static size_t align(size_t offset) { return (offset + 7) & ~size_t(7); }
+
+void save(const std::string& path) {
+	std::vector<int> indices[NumKinds];
+	for (int k = 0; k < NumKinds; k++) {
+		auto array = getArray(static_cast<Kind>(k));
+		for (int i = 0; i < array.count; i++) {
+			if (getActiveFlag(array, i))
+				indices[k].push_back(i);
+			else if (array.isList)
+				break;
+		}
+	}
+
+	Section sections[NumKinds];
+	size_t size = align(sizeof(Header) + sizeof(sections));
+	for (int k = 0; k < NumKinds; k++) {
+		auto array = getArray(static_cast<Kind>(k));
+		auto& section = sections[k];
+		section.kind = k;
+		section.structSize = array.structSize;
+		section.count = indices[k].size();
+		section.unused = 0;
+		section.indicesOffset = size;
+		size = align(size + indices[k].size() * sizeof(int32_t));
+		section.structsOffset = size;
+		size = align(size + indices[k].size() * array.structSize);
+	}
+
+	std::vector<char> data(size);
+	Header header;
+	std::memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.gameVersion = *Engine::version;
+	header.numSections = NumKinds;
+	std::memcpy(&data[0], &header, sizeof(header));
+	std::memcpy(&data[sizeof(header)], sections, sizeof(sections));
+
+	for (int k = 0; k < NumKinds; k++) {
+		auto array = getArray(static_cast<Kind>(k));
+		const auto& section = sections[k];
+		char* structs = &data[section.structsOffset];
+		for (size_t n = 0; n < indices[k].size(); n++) {
+			int32_t index = indices[k][n];
+			std::memcpy(&data[section.indicesOffset + n * sizeof(index)], &index,
+			            sizeof(index));
+			std::memcpy(structs + n * array.structSize,
+			            array.base + index * array.structSize, array.structSize);
+		}
+	}
+
+	// Write next to the old snapshot first so a crash can't leave half of one
+	std::string temporaryPath = path + ".tmp";
+	FILE* file = std::fopen(temporaryPath.c_str(), "wb");
+	if (!file) throw std::runtime_error(strerror(errno));
+	bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+	written = std::fclose(file) == 0 && written;
+	if (!written || std::rename(temporaryPath.c_str(), path.c_str())) {
+		int error = errno;
+		std::remove(temporaryPath.c_str());
+		throw std::runtime_error(strerror(error));
+	}
+}
+
+std::vector<Kind> load(const std::string& path) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1) throw std::runtime_error(strerror(errno));
+
+	struct stat status;
+	if (fstat(fd, &status) == -1) {
+		int error = errno;
+		close(fd);
+		throw std::runtime_error(strerror(error));
+	}
+
+	size_t size = status.st_size;
+	void* mapping = size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+	                     : MAP_FAILED;
+	close(fd);
+	if (mapping == MAP_FAILED) throw std::runtime_error("Invalid snapshot");
+	const char* data = static_cast<const char*>(mapping);
+
+	auto fail = [&](const char* message) {
+		munmap(mapping, size);
+		throw std::runtime_error(message);
+	};
+
+	Header header;
+	if (size < sizeof(header)) fail("Invalid snapshot");
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, magic, sizeof(magic))) fail("Invalid snapshot");
+	if (header.version != version) fail("Unsupported snapshot version");
+	if (header.gameVersion != *Engine::version)
+		fail("Snapshot is from another game version");
+	if (header.numSections > NumKinds ||
+	    size < sizeof(header) + header.numSections * sizeof(Section))
+		fail("Invalid snapshot");
+
+	// Check everything before touching the arrays
+	std::vector<Section> sections(header.numSections);
+	std::memcpy(sections.data(), data + sizeof(header),
+	            sections.size() * sizeof(Section));
+	for (const auto& section : sections) {
+		if (section.kind >= NumKinds) fail("Invalid snapshot");
+		auto array = getArray(static_cast<Kind>(section.kind));
+		if (section.structSize != array.structSize ||
+		    section.count > static_cast<uint32_t>(array.count) ||
+		    section.indicesOffset + section.count * sizeof(int32_t) > size ||
+		    section.structsOffset + section.count * array.structSize > size)
+			fail("Invalid snapshot");
+
+		for (uint32_t n = 0; n < section.count; n++) {
+			int32_t index;
+			std::memcpy(&index, data + section.indicesOffset + n * sizeof(index),
+			            sizeof(index));
+			if (index < 0 || index >= array.count) fail("Invalid snapshot");
+		}
+	}
+
+	std::vector<Kind> restored;
+	for (const auto& section : sections) {
+		auto kind = static_cast<Kind>(section.kind);
+		auto array = getArray(kind);
+		for (int i = 0; i < array.count; i++) {
+			int& active = getActiveFlag(array, i);
+			if (!active && array.isList) break;
+			active = 0;
+		}
+
+		for (uint32_t n = 0; n < section.count; n++) {
+			int32_t index;
+			std::memcpy(&index, data + section.indicesOffset + n * sizeof(index),
+			            sizeof(index));
+			std::memcpy(array.base + index * array.structSize,
+			            data + section.structsOffset + n * array.structSize,
+			            array.structSize);
+		}
+		restored.push_back(kind);
+	}
+
+	munmap(mapping, size);
+	return restored;
+}
+};  // namespace WorldSnapshot
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary checkpoints of the active entries of the engine's arrays. A file is
+// a Header, then numSections Sections, then for every section an array of
+// int32 indices followed by the raw structs, each starting 8 byte aligned, so
+// the file can be mapped and read in place.
+namespace WorldSnapshot {
+static constexpr char magic[4] = {'R', 'S', 'W', 'S'};
+static constexpr uint32_t version = 1;
+
+enum Kind : uint32_t {
+	Accounts,
+	Players,
+	Humans,
+	Items,
+	Vehicles,
+	RigidBodies,
+	Bonds,
+	NumKinds
+};
+
+struct Header {
+	char magic[4];
+	uint32_t version;
+	uint32_t gameVersion;
+	uint32_t numSections;
+};
+
+struct Section {
+	uint32_t kind;
+	uint32_t structSize;
+	uint32_t count;
+	uint32_t unused;
+	uint64_t indicesOffset;
+	uint64_t structsOffset;
+};
+
+void save(const std::string& path);
+// Overwrites the arrays with the snapshot without going through any hooks,
+// returning the kinds which were restored.
+std::vector<Kind> load(const std::string& path);
+};  // namespace WorldSnapshot
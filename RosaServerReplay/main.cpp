@@ -0,0 +1,490 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "entitybindings.h"
+#include "hooktrace.h"
+#include "latencyhistogram.h"
+#include "structs.h"
+
+// Replays a hook trace recorded with hook.startTrace against a Lua script,
+// without the game server, and reports how long the script took per tick.
+//
+// Only the fields in entitybindings.h are bound, and they are backed by the
+// snapshots in the trace rather than the engine, so anything calling back into
+// the game has to be stubbed out by the script.
+
+using HookTrace::ArgType;
+using HookTrace::EntityType;
+
+static constexpr int maxNumberOfConnections = 256;
+static constexpr int maxNumberOfBullets = 16384;
+static constexpr int maxNumberOfTrafficCars = 512;
+
+struct TraceArg {
+	ArgType type;
+	bool boolean;
+	long long integer;
+	double number;
+	std::string string;
+	Vector vector;
+	RotMatrix rotMatrix;
+	EntityType entityType;
+	int index;
+	std::vector<char> snapshot;
+};
+
+struct TraceRecord {
+	unsigned int tick;
+	bool isPost;
+	std::string name;
+	std::vector<TraceArg> args;
+};
+
+// Storage standing in for one of the engine's entity arrays.
+struct EntityMirror {
+	std::vector<char> data;
+	size_t entitySize = 0;
+	int capacity = 0;
+	sol::object (*toObject)(sol::state_view lua, void* pointer) = nullptr;
+
+	void* get(int index) {
+		if (index < 0 || index >= capacity) return nullptr;
+		return data.data() + index * entitySize;
+	}
+};
+
+static EntityMirror mirrors[static_cast<int>(EntityType::Count)];
+
+template <typename T>
+static sol::object entityToObject(sol::state_view lua, void* pointer) {
+	return sol::make_object(lua, static_cast<T*>(pointer));
+}
+
+template <typename T>
+static void createMirror(EntityType type, int capacity) {
+	auto& mirror = mirrors[static_cast<int>(type)];
+	mirror.entitySize = sizeof(T);
+	mirror.capacity = capacity;
+	mirror.data.resize(sizeof(T) * capacity);
+	mirror.toObject = entityToObject<T>;
+}
+
+template <typename T, EntityType type>
+static int getIndex(const T* entity) {
+	const auto& mirror = mirrors[static_cast<int>(type)];
+	return entity - reinterpret_cast<const T*>(mirror.data.data());
+}
+
+static void createMirrors() {
+	createMirror<Connection>(EntityType::Connection, maxNumberOfConnections);
+	createMirror<Account>(EntityType::Account, maxNumberOfAccounts);
+	createMirror<Player>(EntityType::Player, maxNumberOfPlayers);
+	createMirror<Human>(EntityType::Human, maxNumberOfHumans);
+	createMirror<ItemType>(EntityType::ItemType, maxNumberOfItemTypes);
+	createMirror<Item>(EntityType::Item, maxNumberOfItems);
+	createMirror<VehicleType>(EntityType::VehicleType, maxNumberOfVehicleTypes);
+	createMirror<Vehicle>(EntityType::Vehicle, maxNumberOfVehicles);
+	createMirror<Bullet>(EntityType::Bullet, maxNumberOfBullets);
+	createMirror<RigidBody>(EntityType::RigidBody, maxNumberOfRigidBodies);
+	createMirror<TrafficCar>(EntityType::TrafficCar, maxNumberOfTrafficCars);
+}
+
+static std::vector<TraceRecord> readTrace(const std::string& path) {
+	HookTrace::Reader reader(path);
+	std::vector<TraceRecord> records;
+
+	while (!reader.atEnd()) {
+		TraceRecord record;
+		record.tick = reader.read<uint32_t>();
+		record.isPost = reader.read<uint8_t>();
+		record.name = reader.readString(reader.read<uint8_t>());
+
+		uint8_t numArgs = reader.read<uint8_t>();
+		record.args.resize(numArgs);
+		for (auto& arg : record.args) {
+			arg.type = reader.read<ArgType>();
+			switch (arg.type) {
+				case ArgType::Boolean:
+					arg.boolean = reader.read<uint8_t>();
+					break;
+				case ArgType::Integer:
+					arg.integer = reader.read<int64_t>();
+					break;
+				case ArgType::Number:
+					arg.number = reader.read<double>();
+					break;
+				case ArgType::String:
+					arg.string = reader.readString(reader.read<uint16_t>());
+					break;
+				case ArgType::Vector:
+					reader.readBytes(&arg.vector, sizeof(float) * 3);
+					break;
+				case ArgType::RotMatrix:
+					reader.readBytes(&arg.rotMatrix, sizeof(float) * 9);
+					break;
+				case ArgType::Entity:
+					arg.entityType = reader.read<EntityType>();
+					arg.index = reader.read<int32_t>();
+					if (reader.read<uint8_t>()) {
+						arg.snapshot.resize(reader.read<uint32_t>());
+						reader.readBytes(arg.snapshot.data(), arg.snapshot.size());
+					}
+					break;
+				default:
+					break;
+			}
+		}
+
+		records.push_back(std::move(record));
+	}
+
+	return records;
+}
+
+static sol::object argToObject(sol::state_view lua, const TraceArg& arg) {
+	switch (arg.type) {
+		case ArgType::Boolean:
+			return sol::make_object(lua, arg.boolean);
+		case ArgType::Integer:
+			return sol::make_object(lua, arg.integer);
+		case ArgType::Number:
+			return sol::make_object(lua, arg.number);
+		case ArgType::String:
+			return sol::make_object(lua, arg.string);
+		case ArgType::Vector:
+			return sol::make_object(lua, arg.vector);
+		case ArgType::RotMatrix:
+			return sol::make_object(lua, arg.rotMatrix);
+		case ArgType::Entity: {
+			if (arg.entityType >= EntityType::Count) break;
+			auto& mirror = mirrors[static_cast<int>(arg.entityType)];
+			void* entity = mirror.get(arg.index);
+			if (!entity || !mirror.toObject) break;
+			if (arg.snapshot.size() == mirror.entitySize)
+				std::memcpy(entity, arg.snapshot.data(), mirror.entitySize);
+			return mirror.toObject(lua, entity);
+		}
+		default:
+			break;
+	}
+	return sol::make_object(lua, sol::nil);
+}
+
+// Indices are taken from the mirrors rather than the engine's arrays, and
+// properties whose setters live in api.cpp are read-only.
+static void defineEntityTypes(sol::state& lua) {
+	{
+		auto meta = lua.new_usertype<Vector>("new", sol::no_constructor);
+		bindEntityFields(meta);
+	}
+
+	{
+		auto meta = lua.new_usertype<RotMatrix>("new", sol::no_constructor);
+		bindEntityFields(meta);
+	}
+
+	{
+		auto meta = lua.new_usertype<Connection>("new", sol::no_constructor);
+		bindEntityFields(meta);
+		meta["index"] =
+		    sol::property(&getIndex<Connection, EntityType::Connection>);
+	}
+
+	{
+		auto meta = lua.new_usertype<Account>("new", sol::no_constructor);
+		bindEntityFields(meta);
+		meta["index"] = sol::property(&getIndex<Account, EntityType::Account>);
+		meta["phoneNumber"] = sol::property(&Account::getPhoneNumber);
+	}
+
+	{
+		auto meta = lua.new_usertype<Player>("new", sol::no_constructor);
+		bindEntityFields(meta);
+		meta["index"] = sol::property(&getIndex<Player, EntityType::Player>);
+	}
+
+	{
+		auto meta = lua.new_usertype<Human>("new", sol::no_constructor);
+		bindEntityFields(meta);
+		meta["index"] = sol::property(&getIndex<Human, EntityType::Human>);
+		meta["isActive"] = sol::property(&Human::getIsActive);
+	}
+
+	{
+		auto meta = lua.new_usertype<ItemType>("new", sol::no_constructor);
+		bindEntityFields(meta);
+		meta["index"] = sol::property(&getIndex<ItemType, EntityType::ItemType>);
+		meta["name"] = sol::property(&ItemType::getName);
+	}
+
+	{
+		auto meta = lua.new_usertype<Item>("new", sol::no_constructor);
+		bindEntityFields(meta);
+		meta["index"] = sol::property(&getIndex<Item, EntityType::Item>);
+		meta["isActive"] = sol::property(&Item::getIsActive);
+	}
+
+	{
+		auto meta = lua.new_usertype<VehicleType>("new", sol::no_constructor);
+		bindEntityFields(meta);
+		meta["index"] =
+		    sol::property(&getIndex<VehicleType, EntityType::VehicleType>);
+		meta["name"] = sol::property(&VehicleType::getName);
+	}
+
+	{
+		auto meta = lua.new_usertype<Vehicle>("new", sol::no_constructor);
+		bindEntityFields(meta);
+		meta["index"] = sol::property(&getIndex<Vehicle, EntityType::Vehicle>);
+		meta["isActive"] = sol::property(&Vehicle::getIsActive);
+	}
+
+	{
+		auto meta = lua.new_usertype<Bullet>("new", sol::no_constructor);
+		bindEntityFields(meta);
+		meta["index"] = sol::property(&getIndex<Bullet, EntityType::Bullet>);
+	}
+
+	{
+		auto meta = lua.new_usertype<RigidBody>("new", sol::no_constructor);
+		bindEntityFields(meta);
+		meta["index"] = sol::property(&getIndex<RigidBody, EntityType::RigidBody>);
+		meta["isActive"] = sol::property(&RigidBody::getIsActive);
+	}
+
+	{
+		auto meta = lua.new_usertype<TrafficCar>("new", sol::no_constructor);
+		bindEntityFields(meta);
+		meta["index"] =
+		    sol::property(&getIndex<TrafficCar, EntityType::TrafficCar>);
+	}
+}
+
+// Mirrors Hooks::Callbacks, keyed by name without the Post prefix.
+struct HookHandlers {
+	sol::protected_function pre;
+	sol::protected_function post;
+	sol::protected_function preObserver;
+	sol::protected_function postObserver;
+	bool scriptEnabled = false;
+
+	// Like Hooks::updateEnabledKey, a hook only runs at all while it's enabled
+	// or has a handler.
+	bool isEnabled() const {
+		return scriptEnabled || pre.valid() || post.valid() ||
+		       preObserver.valid() || postObserver.valid();
+	}
+};
+
+static std::unordered_map<std::string, HookHandlers> handlers;
+
+static bool isPostName(const std::string& name) {
+	return name.rfind("Post", 0) == 0;
+}
+
+static HookHandlers& getHandlers(const std::string& name) {
+	return handlers[isPostName(name) ? name.substr(4) : name];
+}
+
+static void defineHookTable(sol::state& lua) {
+	auto hookTable = lua["hook"].get_or_create<sol::table>();
+	hookTable["enable"] = [](std::string name) {
+		getHandlers(name).scriptEnabled = true;
+		return true;
+	};
+	hookTable["disable"] = [](std::string name) {
+		getHandlers(name).scriptEnabled = false;
+		return true;
+	};
+	hookTable["clear"] = []() { handlers.clear(); };
+	hookTable["register"] = [](std::string name, sol::protected_function func) {
+		auto& hook = getHandlers(name);
+		(isPostName(name) ? hook.post : hook.pre) = func;
+		return true;
+	};
+	hookTable["observe"] = [](std::string name, sol::protected_function func) {
+		auto& hook = getHandlers(name);
+		(isPostName(name) ? hook.postObserver : hook.preObserver) = func;
+		return true;
+	};
+	hookTable["unregister"] = [](std::string name) {
+		auto& hook = getHandlers(name);
+		bool isPost = isPostName(name);
+		(isPost ? hook.post : hook.pre) = sol::nil;
+		(isPost ? hook.postObserver : hook.preObserver) = sol::nil;
+		return true;
+	};
+	hookTable["setStatsEnabled"] = [](bool) {};
+	hookTable["resetStats"] = []() {};
+}
+
+static void printError(const sol::protected_function_result& result) {
+	sol::error err = result;
+	std::printf("Lua error: %s\n", err.what());
+}
+
+struct ReplayStats {
+	LatencyHistogram ticks;
+	std::map<std::string, LatencyHistogram> hooks;
+	unsigned long long numErrors = 0;
+};
+
+static void replay(sol::state& lua, const std::vector<TraceRecord>& records,
+                   ReplayStats& stats) {
+	sol::protected_function run = lua["hook"]["run"];
+	std::vector<std::pair<sol::protected_function, const TraceRecord*>> observed;
+	std::vector<sol::object> args;
+
+	auto callWithArgs = [&](const sol::protected_function& function,
+	                        const TraceRecord& record, bool passName) {
+		args.clear();
+		for (const auto& arg : record.args) args.push_back(argToObject(lua, arg));
+
+		sol::protected_function_result result =
+		    passName ? function(record.name, sol::as_args(args))
+		             : function(sol::as_args(args));
+		if (!result.valid()) {
+			printError(result);
+			stats.numErrors++;
+		}
+	};
+
+	// Observers run once the tick is over, like they do on the server
+	auto flushObserved = [&]() {
+		for (const auto& [observer, record] : observed)
+			callWithArgs(observer, *record, false);
+		observed.clear();
+	};
+
+	size_t tickStart = 0;
+	while (tickStart < records.size()) {
+		auto tick = records[tickStart].tick;
+		size_t tickEnd = tickStart;
+		while (tickEnd < records.size() && records[tickEnd].tick == tick)
+			tickEnd++;
+
+		{
+			LatencyTimer tickTimer(&stats.ticks);
+			for (size_t i = tickStart; i < tickEnd; i++) {
+				const auto& record = records[i];
+				auto search = handlers.find(record.isPost ? record.name.substr(4)
+				                                          : record.name);
+				if (search == handlers.end() || !search->second.isEnabled()) continue;
+
+				// The same order as Hooks::runPre and Hooks::runPost. Handlers are
+				// copied since the script may clear them while they're running.
+				const auto& hook = search->second;
+				LatencyTimer hookTimer(&stats.hooks[record.name]);
+
+				auto observer = record.isPost ? hook.postObserver : hook.preObserver;
+				if (observer.valid()) observed.emplace_back(observer, &record);
+
+				auto callback = record.isPost ? hook.post : hook.pre;
+				if (callback.valid())
+					callWithArgs(callback, record, false);
+				else if (hook.scriptEnabled && run.valid())
+					callWithArgs(run, record, true);
+			}
+			flushObserved();
+		}
+
+		tickStart = tickEnd;
+	}
+}
+
+static double toMicroseconds(uint64_t nanoseconds) {
+	return nanoseconds / 1000.0;
+}
+
+static void printStats(const ReplayStats& stats) {
+	std::printf("%llu ticks, %llu errors\n",
+	            (unsigned long long)stats.ticks.getCount(), stats.numErrors);
+	std::printf("tick (us): mean %.1f, p50 %.1f, p99 %.1f, max %.1f\n",
+	            stats.ticks.getMean() / 1000.0,
+	            toMicroseconds(stats.ticks.getPercentile(50)),
+	            toMicroseconds(stats.ticks.getPercentile(99)),
+	            toMicroseconds(stats.ticks.getMax()));
+
+	std::vector<std::pair<std::string, const LatencyHistogram*>> hooks;
+	for (const auto& [name, histogram] : stats.hooks)
+		hooks.emplace_back(name, &histogram);
+	std::sort(hooks.begin(), hooks.end(), [](const auto& a, const auto& b) {
+		return a.second->getTotal() > b.second->getTotal();
+	});
+
+	std::printf("%-28s %10s %12s %10s %10s\n", "hook", "calls", "total (us)",
+	            "p50 (us)", "p99 (us)");
+	for (const auto& [name, histogram] : hooks) {
+		std::printf("%-28s %10llu %12.1f %10.1f %10.1f\n", name.c_str(),
+		            (unsigned long long)histogram->getCount(),
+		            toMicroseconds(histogram->getTotal()),
+		            toMicroseconds(histogram->getPercentile(50)),
+		            toMicroseconds(histogram->getPercentile(99)));
+	}
+}
+
+int main(int argc, const char* argv[]) {
+	if (argc < 3) {
+		std::printf("Usage: %s <trace file> <script> [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	const char* traceFileName = argv[1];
+	const char* scriptFileName = argv[2];
+	int iterations = argc > 3 ? std::max(1, atoi(argv[3])) : 1;
+
+	std::vector<TraceRecord> records;
+	try {
+		records = readTrace(traceFileName);
+	} catch (const std::exception& e) {
+		std::printf("%s\n", e.what());
+		return 1;
+	}
+
+	createMirrors();
+
+	sol::state lua;
+
+	lua.open_libraries(sol::lib::base);
+	lua.open_libraries(sol::lib::package);
+	lua.open_libraries(sol::lib::coroutine);
+	lua.open_libraries(sol::lib::string);
+	lua.open_libraries(sol::lib::os);
+	lua.open_libraries(sol::lib::math);
+	lua.open_libraries(sol::lib::table);
+	lua.open_libraries(sol::lib::debug);
+	lua.open_libraries(sol::lib::bit32);
+	lua.open_libraries(sol::lib::io);
+	lua.open_libraries(sol::lib::ffi);
+	lua.open_libraries(sol::lib::jit);
+
+	defineEntityTypes(lua);
+	defineHookTable(lua);
+
+	sol::load_result load = lua.load_file(scriptFileName);
+	if (!load.valid()) {
+		sol::error err = load;
+		std::printf("%s\n", err.what());
+		return 1;
+	}
+
+	sol::protected_function_result res = load();
+	if (!res.valid()) {
+		printError(res);
+		return 1;
+	}
+
+	std::printf("Replaying %zu records, %d time(s)\n", records.size(),
+	            iterations);
+
+	ReplayStats stats;
+	for (int i = 0; i < iterations; i++) replay(lua, records, stats);
+	printStats(stats);
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Binary hook trace format, written by RosaServer and read by
+// RosaServerReplay. Everything is little endian and unaligned.
+//
+// File:    magic "RSHT", uint32 version, then records until EOF
+// Record:  uint32 tick, uint8 isPost, uint8 nameLength, name,
+//          uint8 numArgs, args
+// Arg:     uint8 ArgType, then
+//          Boolean   uint8
+//          Integer   int64
+//          Number    float64
+//          String    uint16 length, bytes
+//          Vector    3 float32
+//          RotMatrix 9 float32
+//          Entity    uint8 EntityType, int32 index, uint8 hasSnapshot,
+//                    [uint32 size, bytes]
+//
+// An entity's snapshot is the raw engine struct, written the first time it is
+// referenced in a tick.
+namespace HookTrace {
+static constexpr char magic[4] = {'R', 'S', 'H', 'T'};
+static constexpr uint32_t version = 1;
+
+enum class ArgType : uint8_t {
+	Nil,
+	Boolean,
+	Integer,
+	Number,
+	String,
+	Vector,
+	RotMatrix,
+	Entity
+};
+
+enum class EntityType : uint8_t {
+	Unknown,
+	Connection,
+	Account,
+	Player,
+	Human,
+	ItemType,
+	Item,
+	VehicleType,
+	Vehicle,
+	Bullet,
+	RigidBody,
+	TrafficCar,
+	Count
+};
+
+class Writer {
+	std::ofstream file;
+
+ public:
+	Writer(const std::string& path) : file(path, std::ios::binary) {
+		if (!file) throw std::runtime_error("Could not open " + path);
+		file.write(magic, sizeof(magic));
+		write(version);
+	}
+
+	template <typename T>
+	void write(const T& value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	void writeBytes(const void* data, size_t size) {
+		file.write(reinterpret_cast<const char*>(data), size);
+	}
+
+	void flush() { file.flush(); }
+};
+
+class Reader {
+	std::vector<char> data;
+	size_t position = 0;
+
+ public:
+	Reader(const std::string& path) {
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file) throw std::runtime_error("Could not open " + path);
+
+		data.resize(file.tellg());
+		file.seekg(0);
+		file.read(data.data(), data.size());
+
+		char fileMagic[sizeof(magic)];
+		readBytes(fileMagic, sizeof(fileMagic));
+		if (std::memcmp(fileMagic, magic, sizeof(magic)) != 0)
+			throw std::runtime_error(path + " is not a hook trace");
+		if (read<uint32_t>() != version)
+			throw std::runtime_error(path + " has an unsupported trace version");
+	}
+
+	bool atEnd() const { return position >= data.size(); }
+
+	void readBytes(void* destination, size_t size) {
+		if (position + size > data.size())
+			throw std::runtime_error("Hook trace is truncated");
+		std::memcpy(destination, data.data() + position, size);
+		position += size;
+	}
+
+	template <typename T>
+	T read() {
+		T value;
+		readBytes(&value, sizeof(T));
+		return value;
+	}
+
+	std::string readString(size_t length) {
+		std::string string(length, '\0');
+		readBytes(string.data(), length);
+		return string;
+	}
+};
+};  // namespace HookTrace
@@ -0,0 +1,46 @@
+-- Benchmark items.each against getAll, which builds a new table every call
+-- Not part of the test suite; run by hand with require('benchmarks.iterators')
+
+local rot = RotMatrix(
+	1, 0, 0,
+	0, 1, 0,
+	0, 0, 1
+)
+local created = {}
+for i = 1, 32 do
+	created[i] = assert(items.create(itemTypes[1], Vector(i, 0, 0), rot))
+end
+
+local iterations = 1000
+
+local function measure (func)
+	collectgarbage()
+	local memoryBefore = collectgarbage('count')
+	local timeBefore = os.realClock()
+	for _ = 1, iterations do
+		func()
+	end
+	return os.realClock() - timeBefore, collectgarbage('count') - memoryBefore
+end
+
+local getAllTime, getAllMemory = measure(function ()
+	for _, item in ipairs(items.getAll()) do
+		local _ = item.pos
+	end
+end)
+
+local eachTime, eachMemory = measure(function ()
+	for item in items.each() do
+		local _ = item.pos
+	end
+end)
+
+print(string.format(
+	'items.getAll: %.2fms %.0fKB, items.each: %.2fms %.0fKB',
+	getAllTime * 1000, getAllMemory,
+	eachTime * 1000, eachMemory
+))
+
+for _, item in ipairs(created) do
+	item:remove()
+end
\ No newline at end of file
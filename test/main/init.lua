@@ -11,9 +11,12 @@ local function runTests ()
 	require('tests.crypto')
 	require('tests.events')
 	require('tests.fileWatcher')
+	require('tests.hook')
 	require('tests.http')
+	require('tests.httpServer')
 	require('tests.humans')
 	require('tests.image')
+	require('tests.iterators')
 	require('tests.items')
 	require('tests.itemTypes')
 	require('tests.memory')
@@ -23,11 +26,16 @@ local function runTests ()
 	require('tests.rigidBodies')
 	require('tests.rotMatrix')
 	require('tests.server')
+	require('tests.spatial')
 	require('tests.sqlite')
 	require('tests.streets')
+	require('tests.tcpServer')
+	require('tests.tickProfiler')
 	require('tests.vector')
 	require('tests.vehicles')
 	require('tests.worker')
+	require('tests.world')
+	require('tests.worldDelta')
 	require('tests.zlib')
 end
 
@@ -48,8 +56,13 @@ local handlers = {}
 
 local tick = 0
 
+-- How many times each event has reached hook.run
+hookRunCounts = {}
+
 hook.enable('Logic')
 function hook.run (event, ...)
+	hookRunCounts[event] = (hookRunCounts[event] or 0) + 1
+
 	if event == 'Logic' then
 		tick = tick + 1
 
@@ -6,4 +6,6 @@ assert(#accounts.getAll() == 0)
 assert(accounts.getCount() == 0)
 assert(#accounts == 0)
 
-assert(not accounts.getByPhone(0))
\ No newline at end of file
+assert(not accounts.getByPhone(0))
+assert(not accounts.getBySteamID('76561197960287930'))
+assert(not accounts.getByName('Nobody'))
\ No newline at end of file
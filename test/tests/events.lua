@@ -20,4 +20,26 @@ end)
 
 assertAddsEvent(function ()
 	assert(events.createExplosion(Vector()))
-end)
\ No newline at end of file
+end)
+
+do
+	local cursor = EventCursor()
+	assert(#cursor:poll() == 0)
+
+	local message = assert(events.createMessage(0, 'Cursor', -1, 0))
+	local sound = assert(events.createSound(0, Vector()))
+
+	local newEvents = cursor:poll()
+	assert(#newEvents == 2)
+	assert(newEvents[1] == message)
+	assert(newEvents[2] == sound)
+	assert(#cursor:poll(newEvents) == 0)
+	assert(newEvents[1] == nil)
+
+	local messages = EventCursor({ message.type })
+	events.createSound(0, Vector())
+	events.createMessage(0, 'Filtered', -1, 0)
+	local filtered = messages:poll()
+	assert(#filtered == 1)
+	assert(filtered[1].message == 'Filtered')
+end
\ No newline at end of file
@@ -0,0 +1,117 @@
+do
+	local stats = hook.getTrampolineStats()
+	local logic = assert(stats.logicSimulation)
+	assert(type(logic.hasTrampoline) == 'boolean')
+	assert(logic.trampolineCalls + logic.removeCalls > 0)
+end
+
+do
+	local function noop () end
+	assert(hook.register('PostAccountsSave', noop))
+	assert(not hook.register('NotAHook', noop))
+	assert(hook.unregister('PostAccountsSave'))
+	assert(not hook.unregister('NotAHook'))
+end
+
+do
+	hook.resetStats()
+	hook.setStatsEnabled(true)
+	physics.lineIntersectLevel(Vector(0, 20, 0), Vector(0, 0, 0), false)
+	hook.setStatsEnabled(false)
+
+	local stats = hook.getStats()
+	assert(not stats.enabled)
+	local original = assert(stats.originals.lineIntersectLevel)
+	assert(original.count == 1)
+	assert(original.p50 <= original.max)
+	hook.resetStats()
+end
+
+do
+	assert(hook.getTrampolineStats().logicSimulation.installed)
+
+	hook.enable('EconomyCarMarket')
+	assert(hook.getTrampolineStats().economyCarMarket.installed)
+	hook.disable('EconomyCarMarket')
+	assert(not hook.getTrampolineStats().economyCarMarket.installed)
+end
+
+do
+	local numObserved = 0
+	assert(hook.observe('PostPhysics', function ()
+		numObserved = numObserved + 1
+	end))
+
+	nextTick(function ()
+		assert(numObserved > 0)
+		-- Observing doesn't send either side through hook.run
+		assert(not hookRunCounts.Physics)
+		assert(not hookRunCounts.PostPhysics)
+		assert(hook.unregister('PostPhysics'))
+		hook.disable('Physics')
+	end, 2)
+end
+
+do
+	-- With only a pre handler, the post side does nothing at all
+	local numCalls = 0
+	assert(hook.register('ServerReceive', function ()
+		numCalls = numCalls + 1
+	end))
+
+	nextTick(function ()
+		assert(numCalls > 0)
+		assert(not hookRunCounts.ServerReceive)
+		assert(not hookRunCounts.PostServerReceive)
+		assert(hook.unregister('ServerReceive'))
+	end, 2)
+end
+
+do
+	-- The runner gets Logic through hook.run, which a native PostLogic handler
+	-- mustn't take away, and removing it mustn't disable the key either
+	local numObserved = 0
+	assert(hook.observe('PostLogic', function ()
+		numObserved = numObserved + 1
+	end))
+
+	nextTick(function ()
+		assert(numObserved > 0)
+		assert(hook.unregister('PostLogic'))
+		nextTick(function () end)
+	end)
+end
+
+do
+	-- Each serverSend builds every connection's packet, so there's one batch
+	-- before each PostServerSend
+	local numSends = 0
+	local numBatches = 0
+	assert(hook.register('PacketBuildingBatch', function (list)
+		assert(type(list) == 'table')
+		for _, connection in ipairs(list) do
+			assert(connection.class == 'Connection')
+		end
+		numBatches = numBatches + 1
+	end))
+	assert(hook.register('PostServerSend', function ()
+		numSends = numSends + 1
+		assert(numBatches == numSends)
+	end))
+
+	nextTick(function ()
+		assert(numSends > 0)
+		assert(numBatches == numSends)
+		assert(hook.unregister('PacketBuildingBatch'))
+		assert(hook.unregister('PostServerSend'))
+	end, 2)
+end
+
+do
+	local path = os.tmpname()
+	hook.startTrace(path)
+	assert(not pcall(hook.startTrace, path))
+	assert(hook.stopTrace() >= 0)
+	assert(not pcall(hook.stopTrace))
+	os.remove(path)
+end
\ No newline at end of file
@@ -11,4 +11,38 @@ for k, v in pairs(res.headers) do
 		break
 	end
 end
-assert(foundContentType)
\ No newline at end of file
+assert(foundContentType)
+
+local poolStats = http.getPoolStats()
+assert(poolStats.idle >= 1)
+assert(http.getSync('https://github.com', '/robots.txt', {}))
+assert(http.getPoolStats().hits == poolStats.hits + 1)
+
+local cancelledID = assert(http.get('https://github.com', '/robots.txt', {}, function ()
+	error('cancelled request called back')
+end))
+assert(http.cancel(cancelledID))
+assert(not http.cancel(cancelledID))
+
+local asyncResponse
+assert(http.get('https://github.com', '/robots.txt', {}, function (res)
+	asyncResponse = assert(res)
+end, { timeout = 10 }))
+assert(http.getPending() >= 1)
+
+local maxTicks = 600
+local ticks = 0
+
+local function try ()
+	ticks = ticks + 1
+
+	if asyncResponse then
+		assert(asyncResponse.status >= 200 and asyncResponse.status <= 299)
+		assert(asyncResponse.body:find('Disallow'))
+	else
+		assert(ticks < maxTicks)
+		nextTick(try)
+	end
+end
+
+nextTick(try)
\ No newline at end of file
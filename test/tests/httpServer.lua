@@ -0,0 +1,48 @@
+local server = HTTPServer.new(28080)
+assert(server.isOpen)
+assert(server.port == 28080)
+assert(not server:receive())
+
+server:setCached('/cached', 200, 'from cache', 'text/plain')
+
+local cachedResponse, luaResponse
+assert(http.get('http://127.0.0.1:28080', '/cached', {}, function (res)
+	cachedResponse = assert(res)
+end))
+assert(http.get('http://127.0.0.1:28080', '/lua?name=test', {}, function (res)
+	luaResponse = assert(res)
+end))
+
+local maxTicks = 600
+local ticks = 0
+
+local function try ()
+	ticks = ticks + 1
+
+	while true do
+		local req = server:receive()
+		if not req then break end
+
+		assert(req.method == 'GET')
+		assert(req.path == '/lua')
+		assert(req:getParams().name == 'test')
+		req:respond(201, 'from lua', 'text/plain')
+		assert(req.responded)
+	end
+
+	if cachedResponse and luaResponse then
+		assert(cachedResponse.status == 200)
+		assert(cachedResponse.body == 'from cache')
+		assert(luaResponse.status == 201)
+		assert(luaResponse.body == 'from lua')
+
+		assert(server:removeCached('/cached'))
+		server:close()
+		assert(not server.isOpen)
+	else
+		assert(ticks < maxTicks)
+		nextTick(try)
+	end
+end
+
+nextTick(try)
\ No newline at end of file
@@ -6,4 +6,23 @@ assert(#itemTypes == expectedNum)
 assert(itemTypes[0])
 
 itemTypes[0].price = 420
-assert(itemTypes[0].price == 420)
\ No newline at end of file
+assert(itemTypes[0].price == 420)
+
+do
+	local type = itemTypes[0]
+	local name = type.name
+	assert(itemTypes.getByName(name) == type)
+	assert(itemTypes.getByName(name:upper(), true) == type)
+
+	type.name = 'Lookup Test'
+	assert(itemTypes.getByName('Lookup Test') == type)
+	assert(not itemTypes.getByName('lookup test'))
+	assert(itemTypes.getByName('lookup test', true) == type)
+
+	local matches = itemTypes.findByPrefix('LOOKUP')
+	assert(#matches == 1)
+	assert(matches[1] == type)
+
+	type.name = name
+	assert(not itemTypes.getByName('Lookup Test'))
+end
\ No newline at end of file
@@ -60,6 +60,10 @@ item:computerSetLine(0, 'hello')
 item:computerSetColor(0, 0, 0xFF)
 item:computerTransmitLine(0)
 
+assert(items.getCount() == 1)
+assert(items.getAll()[1].index == item.index)
+
 item:remove()
 
+assert(items.getCount() == 0)
 assert(#items == 0)
\ No newline at end of file
@@ -0,0 +1,34 @@
+local rot = RotMatrix(
+	1, 0, 0,
+	0, 1, 0,
+	0, 0, 1
+)
+
+local created = {}
+for i = 1, 32 do
+	created[i] = assert(items.create(itemTypes[1], Vector(i, 0, 0), rot))
+end
+
+do
+	local all = items.getAll()
+	assert(#all == 32)
+	local i = 0
+	for item in items.each() do
+		i = i + 1
+		assert(item.index == all[i].index)
+	end
+	assert(i == #all)
+end
+
+for _ in players.eachNonBot() do
+	error('There should be no players')
+end
+
+for _ in vehicles.eachTraffic() do
+	error('There should be no traffic vehicles')
+end
+
+for _, item in ipairs(created) do
+	item:remove()
+end
+assert(items.getCount() == 0)
\ No newline at end of file
@@ -30,6 +30,7 @@ assert(memory.getAddress(players[2]) == memory.getAddress(players[1]) + sizeOfPl
 local item = items[0]
 assert(not item.isActive)
 local address = memory.getAddress(items[0])
+local itemCount = items.getCount()
 
 for _, func in ipairs({
 	'writeByte',
@@ -44,7 +45,9 @@ for _, func in ipairs({
 }) do
 	memory[func](address, 1)
 	assert(item.isActive)
+	assert(items.getCount() == itemCount + 1)
 	item.isActive = false
+	assert(items.getCount() == itemCount)
 end
 
 assert(not item.hasPhysics)
@@ -54,9 +57,46 @@ assert(item.hasPhysics)
 
 memory.writeBytes(address, '\1\0\0\0\0\0\0\0')
 assert(item.isActive)
+assert(items.getCount() == itemCount + 1)
 assert(not item.hasPhysics)
 memory.writeBytes(address, '\1\0\0\0\1\0\0\0')
 assert(item.hasPhysics)
 
 item.isActive = false
-item.hasPhysics = false
\ No newline at end of file
+item.hasPhysics = false
+
+do
+	local ffi = require('ffi')
+	local human = humans[0]
+	local ffiHumans = assert(memory.ffi).humans
+	local ffiHuman = ffiHumans[0]
+
+	assert(tonumber(ffi.cast('uintptr_t', ffiHumans)) == memory.getAddress(human))
+	assert(ffi.sizeof('Human') == memory.getAddress(humans[1]) - memory.getAddress(human))
+
+	human.despawnTime = 1234
+	assert(ffiHuman.despawnTime == 1234)
+	ffiHuman.despawnTime = 0
+	assert(human.despawnTime == 0)
+end
+
+do
+	local ffiVector = memory.ffi.Vector
+	local a = ffiVector(1, 2, 3)
+	a:addInPlace(ffiVector(1, 1, 1)):multInPlace(2)
+	assert(a.x == 4 and a.y == 6 and a.z == 8)
+
+	local vector = Vector(1, 2, 3)
+	local view = memory.ffi.vectorOf(vector)
+	view:lerpInto(a, 0.5, view)
+	assert(vector == Vector(2.5, 4, 5.5))
+
+	local rot = RotMatrix(
+		0, 0, 1,
+		0, 1, 0,
+		-1, 0, 0
+	)
+	memory.ffi.vectorOf(vector):set(ffiVector(1, 2, 3))
+		:rotateInPlace(memory.ffi.rotMatrixOf(rot))
+	assert(vector == Vector(3, 2, -1))
+end
\ No newline at end of file
@@ -130,4 +130,74 @@ assert(not physics.lineIntersectTriangle(
 ))
 
 physics.garbageCollectBullets()
-assert(bullets.getCount() == 0)
\ No newline at end of file
+assert(bullets.getCount() == 0)
+do
+	local out = {}
+	local ray = physics.lineIntersectLevel(
+		Vector(0, airLevel, 0),
+		Vector(0, 0, 0),
+		false,
+		out
+	)
+
+	assert(ray == out)
+	assert(ray.hit)
+	local pos = ray.pos
+
+	physics.lineIntersectLevel(Vector(1, airLevel, 0), Vector(1, 0, 0), false, out)
+	assert(out.hit)
+	assert(rawequal(out.pos, pos))
+	assert(pos.x == 1)
+end
+
+do
+	physics.resetBroadPhaseStats()
+	local stats = physics.getBroadPhaseStats()
+	assert(stats.tested == 0)
+	assert(stats.culled == 0)
+
+	local vehicle = assert(vehicles.create(
+		vehicleTypes[0],
+		Vector(1000, airLevel, 1000),
+		RotMatrix(
+			1, 0, 0,
+			0, 1, 0,
+			0, 0, 1
+		),
+		0
+	))
+
+	local object = physics.lineIntersectAnyQuick(
+		Vector(0, airLevel + 10, 0),
+		Vector(0, airLevel - 10, 0),
+		nil,
+		0.0,
+		false
+	)
+	assert(object == nil)
+
+	stats = physics.getBroadPhaseStats()
+	assert(stats.culled >= 1)
+	assert(stats.tested + stats.culled == humans.getCount() + vehicles.getCount())
+
+	vehicle:remove()
+end
+
+do
+	local rays = {
+		{ Vector(0, airLevel, 0), Vector(0, 0, 0) },
+		{ Vector(0, airLevel, 0), Vector(0, airLevel + 10, 0) },
+	}
+	local results = physics.raycastBatch(rays, physics.RAY_LEVEL)
+	assert(#results == 2)
+	assert(results[1].hit)
+	assert(results[1].fraction == 0.5)
+	assert(results[1].object == nil)
+	assert(not results[2].hit)
+
+	local first = results[1]
+	rays[2] = nil
+	assert(physics.raycastBatch(rays, physics.RAY_LEVEL, results) == results)
+	assert(rawequal(results[1], first))
+	assert(#results == 1)
+end
\ No newline at end of file
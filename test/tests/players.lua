@@ -13,6 +13,13 @@ assert(bot.phoneNumber == testPhone)
 
 assert(players[0] == bot)
 assert(players.getByPhone(testPhone) == bot)
+assert(players.getByName('Bot') == bot)
+bot.name = 'Lookup'
+assert(players.getByName('Lookup') == bot)
+assert(not players.getByName('Bot'))
+bot.phoneNumber = testPhone + 1
+assert(not players.getByPhone(testPhone))
+assert(players.getByPhone(testPhone + 1) == bot)
 assert(#players.getNonBots() == 0)
 assert(players.getCount() == 1)
 assert(#players == 1)
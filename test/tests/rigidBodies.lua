@@ -19,6 +19,7 @@ local vehicle = assert(vehicles.create(
 ))
 
 assert(body.isActive)
+assert(rigidBodies.getCount() > 0)
 
 body.mass = 420
 assert(body.mass == 420)
@@ -31,4 +32,5 @@ assert(body:bondToLevel(Vector(), Vector())).isActive = false
 
 vehicle:remove()
 
-assert(not body.isActive)
\ No newline at end of file
+assert(not body.isActive)
+assert(rigidBodies.getCount() == 0)
\ No newline at end of file
@@ -0,0 +1,62 @@
+local rot = RotMatrix(
+	1, 0, 0,
+	0, 1, 0,
+	0, 0, 1
+)
+
+local near = assert(items.create(itemTypes[1], Vector(1000, 10, 1000), rot))
+local far = assert(items.create(itemTypes[1], Vector(1100, 10, 1000), rot))
+
+do
+	local found = {}
+	for item, distance in spatial.queryRadius(Vector(1000, 10, 1000), 10, spatial.ITEMS) do
+		assert(item.class == 'Item')
+		found[item.index] = distance
+	end
+	assert(found[near.index] == 0)
+	assert(not found[far.index])
+end
+
+do
+	local query = spatial.nearest(Vector(1090, 10, 1000), spatial.ITEMS, 1)
+	assert(query.count == 1)
+	for item, distance in query do
+		assert(item.index == far.index)
+		assert(distance == 10)
+	end
+end
+
+do
+	local count = 0
+	for _ in spatial.queryBox(Vector(990, 0, 990), Vector(1110, 20, 1010), spatial.ITEMS) do
+		count = count + 1
+	end
+	assert(count == 2)
+end
+
+for body in spatial.queryRadius(Vector(1000, 10, 1000), 10, spatial.RIGID_BODIES) do
+	assert(body.class == 'RigidBody')
+end
+
+do
+	-- Created and removed within the tick, before physics refreshes the hash
+	local new = assert(items.create(itemTypes[1], Vector(1200, 10, 1000), rot))
+	local query = spatial.nearest(Vector(1200, 10, 1000), spatial.ITEMS, 1)
+	for item in query do
+		assert(item.index == new.index)
+	end
+
+	new:remove()
+	for item in spatial.queryRadius(Vector(1200, 10, 1000), 10, spatial.ITEMS) do
+		assert(item.index ~= new.index)
+	end
+
+	query = spatial.nearest(Vector(1200, 10, 1000), spatial.ITEMS, 1)
+	assert(query.count == 1)
+	for item in query do
+		assert(item.index == far.index)
+	end
+end
+
+near:remove()
+far:remove()
\ No newline at end of file
@@ -0,0 +1,80 @@
+local server = TCPServer.new(28081)
+assert(server.isOpen)
+
+local poll = server:poll()
+assert(#poll.accepted == 0)
+assert(#poll.readable == 0)
+assert(#poll.closed == 0)
+
+-- An HTTP client is the simplest way to open a loopback connection
+local response
+assert(http.get('http://127.0.0.1:28081', '/poll', {}, function (res)
+	response = assert(res)
+end))
+
+local connection
+local request = ''
+local wasAccepted, wasReadable, wasClosed, sentAfterResponse
+
+local maxTicks = 600
+local ticks = 0
+
+local function try ()
+	ticks = ticks + 1
+
+	poll = server:poll()
+
+	for _, accepted in ipairs(poll.accepted) do
+		assert(not connection)
+		connection = accepted
+		wasAccepted = true
+	end
+
+	for _, readable in ipairs(poll.readable) do
+		assert(readable.port == connection.port)
+		wasReadable = true
+
+		if not request:find('\r\n\r\n', 1, true) then
+			local data = readable:receive()
+			if data then request = request .. data end
+
+			if request:find('\r\n\r\n', 1, true) then
+				assert(request:sub(1, 10) == 'GET /poll ')
+				readable:send(
+					'HTTP/1.1 200 OK\r\n' ..
+					'Content-Length: 4\r\n' ..
+					'Connection: close\r\n\r\n' ..
+					'poll'
+				)
+			end
+		end
+	end
+
+	for _, closed in ipairs(poll.closed) do
+		assert(closed.port == connection.port)
+		assert(not closed.isOpen)
+		wasClosed = true
+	end
+
+	-- The client hangs up after the response, and writing to it then gets the
+	-- connection reset
+	if response and not sentAfterResponse and connection.isOpen then
+		assert(response.status == 200)
+		assert(response.body == 'poll')
+		connection:send('x')
+		sentAfterResponse = true
+	end
+
+	if wasClosed then
+		assert(wasAccepted)
+		assert(wasReadable)
+		assert(sentAfterResponse)
+		server:close()
+		assert(not server.isOpen)
+	else
+		assert(ticks < maxTicks)
+		nextTick(try)
+	end
+end
+
+nextTick(try)
\ No newline at end of file
@@ -0,0 +1,30 @@
+tickProfiler.setEnabled(true)
+
+assert(not pcall(tickProfiler.setBudget, 0))
+tickProfiler.setBudget(1000)
+assert(tickProfiler.getBudget() == 1000)
+
+tickProfiler.setCapacity(4)
+assert(#tickProfiler.getTicks() == 0)
+assert(tickProfiler.getStats().ticks == 0)
+
+nextTick(function ()
+	local ticks = tickProfiler.getTicks()
+	assert(#ticks >= 1)
+
+	local tick = ticks[#ticks]
+	assert(tick.total >= tick.logicSimulation)
+	assert(tick.physicsSimulation >= 0)
+	assert(tick.httpCallbacks >= 0)
+	assert(tick.observers >= 0)
+
+	local stats = tickProfiler.getStats()
+	assert(stats.ticks == #ticks)
+	assert(stats.overBudget == 0)
+	assert(stats.total.p50 <= stats.total.max)
+	assert(stats.phases.logicSimulation.max >= 0)
+
+	tickProfiler.setBudget(1000 / server.TPS)
+	tickProfiler.setCapacity(600)
+	tickProfiler.setEnabled(false)
+end, 3)
\ No newline at end of file
@@ -46,3 +46,14 @@ local ninetyDegreesClockwise = RotMatrix(
 local rotated = vector * ninetyDegreesClockwise
 assert(rotated:dist(Vector(3, 2, -1)) == 0)
 assert(Vector(1, 2, 3) == Vector(1, 2, 3))
+
+local inPlace = Vector(1, 2, 3)
+inPlace:addInPlace(Vector(1, 1, 1))
+inPlace:subInPlace(Vector(1, 1, 1))
+assert(inPlace == Vector(1, 2, 3))
+inPlace:rotateInPlace(ninetyDegreesClockwise)
+assert(inPlace == rotated)
+
+local lerped = Vector()
+Vector(0, 0, 0):lerpInto(Vector(2, 4, 6), 0.5, lerped)
+assert(lerped == Vector(1, 2, 3))
\ No newline at end of file
@@ -0,0 +1,24 @@
+local path = 'snapshot.rsws'
+
+local item = assert(items.create(itemTypes[1], Vector(3000, 10, 3000), RotMatrix(
+	1, 0, 0,
+	0, 1, 0,
+	0, 0, 1
+)))
+item.data.saved = true
+local count = items.getCount()
+
+world.saveSnapshot(path)
+item:remove()
+assert(items.getCount() == count - 1)
+
+world.loadSnapshot(path)
+assert(item.isActive)
+assert(item.pos:dist(Vector(3000, 10, 3000)) == 0)
+assert(items.getCount() == count)
+assert(item.data.saved == nil)
+
+item:remove()
+assert(os.remove(path))
+
+assert(not pcall(world.loadSnapshot, path))
\ No newline at end of file
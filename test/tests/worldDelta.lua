@@ -0,0 +1,67 @@
+local fieldCounts = { [0] = 7, 9, 8, 8 }
+local ITEMS = 3
+
+local function readUInt (data, offset, size)
+	local value = 0
+	for i = size, 1, -1 do
+		value = value * 256 + data:byte(offset + i - 1)
+	end
+	return value
+end
+
+local function parseDelta (delta)
+	local records = {}
+	local offset = 9
+	for _ = 1, readUInt(delta, 5, 4) do
+		local kind = delta:byte(offset)
+		local index = readUInt(delta, offset + 1, 2)
+		local mask = readUInt(delta, offset + 3, 2)
+		offset = offset + 5
+
+		for bit = 0, fieldCounts[kind] - 1 do
+			if mask % 2 ^ (bit + 1) >= 2 ^ bit then
+				offset = offset + 4
+			end
+		end
+
+		table.insert(records, { kind = kind, index = index, mask = mask })
+	end
+	assert(offset == #delta + 1)
+	return records
+end
+
+local function findRecord (records, kind, index)
+	for _, record in ipairs(records) do
+		if record.kind == kind and record.index == index then
+			return record
+		end
+	end
+end
+
+worldDelta.setEnabled(true)
+assert(worldDelta.getQueued() == 0)
+
+local item = assert(items.create(itemTypes[1], Vector(2000, 10, 2000), RotMatrix(
+	1, 0, 0,
+	0, 1, 0,
+	0, 0, 1
+)))
+local itemIndex = item.index
+
+nextTick(function ()
+	local records = parseDelta(assert(worldDelta.receive()))
+	local record = assert(findRecord(records, ITEMS, itemIndex))
+	assert(record.mask == 2 ^ fieldCounts[ITEMS] - 1)
+
+	item:remove()
+
+	nextTick(function ()
+		local records = parseDelta(assert(worldDelta.receive()))
+		local record = assert(findRecord(records, ITEMS, itemIndex))
+		assert(record.mask == 0)
+
+		worldDelta.setEnabled(false)
+		worldDelta.reset()
+		assert(worldDelta.getQueued() == 0)
+	end)
+end)
\ No newline at end of file